@@ -0,0 +1,287 @@
+/**
+ * @file   http_load_bench.cpp
+ * @brief  A load-test client for `asset_id --serve`, reporting latency percentiles and the
+ *         request rate.
+ *
+ * Usage: asset_id_http_bench [--connections N] [--requests N] [ADDRESS]
+ *
+ * Every connection is kept alive and driven by its own thread, which sends one request at a
+ * time for a pseudo random id and waits for the whole response before sending the next. With
+ * no ADDRESS a server is started in process on a free loopback port; otherwise ADDRESS is
+ * `HOST:PORT` or the path of a unix socket, as accepted by `--serve`. N defaults to 4
+ * connections and 100000 requests per connection.
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "http_server.h"
+#include "id_table.h"
+
+using namespace asset_id;
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+int connect_to(listen_address const& address)
+{
+    if (!address.unix_path.empty())
+    {
+        auto socket_address = sockaddr_un{};
+        socket_address.sun_family = AF_UNIX;
+        address.unix_path.copy(socket_address.sun_path, sizeof(socket_address.sun_path) - 1U);
+
+        auto const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        auto const* const generic = reinterpret_cast<sockaddr const*>(&socket_address);
+        if ((fd >= 0) && (connect(fd, generic, sizeof(socket_address)) != 0))
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    auto socket_address = sockaddr_in{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(address.port);
+    auto const host = (address.host.empty() || (address.host == "localhost")) ? "127.0.0.1"
+                                                                               : address.host;
+    if (inet_pton(AF_INET, host.c_str(), &socket_address.sin_addr) != 1)
+    {
+        return -1;
+    }
+
+    auto const fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    auto const* const generic = reinterpret_cast<sockaddr const*>(&socket_address);
+    if ((fd >= 0) && (connect(fd, generic, sizeof(socket_address)) != 0))
+    {
+        close(fd);
+        return -1;
+    }
+
+    auto const enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return fd;
+}
+
+/**
+ * @brief Read one complete response from `fd`, leaving any bytes beyond it in `buffer`.
+ *
+ * @return true   if a `200 OK` response was read.
+ * @return false  otherwise.
+ */
+bool read_response(int const fd, std::string& buffer)
+{
+    constexpr auto const header_terminator = std::string_view{"\r\n\r\n"};
+    constexpr auto const length_header = std::string_view{"Content-Length: "};
+
+    char chunk[4096];
+    while (true)
+    {
+        auto const received = std::string_view{buffer};
+        auto const head_end = received.find(header_terminator);
+        if (head_end != std::string_view::npos)
+        {
+            auto const length_start = received.find(length_header);
+            auto content_length = std::size_t{0U};
+            if ((length_start != std::string_view::npos) && (length_start < head_end))
+            {
+                auto const* const digits = received.data() + length_start + length_header.size();
+                std::from_chars(digits, received.data() + head_end, content_length);
+            }
+
+            auto const total = head_end + header_terminator.size() + content_length;
+            if (received.size() >= total)
+            {
+                auto const ok = received.substr(0U, 12U) == "HTTP/1.1 200";
+                buffer.erase(0U, total);
+                return ok;
+            }
+        }
+
+        auto const num_read = recv(fd, chunk, sizeof(chunk), 0);
+        if (num_read <= 0)
+        {
+            return false;
+        }
+        buffer.append(chunk, static_cast<std::size_t>(num_read));
+    }
+}
+
+/**
+ * @brief Send `num_requests` requests over a single connection, recording the latency of each
+ * in nanoseconds.
+ *
+ * @return std::size_t holding the number of requests that failed.
+ */
+std::size_t run_connection(
+    listen_address const& address,
+    unsigned seed,
+    std::size_t num_requests,
+    std::vector<std::uint64_t>& latencies
+)
+{
+    auto const fd = connect_to(address);
+    if (fd < 0)
+    {
+        return num_requests;
+    }
+
+    auto request = std::string{"GET /0000.png HTTP/1.1\r\nHost: bench\r\n\r\n"};
+    auto buffer = std::string{};
+    auto state = seed | 1U;
+    auto failures = std::size_t{0U};
+
+    latencies.reserve(num_requests);
+    for (auto index = std::size_t{0U}; index < num_requests; ++index)
+    {
+        // xorshift; the ids only need to be spread over the whole table, not be unpredictable.
+        state ^= state << 13U;
+        state ^= state >> 17U;
+        state ^= state << 5U;
+        auto id = state % num_asset_ids();
+        for (auto position = std::size_t{8U}; position >= 5U; --position, id /= 10U)
+        {
+            request[position] = static_cast<char>('0' + id % 10U);
+        }
+
+        auto const start = clock_type::now();
+        auto const sent = send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        if ((sent != static_cast<ssize_t>(request.size())) || !read_response(fd, buffer))
+        {
+            failures += num_requests - index;
+            break;
+        }
+        auto const elapsed = clock_type::now() - start;
+
+        latencies.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    close(fd);
+    return failures;
+}
+
+double percentile_us(std::vector<std::uint64_t> const& sorted, double const fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    auto const last = static_cast<double>(sorted.size() - 1U);
+    auto const index = static_cast<std::size_t>(fraction * last);
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto num_connections = 4U;
+    auto num_requests = std::size_t{100000U};
+    auto address = std::optional<listen_address>{};
+
+    for (auto index = 1; index < argc; ++index)
+    {
+        auto const argument = std::string_view{argv[index]};
+        if (((argument == "--connections") || (argument == "--requests")) && (index + 1 < argc))
+        {
+            auto const value = std::strtoul(argv[++index], nullptr, 10);
+            if (value == 0U)
+            {
+                std::cerr << "Option '" << argument << "' requires a positive integer.\n";
+                return EXIT_FAILURE;
+            }
+            if (argument == "--connections")
+            {
+                num_connections = static_cast<unsigned>(value);
+            }
+            else
+            {
+                num_requests = value;
+            }
+            continue;
+        }
+
+        address = parse_listen_address(argument);
+        if (!address)
+        {
+            std::cerr << "Unsupported address '" << argument << "'.\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Without an address the server runs in process, on its own thread, over loopback.
+    auto server = std::unique_ptr<http_server>{};
+    auto server_thread = std::thread{};
+    if (!address)
+    {
+        server = http_server::open({"127.0.0.1", 0U, ""});
+        if (!server)
+        {
+            std::cerr << "Cannot start a server on loopback.\n";
+            return EXIT_FAILURE;
+        }
+        address = listen_address{"127.0.0.1", server->port(), ""};
+        server_thread = std::thread{[&server]() { server->run(); }};
+    }
+
+    std::vector<std::vector<std::uint64_t>> latencies(num_connections);
+    std::vector<std::size_t> failures(num_connections, 0U);
+
+    auto const start = clock_type::now();
+    {
+        std::vector<std::thread> clients{};
+        for (auto client = 0U; client < num_connections; ++client)
+        {
+            clients.emplace_back([&, client]() {
+                failures[client] =
+                    run_connection(*address, 2463534242U + client, num_requests, latencies[client]);
+            });
+        }
+        for (auto& client: clients)
+        {
+            client.join();
+        }
+    }
+    auto const seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    if (server)
+    {
+        server->stop();
+        server_thread.join();
+    }
+
+    auto all = std::vector<std::uint64_t>{};
+    auto total_failures = std::size_t{0U};
+    for (auto client = 0U; client < num_connections; ++client)
+    {
+        all.insert(all.end(), latencies[client].begin(), latencies[client].end());
+        total_failures += failures[client];
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << "connections\trequests\tfailures\tp50 us\tp99 us\tmax us\treq/s\n";
+    std::cout << num_connections << "\t" << all.size() << "\t" << total_failures << "\t"
+              << percentile_us(all, 0.50) << "\t" << percentile_us(all, 0.99) << "\t"
+              << percentile_us(all, 1.0) << "\t" << static_cast<double>(all.size()) / seconds
+              << "\n";
+
+    return (total_failures == 0U) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
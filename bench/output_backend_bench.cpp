@@ -0,0 +1,212 @@
+/**
+ * @file   output_backend_bench.cpp
+ * @brief  Compares the direct and io_uring output backends writing the same set of png files.
+ *
+ * Both backends replace each file atomically, staging it under a temporary name or as an
+ * anonymous `O_TMPFILE` and then linking or renaming it into place, so they are compared under
+ * the same guarantee.
+ *
+ * Usage: asset_id_output_bench [NUM_FILES] [DIR...]
+ *
+ * Each directory is benchmarked in turn; by default these are a directory on tmpfs
+ * (`/dev/shm`) and one on the filesystem holding the current directory, which is typically
+ * ext4. Every run writes NUM_FILES (default 10000) distinct files into a fresh sub-directory,
+ * once while it is empty and once after it has been filled with the same files, as a rerun of
+ * the tool would find it.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "output_sink.h"
+#include "uring_sink.h"
+
+using namespace asset_id;
+
+namespace
+{
+constexpr auto const num_repeats = 5U;
+
+/**
+ * @brief Write every item through `sink` in chunks of the size used by the tool itself.
+ *
+ * @return double holding the elapsed time in seconds, or a negative value if any file failed.
+ */
+double time_sink(output_sink& sink, std::vector<output_item>& items)
+{
+    constexpr auto const chunk_num_items = std::size_t{4096U};
+
+    auto const start = std::chrono::steady_clock::now();
+    for (auto offset = std::size_t{0U}; offset < items.size(); offset += chunk_num_items)
+    {
+        auto const count = std::min(chunk_num_items, items.size() - offset);
+        sink.write(items.data() + offset, count);
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    for (auto const& item: items)
+    {
+        if (!item.written)
+        {
+            return -1.0;
+        }
+    }
+
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+/**
+ * @brief Empty `run_dir`, then, if `overwrite` is set, fill it with the files of `items`.
+ */
+void prepare_run_dir(
+    std::filesystem::path const& run_dir, std::vector<output_item>& items, bool const overwrite
+)
+{
+    std::filesystem::remove_all(run_dir);
+    std::filesystem::create_directories(run_dir);
+
+    if (overwrite)
+    {
+        auto sink = directory_sink{run_dir, png_backend::builtin};
+        time_sink(sink, items);
+    }
+
+    for (auto& item: items)
+    {
+        item.written = false;
+    }
+}
+
+/**
+ * @brief Time writing `items` into `run_dir` through the sinks made by `make_sink`.
+ *
+ * @return double holding the best time of `num_repeats` runs in seconds, negative if any run
+ *         failed; std::nullopt if `make_sink` returns no sink.
+ */
+std::optional<double> time_backend(
+    std::filesystem::path const& run_dir,
+    std::vector<output_item>& items,
+    bool const overwrite,
+    std::function<std::unique_ptr<output_sink>()> const& make_sink
+)
+{
+    auto best = -1.0;
+    for (auto repeat = 0U; repeat < num_repeats; ++repeat)
+    {
+        prepare_run_dir(run_dir, items, overwrite);
+
+        auto const sink = make_sink();
+        if (!sink)
+        {
+            return std::nullopt;
+        }
+
+        auto const seconds = time_sink(*sink, items);
+        if (seconds < 0.0)
+        {
+            return -1.0;
+        }
+        best = (best < 0.0) ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+void report(
+    std::string const& dir,
+    std::string const& files_case,
+    std::string const& backend,
+    std::optional<double> const seconds,
+    std::size_t const files
+)
+{
+    std::cout << dir << "\t" << files_case << "\t" << backend << "\t";
+    if (!seconds)
+    {
+        std::cout << "unavailable\n";
+        return;
+    }
+
+    if (*seconds < 0.0)
+    {
+        std::cout << "FAILED\n";
+        return;
+    }
+
+    std::cout << *seconds * 1000.0 << " ms\t" << static_cast<double>(files) / *seconds
+              << " files/s\n";
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto num_files = std::size_t{10000U};
+    if (argc > 1)
+    {
+        num_files = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    std::vector<std::filesystem::path> dirs{};
+    for (auto index = 2; index < argc; ++index)
+    {
+        dirs.emplace_back(argv[index]);
+    }
+    if (dirs.empty())
+    {
+        dirs.emplace_back("/dev/shm");
+        dirs.push_back(std::filesystem::current_path());
+    }
+
+    std::vector<std::string> stems{};
+    for (auto index = std::size_t{0U}; index < num_files; ++index)
+    {
+        stems.push_back(std::to_string(index));
+    }
+
+    std::vector<output_item> items{};
+    for (auto index = std::size_t{0U}; index < num_files; ++index)
+    {
+        auto const& rendered = lookup_rendered_id(index % num_asset_ids());
+        items.push_back({stems[index], &rendered, false, false});
+    }
+
+    std::cout << "directory\tfiles\tbackend\telapsed\tthroughput (best of " << num_repeats
+              << ")\n";
+
+    for (auto const& dir: dirs)
+    {
+        auto const run_dir = dir / "asset_id_output_bench";
+
+        for (auto const overwrite: {false, true})
+        {
+            auto const files_case = overwrite ? "existing" : "new";
+
+            auto const direct_seconds = time_backend(
+                run_dir,
+                items,
+                overwrite,
+                [&run_dir]()
+                { return std::make_unique<directory_sink>(run_dir, png_backend::builtin); }
+            );
+            report(dir.string(), files_case, "direct", direct_seconds, num_files);
+
+            auto const uring_seconds = time_backend(
+                run_dir,
+                items,
+                overwrite,
+                [&run_dir]() { return make_uring_sink(run_dir, default_queue_depth, false); }
+            );
+            report(dir.string(), files_case, "io_uring", uring_seconds, num_files);
+        }
+
+        std::filesystem::remove_all(run_dir);
+    }
+
+    return EXIT_SUCCESS;
+}
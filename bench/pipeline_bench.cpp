@@ -0,0 +1,619 @@
+/**
+ * @file   pipeline_bench.cpp
+ * @brief  Times every stage of the pipeline on its own and the whole tool over generated inputs,
+ *         writing the results as JSON so that runs can be compared.
+ *
+ * Usage: asset_id_bench [--lines N[,N...]] [--invalid RATIO] [--duplicates RATIO] [--jobs N]
+ *                       [--dir DIR] [--output FILE]
+ *
+ * The stage benchmarks run each function over all 10000 ids, repeating the pass until a run is
+ * long enough to time, and report the best of several runs in nanoseconds per call.
+ *
+ * The end-to-end benchmark generates an input file for every line count (by default 10k, 100k,
+ * 1M and 10M lines) in which a fraction RATIO of the lines are malformed (`--invalid`, default
+ * 0.05) and a fraction repeat an id seen earlier (`--duplicates`, default 0.2). Each file is
+ * processed exactly as the tool does, with `--jobs` workers (default: the hardware concurrency),
+ * once into a directory under DIR (default `/dev/shm`) and once into memory. With more than
+ * 10000 lines ids necessarily repeat, whatever the duplicate ratio.
+ *
+ * The JSON document is written to standard output unless `--output FILE` is given.
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "asset_id.h"
+#include "batch.h"
+#include "checksum_batch.h"
+#include "id_table.h"
+#include "image_line.h"
+#include "input_reader.h"
+#include "options.h"
+#include "output_sink.h"
+#include "render_batch.h"
+#include "write_png.h"
+
+using namespace asset_id;
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+constexpr auto const num_repeats = 5U;
+constexpr auto const num_end_to_end_repeats = 3U;
+
+/**
+ * @brief The shortest run, in seconds, that a stage benchmark times.
+ */
+constexpr auto const min_run_seconds = 0.05;
+
+/**
+ * @brief Stop the compiler from discarding a value that is computed only to be timed.
+ */
+template<typename T>
+void keep(T const& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+double seconds_since(clock_type::time_point const start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+struct stage_timing
+{
+    std::string name;
+    std::size_t calls = 0U;
+    double ns_per_call = 0.0;
+};
+
+/**
+ * @brief Time `pass`, which makes `calls_per_pass` calls of the function being measured.
+ *
+ * The pass is repeated enough times for a run to last at least `min_run_seconds`, and the
+ * fastest of `num_repeats` runs is reported.
+ */
+template<typename Pass>
+stage_timing time_stage(std::string name, std::size_t const calls_per_pass, Pass&& pass)
+{
+    auto const calibration_start = clock_type::now();
+    pass();
+    auto const pass_seconds = std::max(seconds_since(calibration_start), 1e-9);
+    auto const num_passes =
+        std::max<std::size_t>(1U, static_cast<std::size_t>(min_run_seconds / pass_seconds));
+
+    auto best = -1.0;
+    for (auto repeat = 0U; repeat < num_repeats; ++repeat)
+    {
+        auto const start = clock_type::now();
+        for (auto index = std::size_t{0U}; index < num_passes; ++index)
+        {
+            pass();
+        }
+        auto const seconds = seconds_since(start);
+        if ((best < 0.0) || (seconds < best))
+        {
+            best = seconds;
+        }
+    }
+
+    auto const calls = num_passes * calls_per_pass;
+    return {std::move(name), calls, best * 1e9 / static_cast<double>(calls)};
+}
+
+/**
+ * @brief A sink that is not concurrent and keeps every png file in one growing buffer, to time
+ * the pipeline without any file system; like the tar sink, it takes the builtin encoding from
+ * the batch.
+ */
+class memory_sink final : public output_sink
+{
+public:
+    void write(output_item* const items, std::size_t const num_items) override
+    {
+        for (auto index = std::size_t{0U}; index < num_items; ++index)
+        {
+            auto const png = builtin_encoding(items[index]);
+            _bytes.insert(_bytes.end(), png.begin(), png.end());
+            items[index].written = true;
+        }
+    }
+
+    bool is_concurrent() const override { return false; }
+
+    bool wants_encoded() const override { return true; }
+
+    void clear() { _bytes.clear(); }
+
+private:
+    std::vector<std::uint8_t> _bytes;
+};
+
+std::string id_text(std::uint32_t const number)
+{
+    std::ostringstream text;
+    text << std::setw(asset_id_length) << std::setfill('0') << number;
+    return text.str();
+}
+
+std::vector<stage_timing> run_stages(std::filesystem::path const& dir)
+{
+    std::vector<std::string> texts{};
+    std::vector<asset_id_t> ids{};
+    std::vector<checked_asset_id_t> checked_ids{};
+    auto characters = std::string{};
+    for (auto number = 0U; number < num_asset_ids(); ++number)
+    {
+        texts.push_back(id_text(number));
+        ids.push_back(*create_asset_id(texts.back()));
+        checked_ids.push_back(*create_checked_asset_id(ids.back()));
+        characters += texts.back();
+    }
+
+    std::vector<stage_timing> timings{};
+
+    timings.push_back(time_stage("digit::from_char", characters.size(), [&]() {
+        for (auto const character: characters)
+        {
+            keep(digit::from_char(character));
+        }
+    }));
+
+    timings.push_back(time_stage("create_asset_id", texts.size(), [&]() {
+        for (auto const& text: texts)
+        {
+            keep(create_asset_id(text));
+        }
+    }));
+
+    timings.push_back(time_stage("calculate_checksum", ids.size(), [&]() {
+        for (auto const& id: ids)
+        {
+            keep(calculate_checksum(id, digit::base(), 97U));
+        }
+    }));
+
+    // The same checksums through the batch kernels, with the ids in structure-of-arrays layout.
+    std::array<std::vector<std::uint8_t>, asset_id_length> soa_digits{};
+    auto soa = soa_ids{{}, ids.size()};
+    for (auto position = std::size_t{0U}; position < asset_id_length; ++position)
+    {
+        for (auto const& id: ids)
+        {
+            soa_digits[position].push_back(id[position].value());
+        }
+        soa.digits[position] = soa_digits[position].data();
+    }
+    std::vector<std::uint8_t> checksum_hi(ids.size());
+    std::vector<std::uint8_t> checksum_lo(ids.size());
+
+    constexpr std::array<std::pair<simd_level, char const*>, 3U> levels{
+        {{simd_level::scalar, "calculate_checksums/scalar"},
+         {simd_level::sse2, "calculate_checksums/sse2"},
+         {simd_level::avx2, "calculate_checksums/avx2"}}
+    };
+    for (auto const& [level, name]: levels)
+    {
+        if (!is_supported(level))
+        {
+            continue;
+        }
+
+        timings.push_back(time_stage(name, ids.size(), [&, level = level]() {
+            calculate_checksums(soa, {checksum_hi.data(), checksum_lo.data()}, level);
+            keep(checksum_hi);
+            keep(checksum_lo);
+        }));
+    }
+
+    timings.push_back(time_stage("create_checked_asset_id", ids.size(), [&]() {
+        for (auto const& id: ids)
+        {
+            keep(create_checked_asset_id(id));
+        }
+    }));
+
+    timings.push_back(time_stage("create_image_line", checked_ids.size(), [&]() {
+        for (auto const& checked_id: checked_ids)
+        {
+            keep(create_image_line(checked_id, image_line_start_byte));
+        }
+    }));
+
+    // The same lines through the batch kernels, a block at a time into an aligned buffer. The tool
+    // only runs these once, to build the id table, so they measure start-up, not throughput.
+    constexpr auto const render_block = std::size_t{512U};
+    alignas(image_line_alignment) std::array<image_line_t, render_block> rendered_lines{};
+
+    constexpr std::array<std::pair<simd_level, char const*>, 3U> render_levels{
+        {{simd_level::scalar, "render_image_lines/scalar"},
+         {simd_level::sse2, "render_image_lines/sse2"},
+         {simd_level::avx2, "render_image_lines/avx2"}}
+    };
+    for (auto const& [level, name]: render_levels)
+    {
+        if (!is_supported(level))
+        {
+            continue;
+        }
+
+        timings.push_back(time_stage(name, checked_ids.size(), [&, level = level]() {
+            for (auto first = std::size_t{0U}; first < checked_ids.size(); first += render_block)
+            {
+                auto const count = std::min(render_block, checked_ids.size() - first);
+                render_image_lines(&checked_ids[first], count, rendered_lines.data(), level);
+                keep(rendered_lines);
+            }
+        }));
+    }
+
+    timings.push_back(time_stage("encode_as_png", checked_ids.size(), [&]() {
+        for (auto const& checked_id: checked_ids)
+        {
+            keep(encode_as_png(checked_id));
+        }
+    }));
+
+    auto const stage_dir = dir / "asset_id_bench_stage";
+    std::filesystem::remove_all(stage_dir);
+    std::filesystem::create_directories(stage_dir);
+
+    std::vector<std::filesystem::path> paths{};
+    for (auto const& text: texts)
+    {
+        paths.push_back(stage_dir / (text + ".png"));
+    }
+
+    timings.push_back(time_stage("write_as_png/directory", checked_ids.size(), [&]() {
+        for (auto index = std::size_t{0U}; index < checked_ids.size(); ++index)
+        {
+            keep(write_as_png(checked_ids[index], paths[index]));
+        }
+    }));
+    std::filesystem::remove_all(stage_dir);
+
+    std::vector<output_item> items{};
+    for (auto index = std::size_t{0U}; index < texts.size(); ++index)
+    {
+        auto item = output_item{};
+        item.file_stem = texts[index];
+        item.rendered = &lookup_rendered_id(static_cast<std::uint32_t>(index));
+        items.push_back(item);
+    }
+
+    auto sink = memory_sink{};
+    timings.push_back(time_stage("write_as_png/memory", items.size(), [&]() {
+        sink.clear();
+        sink.write(items.data(), items.size());
+    }));
+
+    return timings;
+}
+
+/**
+ * @brief A small, fast pseudo random generator (xorshift32); the inputs only need to be
+ * reproducible, not random.
+ */
+class xorshift
+{
+public:
+    explicit xorshift(std::uint32_t const seed):
+        _state(seed)
+    {
+    }
+
+    std::uint32_t next()
+    {
+        _state ^= _state << 13U;
+        _state ^= _state >> 17U;
+        _state ^= _state << 5U;
+        return _state;
+    }
+
+    /**
+     * @return double holding a value in [0, 1).
+     */
+    double fraction() { return static_cast<double>(next()) / 4294967296.0; }
+
+private:
+    std::uint32_t _state;
+};
+
+/**
+ * @brief Generate an input of `num_lines` lines with the requested fractions of malformed and
+ * repeated ids.
+ */
+std::string make_input(std::size_t const num_lines, double const invalid, double const duplicates)
+{
+    static constexpr std::array<std::string_view, 4U> malformed{"12a4", "123", "12345", ""};
+
+    auto random = xorshift{2463534242U};
+
+    // Fresh ids are taken, in a shuffled order, from every id; once all of them have been used
+    // the order starts again.
+    std::vector<std::uint32_t> fresh(num_asset_ids());
+    std::iota(fresh.begin(), fresh.end(), 0U);
+    for (auto index = fresh.size() - 1U; index > 0U; --index)
+    {
+        std::swap(fresh[index], fresh[random.next() % (index + 1U)]);
+    }
+    auto next_fresh = std::size_t{0U};
+    auto num_seen = std::size_t{0U};
+
+    auto input = std::string{};
+    input.reserve(num_lines * (asset_id_length + 1U));
+    for (auto line = std::size_t{0U}; line < num_lines; ++line)
+    {
+        if (random.fraction() < invalid)
+        {
+            input += malformed[line % malformed.size()];
+        }
+        else if ((num_seen > 0U) && (random.fraction() < duplicates))
+        {
+            input += id_text(fresh[random.next() % num_seen]);
+        }
+        else
+        {
+            input += id_text(fresh[next_fresh]);
+            next_fresh = (next_fresh + 1U) % fresh.size();
+            num_seen = std::max(num_seen, next_fresh);
+        }
+        input += '\n';
+    }
+
+    return input;
+}
+
+struct end_to_end_timing
+{
+    std::size_t lines = 0U;
+    std::string sink;
+    double seconds = 0.0;
+    batch_summary summary;
+};
+
+/**
+ * @brief Time the tool over the input file at `input_path`, keeping the fastest of
+ * `num_end_to_end_repeats` runs; `prepare` is called before each run and returns the sink.
+ */
+template<typename Prepare>
+end_to_end_timing time_end_to_end(
+    std::filesystem::path const& input_path,
+    std::size_t const lines,
+    std::string sink_name,
+    options const& settings,
+    Prepare&& prepare
+)
+{
+    auto timing = end_to_end_timing{lines, std::move(sink_name), -1.0, {}};
+    for (auto repeat = 0U; repeat < num_end_to_end_repeats; ++repeat)
+    {
+        auto& sink = prepare();
+
+        auto const start = clock_type::now();
+        auto const input = mapped_file::open(input_path);
+        if (!input)
+        {
+            return timing;
+        }
+        auto summary = process_batch(input->contents(), settings, sink);
+        sink.finish();
+        auto const seconds = seconds_since(start);
+
+        if ((timing.seconds < 0.0) || (seconds < timing.seconds))
+        {
+            timing.seconds = seconds;
+            timing.summary = std::move(summary);
+        }
+    }
+
+    return timing;
+}
+
+std::string json_string(std::string_view const text)
+{
+    auto quoted = std::string{"\""};
+    for (auto const character: text)
+    {
+        if ((character == '"') || (character == '\\'))
+        {
+            quoted += '\\';
+        }
+        quoted += character;
+    }
+    return quoted + "\"";
+}
+
+void write_json(
+    std::ostream& output,
+    std::vector<stage_timing> const& stages,
+    std::vector<end_to_end_timing> const& runs,
+    options const& settings,
+    double const invalid,
+    double const duplicates,
+    std::filesystem::path const& dir
+)
+{
+    output << std::fixed << std::setprecision(3);
+    output << "{\n";
+    output << "  \"config\": {\"jobs\": " << settings.jobs << ", \"invalid_ratio\": " << invalid
+           << ", \"duplicate_ratio\": " << duplicates << ", \"dir\": " << json_string(dir.string())
+           << "},\n";
+
+    output << "  \"stages\": [\n";
+    for (auto index = std::size_t{0U}; index < stages.size(); ++index)
+    {
+        auto const& stage = stages[index];
+        output << "    {\"name\": " << json_string(stage.name) << ", \"calls\": " << stage.calls
+               << ", \"ns_per_call\": " << stage.ns_per_call << "}"
+               << ((index + 1U < stages.size()) ? ",\n" : "\n");
+    }
+    output << "  ],\n";
+
+    output << "  \"end_to_end\": [\n";
+    for (auto index = std::size_t{0U}; index < runs.size(); ++index)
+    {
+        auto const& run = runs[index];
+        auto const lines_per_second =
+            (run.seconds > 0.0) ? static_cast<double>(run.lines) / run.seconds : 0.0;
+        output << "    {\"lines\": " << run.lines << ", \"sink\": " << json_string(run.sink)
+               << ", \"seconds\": " << std::setprecision(6) << run.seconds
+               << std::setprecision(3) << ", \"lines_per_second\": " << lines_per_second
+               << ", \"written\": " << run.summary.written
+               << ", \"duplicates\": " << run.summary.duplicates
+               << ", \"failures\": " << run.summary.num_failures << "}"
+               << ((index + 1U < runs.size()) ? ",\n" : "\n");
+    }
+    output << "  ]\n";
+    output << "}\n";
+}
+
+bool parse_ratio(char const* const text, double& ratio)
+{
+    char* end = nullptr;
+    ratio = std::strtod(text, &end);
+    return (end != text) && (*end == '\0') && (ratio >= 0.0) && (ratio <= 1.0);
+}
+
+bool parse_line_counts(std::string_view text, std::vector<std::size_t>& counts)
+{
+    counts.clear();
+    while (!text.empty())
+    {
+        auto const comma = text.find(',');
+        auto const item = std::string{text.substr(0U, comma)};
+        char* end = nullptr;
+        auto const count = std::strtoull(item.c_str(), &end, 10);
+        if (item.empty() || (*end != '\0') || (count == 0U))
+        {
+            return false;
+        }
+        counts.push_back(count);
+        text = (comma == std::string_view::npos) ? std::string_view{} : text.substr(comma + 1U);
+    }
+    return !counts.empty();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto line_counts = std::vector<std::size_t>{10000U, 100000U, 1000000U, 10000000U};
+    auto invalid = 0.05;
+    auto duplicates = 0.2;
+    auto dir = std::filesystem::path{"/dev/shm"};
+    auto output_path = std::filesystem::path{};
+
+    auto settings = options{};
+    settings.jobs = default_jobs();
+
+    for (auto index = 1; index < argc; ++index)
+    {
+        auto const argument = std::string_view{argv[index]};
+        if (index + 1 >= argc)
+        {
+            std::cerr << "Unsupported argument '" << argument << "'.\n";
+            return EXIT_FAILURE;
+        }
+
+        auto const* const value = argv[++index];
+        auto valid = true;
+        if (argument == "--lines")
+        {
+            valid = parse_line_counts(value, line_counts);
+        }
+        else if (argument == "--invalid")
+        {
+            valid = parse_ratio(value, invalid);
+        }
+        else if (argument == "--duplicates")
+        {
+            valid = parse_ratio(value, duplicates);
+        }
+        else if (argument == "--jobs")
+        {
+            settings.jobs = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            valid = (settings.jobs > 0U);
+        }
+        else if (argument == "--dir")
+        {
+            dir = value;
+        }
+        else if (argument == "--output")
+        {
+            output_path = value;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Unsupported value '" << value << "' for '" << argument << "'.\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Build the table of rendered ids up front so that no benchmark pays for it.
+    keep(lookup_rendered_id(0U));
+
+    auto const stages = run_stages(dir);
+
+    auto const input_path = dir / "asset_id_bench_input.txt";
+    auto const output_dir = dir / "asset_id_bench_output";
+
+    std::vector<end_to_end_timing> runs{};
+    for (auto const lines: line_counts)
+    {
+        {
+            auto const input = make_input(lines, invalid, duplicates);
+            auto file = std::ofstream(input_path, std::ios::binary | std::ios::trunc);
+            file.write(input.data(), static_cast<std::streamsize>(input.size()));
+            if (!file)
+            {
+                std::cerr << "Cannot write the input file " << input_path << ".\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        auto directory = std::optional<directory_sink>{};
+        runs.push_back(time_end_to_end(input_path, lines, "directory", settings, [&]() -> auto& {
+            std::filesystem::remove_all(output_dir);
+            std::filesystem::create_directories(output_dir);
+            return directory.emplace(output_dir, png_backend::builtin);
+        }));
+
+        auto memory = memory_sink{};
+        runs.push_back(time_end_to_end(input_path, lines, "memory", settings, [&]() -> auto& {
+            memory.clear();
+            return memory;
+        }));
+    }
+
+    std::filesystem::remove_all(output_dir);
+    std::filesystem::remove(input_path);
+
+    if (output_path.empty())
+    {
+        write_json(std::cout, stages, runs, settings, invalid, duplicates, dir);
+        return EXIT_SUCCESS;
+    }
+
+    auto output = std::ofstream(output_path);
+    write_json(output, stages, runs, settings, invalid, duplicates, dir);
+    return output ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,10 +14,14 @@
  #pragma once
 
 #include <array>
-#include <optional>
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
+#include <utility>
 
 #include "digit.h"
+#include "id_geometry.h"
+#include "result.h"
 
 namespace asset_id
 {
@@ -28,8 +32,8 @@ namespace asset_id
  * parts of this tools implementation and std::array type only exposes its size
  * via instance methods.
  */
-constexpr auto asset_id_length = 4U;
-using asset_id_t = std::array<digit, asset_id_length>;
+constexpr auto asset_id_length = default_geometry::id_length;
+using asset_id_t = default_geometry::id_t;
 
 /**
  * @brief The checksum_t type is used to hold the digits of a checksum which is 
@@ -39,8 +43,8 @@ using asset_id_t = std::array<digit, asset_id_length>;
  * parts of this tools implementation and std::array type only exposes its size
  * via instance methods.
  */
-constexpr auto checksum_length = 2U;
-using checksum_t = std::array<digit, checksum_length>;
+constexpr auto checksum_length = default_geometry::checksum_length;
+using checksum_t = default_geometry::checksum_t;
 
 /**
  * @brief The checked_asset_id_t type holds the digits of an asset_id_t and its 
@@ -51,8 +55,42 @@ using checksum_t = std::array<digit, checksum_length>;
  * parts of this tools implementation and std::array type only exposes its size
  * via instance methods.
  */
-constexpr auto checked_asset_id_length = asset_id_length + checksum_length;
-using checked_asset_id_t = std::array<digit, checked_asset_id_length>;
+constexpr auto checked_asset_id_length = default_geometry::checked_id_length;
+using checked_asset_id_t = default_geometry::checked_id_t;
+
+/**
+ * @brief Create an id of any geometry from a string.
+ *
+ * @tparam Geometry  an instance of `id_geometry`.
+ * @param id_str     string of exactly `Geometry::id_length` base 10 digits.
+ *
+ * @return result<typename Geometry::id_t> containing the id digits if `id_str` is of the
+ *         correct form; `error_code::bad_length` or `error_code::bad_digit` otherwise.
+ */
+template<typename Geometry>
+constexpr result<typename Geometry::id_t> create_id(std::string_view id_str);
+
+/**
+ * @brief Convert an id of any geometry to the integer it represents.
+ */
+template<typename Geometry>
+constexpr std::uint64_t to_number(typename Geometry::id_t const& id);
+
+/**
+ * @brief Calculate the checksum of an id of any geometry: the sum of its digits, each weighted
+ * by ten to the power of its index, modulo `Geometry::checksum_base`.
+ *
+ * The geometry guarantees that every checksum fits in its digits, so this cannot fail.
+ */
+template<typename Geometry>
+constexpr typename Geometry::checksum_t calculate_checksum(typename Geometry::id_t const& id);
+
+/**
+ * @brief Create the checked id of an id of any geometry: the digits of its checksum followed
+ * by the digits of the id.
+ */
+template<typename Geometry>
+constexpr typename Geometry::checked_id_t create_checked_id(typename Geometry::id_t const& id);
 
 /**
  * @brief Create an instance of asset_id_t from a string.
@@ -61,10 +99,10 @@ using checked_asset_id_t = std::array<digit, checked_asset_id_length>;
  * 
  * @param id_str string containing the asset_id digits.
  *
- * @return std::optional<asset_id_t> containing the id digits if `id_str` is of the correct 
- *         form; empty optional otherwise.
+ * @return result<asset_id_t> containing the id digits if `id_str` is of the correct form;
+ *         `error_code::bad_length` or `error_code::bad_digit` otherwise.
  */
-std::optional<asset_id_t> create_asset_id(std::string_view id_str);
+result<asset_id_t> create_asset_id(std::string_view id_str);
 
 /**
  * @brief Calculates a simple checksum on an instance of asset_id.
@@ -73,10 +111,11 @@ std::optional<asset_id_t> create_asset_id(std::string_view id_str);
  * @param digit_base     weight to apply to each digit of the asset_id
  * @param checksum_base 
  *
- * @return std::optional<checksum_t> containing the digits of the checksum if the 
-*          calculation succeeded; empty optional otherwise.
+ * @return result<checksum_t> containing the digits of the checksum if the calculation
+ *         succeeded; `error_code::checksum_overflow` if it does not fit in `checksum_length`
+ *         digits.
  */
-std::optional<checksum_t> calculate_checksum(
+constexpr result<checksum_t> calculate_checksum(
     asset_id::asset_id_t const& asset_id,
     std::uint8_t digit_base,
     std::uint8_t checksum_base
@@ -87,8 +126,147 @@ std::optional<checksum_t> calculate_checksum(
  *        of its checksum.
  * 
  * @param asset_id  the instance to use.
- * @return std::optional<checked_asset_id_t> containing the checksum digits followed by the 
- *         asset_id digits if this calculation succeeded; empty optional otherwise.
+ * @return result<checked_asset_id_t> containing the checksum digits followed by the asset_id
+ *         digits; `default_geometry` guarantees that this succeeds.
  */
-std::optional<checked_asset_id_t> create_checked_asset_id(asset_id_t const& asset_id);
-} // namespace asset_id
\ No newline at end of file
+constexpr result<checked_asset_id_t> create_checked_asset_id(asset_id_t const& asset_id);
+
+/**
+ * @brief Convert an instance of asset_id_t to the integer it represents.
+ *
+ * @param asset_id  the instance to convert.
+ * @return std::uint32_t holding the value of the id, in the range [0, 10^asset_id_length).
+ */
+constexpr std::uint32_t to_number(asset_id_t const& asset_id)
+{
+    return static_cast<std::uint32_t>(to_number<default_geometry>(asset_id));
+}
+
+namespace detail
+{
+/**
+ * @brief Ten to the power `Exponent`, always evaluated at compile time.
+ */
+template<std::size_t Exponent>
+constexpr auto const power_of_ten = integer_power(digit::base(), static_cast<unsigned>(Exponent));
+
+template<typename Geometry, std::size_t... Index>
+constexpr std::uint64_t
+weighted_digit_sum(typename Geometry::id_t const& id, std::index_sequence<Index...>)
+{
+    return ((power_of_ten<Index> * id[Index].value()) + ... + 0U);
+}
+
+/**
+ * @brief Split `value` into its `sizeof...(Index)` least significant digits, most significant
+ * first.
+ */
+template<typename Geometry, std::size_t... Index>
+constexpr typename Geometry::checksum_t
+checksum_digits(std::uint64_t const value, std::index_sequence<Index...>)
+{
+    constexpr auto last = sizeof...(Index) - 1U;
+    return {*digit::from_int(
+        static_cast<digit::value_t>(value / power_of_ten<last - Index> % digit::base())
+    )...};
+}
+
+template<typename Geometry, std::size_t... ChecksumIndex, std::size_t... IdIndex>
+constexpr typename Geometry::checked_id_t join_checked_id(
+    typename Geometry::checksum_t const& checksum,
+    typename Geometry::id_t const& id,
+    std::index_sequence<ChecksumIndex...>,
+    std::index_sequence<IdIndex...>
+)
+{
+    return {checksum[ChecksumIndex]..., id[IdIndex]...};
+}
+} // namespace detail
+
+template<typename Geometry>
+constexpr result<typename Geometry::id_t> create_id(std::string_view const id_str)
+{
+    if (id_str.size() != Geometry::id_length)
+    {
+        return error_code::bad_length;
+    }
+
+    auto id = typename Geometry::id_t{};
+    for (auto index = 0U; index < id_str.size(); ++index)
+    {
+        auto const maybe_digit = digit::from_char(id_str[index]);
+        if (!maybe_digit)
+        {
+            return maybe_digit.error();
+        }
+
+        id[index] = *maybe_digit;
+    }
+
+    return id;
+}
+
+template<typename Geometry>
+constexpr std::uint64_t to_number(typename Geometry::id_t const& id)
+{
+    auto result = std::uint64_t{0U};
+    for (auto const digit: id)
+    {
+        result = result * digit::base() + digit.value();
+    }
+    return result;
+}
+
+template<typename Geometry>
+constexpr typename Geometry::checksum_t calculate_checksum(typename Geometry::id_t const& id)
+{
+    auto const sum =
+        detail::weighted_digit_sum<Geometry>(id, std::make_index_sequence<Geometry::id_length>{});
+    return detail::checksum_digits<Geometry>(
+        sum % Geometry::checksum_base, std::make_index_sequence<Geometry::checksum_length>{}
+    );
+}
+
+template<typename Geometry>
+constexpr typename Geometry::checked_id_t create_checked_id(typename Geometry::id_t const& id)
+{
+    return detail::join_checked_id<Geometry>(
+        calculate_checksum<Geometry>(id),
+        id,
+        std::make_index_sequence<Geometry::checksum_length>{},
+        std::make_index_sequence<Geometry::id_length>{}
+    );
+}
+
+constexpr result<checksum_t> calculate_checksum(
+    asset_id_t const& asset_id,
+    std::uint8_t const digit_base,
+    std::uint8_t const checksum_base
+)
+{
+    auto digit_sum = std::uint64_t{0U};
+    auto coeff = std::uint64_t{1U};
+
+    for (auto const digit: asset_id)
+    {
+        digit_sum += coeff * digit.value();
+        coeff *= digit_base;
+    }
+
+    digit_sum = digit_sum % checksum_base;
+
+    auto const lo_digit = digit::from_int(static_cast<digit::value_t>(digit_sum % digit_base));
+    auto const hi_digit = digit::from_int(static_cast<digit::value_t>(digit_sum / digit_base));
+    if (!lo_digit || !hi_digit)
+    {
+        return error_code::checksum_overflow;
+    }
+
+    return checksum_t{*hi_digit, *lo_digit};
+}
+
+constexpr result<checked_asset_id_t> create_checked_asset_id(asset_id_t const& asset_id)
+{
+    return create_checked_id<default_geometry>(asset_id);
+}
+} // namespace asset_id
@@ -0,0 +1,246 @@
+#include "atomic_write.h"
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "durability.h"
+#include "stats.h"
+
+namespace
+{
+/**
+ * @brief Cleared once the output file system turns out not to support `O_TMPFILE`, so that the
+ * failed open is not repeated for every file.
+ */
+std::atomic<bool> tmpfile_supported{true};
+
+/**
+ * @brief Set once a linked `O_TMPFILE` file turns out to replace an existing one. Replacing a
+ * file that way takes a failed `linkat`, a second one under a temporary name and a `renameat`,
+ * while a named temporary file only needs the `renameat`, and creating a new file costs the
+ * same either way; so from then on files are staged under a temporary name.
+ */
+std::atomic<bool> replacing_files{false};
+
+/**
+ * @brief Distinguishes the temporary names used by concurrent writers of the same file.
+ */
+std::atomic<std::uint64_t> next_temp_id{0U};
+
+bool write_all(int const fd, std::uint8_t const* data, std::size_t size)
+{
+    while (size > 0U)
+    {
+        auto const written = ::write(fd, data, size);
+        asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        asset_id::add_count(
+            asset_id::stats_counter::bytes_written, static_cast<std::uint64_t>(written)
+        );
+    }
+
+    return true;
+}
+
+/**
+ * @brief Rename the staged file `temp` over `name`, removing it if that fails.
+ */
+bool rename_into_place(int const dir_fd, std::string const& temp, char const* const name)
+{
+    auto const renamed = (renameat(dir_fd, temp.c_str(), dir_fd, name) == 0);
+    asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+    if (!renamed)
+    {
+        unlinkat(dir_fd, temp.c_str(), 0);
+        asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+    }
+    return renamed;
+}
+
+/**
+ * @return int holding an anonymous `O_TMPFILE` file in `dir_fd`; -1 if it cannot be created,
+ *         or if the file system does not support it, in which case `tmpfile_supported` is
+ *         cleared.
+ */
+int open_tmpfile(int const dir_fd)
+{
+    // Linking through /proc needs no privileges, unlike `AT_EMPTY_PATH`, but without /proc the
+    // file could never be linked at all.
+    static auto const proc_mounted = (access("/proc/self/fd", X_OK) == 0);
+    if (!proc_mounted || !tmpfile_supported.load(std::memory_order_relaxed))
+    {
+        return -1;
+    }
+
+    auto const fd =
+        openat(dir_fd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, asset_id::new_file_mode);
+    asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+
+    // Older kernels report a directory that does not support O_TMPFILE as EISDIR.
+    if ((fd < 0) && ((errno == EOPNOTSUPP) || (errno == EISDIR) || (errno == EINVAL)))
+    {
+        tmpfile_supported.store(false, std::memory_order_relaxed);
+    }
+    return fd;
+}
+
+/**
+ * @brief Link the anonymous file `fd` into `dir_fd` as `name`, replacing any existing file.
+ */
+bool link_tmpfile(int const fd, int const dir_fd, char const* const name)
+{
+    auto const source = "/proc/self/fd/" + std::to_string(fd);
+    auto const link = [&](char const* const target)
+    {
+        asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+        return linkat(AT_FDCWD, source.c_str(), dir_fd, target, AT_SYMLINK_FOLLOW) == 0;
+    };
+
+    if (link(name))
+    {
+        return true;
+    }
+
+    // `linkat` never replaces a file, so an existing one is renamed over instead.
+    if (errno != EEXIST)
+    {
+        return false;
+    }
+    replacing_files.store(true, std::memory_order_relaxed);
+
+    auto const temp = asset_id::staging_name(name);
+    return link(temp.c_str()) && rename_into_place(dir_fd, temp, name);
+}
+} // namespace
+
+namespace asset_id
+{
+std::string staging_name(char const* const name)
+{
+    return "." + std::string{name} + "." + std::to_string(getpid()) + "." +
+           std::to_string(next_temp_id.fetch_add(1U, std::memory_order_relaxed)) + ".tmp";
+}
+
+std::unique_ptr<staged_file> staged_file::create(int const dir_fd, std::string name)
+{
+    if (!replacing_files.load(std::memory_order_relaxed))
+    {
+        auto const tmpfile_fd = open_tmpfile(dir_fd);
+        if (tmpfile_fd >= 0)
+        {
+            return std::unique_ptr<staged_file>{
+                new staged_file{dir_fd, std::move(name), {}, tmpfile_fd}
+            };
+        }
+        if (tmpfile_supported.load(std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+    }
+
+    auto temp = asset_id::staging_name(name.c_str());
+    auto const fd = openat(
+        dir_fd, temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, new_file_mode
+    );
+    add_count(stats_counter::syscalls, 1U);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    return std::unique_ptr<staged_file>{
+        new staged_file{dir_fd, std::move(name), std::move(temp), fd}
+    };
+}
+
+staged_file::staged_file(int const dir_fd, std::string name, std::string temp, int const fd):
+    _dir_fd(dir_fd),
+    _name(std::move(name)),
+    _temp(std::move(temp)),
+    _fd(fd)
+{
+}
+
+staged_file::~staged_file()
+{
+    if (_fd < 0)
+    {
+        return;
+    }
+
+    close(_fd);
+    add_count(stats_counter::syscalls, 1U);
+    if (!_temp.empty())
+    {
+        unlinkat(_dir_fd, _temp.c_str(), 0);
+        add_count(stats_counter::syscalls, 1U);
+    }
+}
+
+result<void> staged_file::commit(bool const durable)
+{
+    if ((_fd < 0) || (durable && !sync_file(_fd)))
+    {
+        return error_code::io_error;
+    }
+
+    // An anonymous file is linked while still open; a named one is closed, so that any error
+    // writing it back is seen, before it is renamed.
+    auto const fd = _fd;
+    auto placed = false;
+    if (_temp.empty())
+    {
+        placed = link_tmpfile(fd, _dir_fd, _name.c_str());
+        close(fd);
+    }
+    else if (close(fd) == 0)
+    {
+        placed = rename_into_place(_dir_fd, _temp, _name.c_str());
+    }
+    else
+    {
+        unlinkat(_dir_fd, _temp.c_str(), 0);
+        add_count(stats_counter::syscalls, 1U);
+    }
+    add_count(stats_counter::syscalls, 1U);
+    _fd = -1;
+
+    // Once linked or renamed into place, the new name is only durable after the directory is.
+    if (!placed || (durable && !sync_file(_dir_fd)))
+    {
+        return error_code::io_error;
+    }
+    return {};
+}
+
+result<void> write_file_atomically(
+    int const dir_fd,
+    char const* const name,
+    std::uint8_t const* const data,
+    std::size_t const size,
+    bool const durable
+)
+{
+    auto const file = staged_file::create(dir_fd, name);
+    if (!file || !write_all(file->fd(), data, size))
+    {
+        return error_code::io_error;
+    }
+
+    return file->commit(durable);
+}
+} // namespace asset_id
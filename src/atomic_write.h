@@ -0,0 +1,109 @@
+/**
+ * @file   atomic_write.h
+ * @brief  Replaces files in a directory in a single step, so that a reader, or a crash, never
+ *         sees a partially written file.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "result.h"
+
+namespace asset_id
+{
+/**
+ * @brief The mode every output file is created with; the umask of the process applies to it,
+ * as it did when the files were created with `fopen`.
+ */
+constexpr auto const new_file_mode = 0666;
+
+/**
+ * @return std::string holding a hidden name, unique within this process and across processes,
+ *         under which a new version of `name` can be staged before it is renamed into place.
+ */
+std::string staging_name(char const* name);
+
+/**
+ * @brief A file that is written in a directory without appearing in it, and then replaces the
+ * file of its name at once; for output streamed to disk, rather than held in memory, such as a
+ * sprite sheet.
+ *
+ * The file is an anonymous `O_TMPFILE` file when the file system supports one and no file has
+ * yet been replaced, and otherwise a hidden temporary file. A file that is destroyed without
+ * being committed leaves nothing behind, and any existing file of its name as it was.
+ */
+class staged_file
+{
+public:
+    /**
+     * @return std::unique_ptr<staged_file> holding an empty file that will replace `name` in
+     *         the directory `dir_fd` once committed; null if it cannot be created.
+     */
+    static std::unique_ptr<staged_file> create(int dir_fd, std::string name);
+
+    staged_file(staged_file const&) = delete;
+    staged_file& operator=(staged_file const&) = delete;
+
+    ~staged_file();
+
+    /**
+     * @return int holding the descriptor, opened for writing, of the file; -1 once committed.
+     */
+    int fd() const { return _fd; }
+
+    /**
+     * @brief Close the file and link, or rename, it into place under its name.
+     *
+     * @param durable  when set, the file is synced before it is linked into place, and the
+     *                 directory once it has been.
+     *
+     * @return result<void> holding no error if the file replaced any existing one;
+     *         `error_code::io_error` otherwise, in which case the existing file is left as it
+     *         was.
+     */
+    result<void> commit(bool durable = false);
+
+private:
+    staged_file(int dir_fd, std::string name, std::string temp, int fd);
+
+    int _dir_fd;
+    std::string _name;
+
+    /**
+     * @brief The hidden name the file is written under; empty for an `O_TMPFILE` file.
+     */
+    std::string _temp;
+    int _fd;
+};
+
+/**
+ * @brief Write `size` bytes to the file `name` in the directory `dir_fd`, replacing any
+ * existing file at once.
+ *
+ * The bytes are written to an anonymous `O_TMPFILE` file which is then linked into the
+ * directory under `name`; when `name` already exists the file is linked under a temporary name
+ * and renamed over it. If the file system does not support `O_TMPFILE`, or once a file has
+ * been replaced, since replacing the rest is then cheaper that way, a named temporary file is
+ * written and renamed instead. A process that dies part way through therefore leaves either
+ * the previous file or the complete new one. Unless `durable` is set nothing is synced to disk,
+ * so a crash of the machine may still lose the file.
+ *
+ * May be called from several threads at once, including for the same `name`.
+ *
+ * @param dir_fd   a directory opened with `O_DIRECTORY`.
+ * @param name     the name of the file within the directory.
+ * @param data     the bytes to write.
+ * @param size     the number of bytes in `data`.
+ * @param durable  when set, the file is synced before it is linked into place, and the
+ *                 directory once it has been, so the file survives a crash once this returns.
+ *
+ * @return result<void> holding no error if the file was replaced; `error_code::io_error`
+ *         otherwise, in which case any existing file is left as it was.
+ */
+result<void> write_file_atomically(
+    int dir_fd, char const* name, std::uint8_t const* data, std::size_t size, bool durable = false
+);
+} // namespace asset_id
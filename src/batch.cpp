@@ -0,0 +1,737 @@
+#include "batch.h"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+
+#include "id_table.h"
+#include "input_reader.h"
+#include "png_encoder.h"
+#include "ring_queue.h"
+#include "stats.h"
+
+namespace
+{
+/**
+ * @brief The number of ids handed to the sink at a time by `process_range`.
+ */
+constexpr auto const chunk_num_lines = std::size_t{4096U};
+
+/**
+ * @brief The number of lines the reader scans into each batch of the pipeline.
+ */
+constexpr auto const batch_num_lines = std::size_t{256U};
+
+/**
+ * @brief The number of batches in flight between the reader and the writer; the reader waits
+ * whenever every one of them is in use, so memory use does not depend on the size of the input.
+ */
+constexpr auto const num_batch_slots = std::size_t{64U};
+
+/**
+ * @brief Stands for the id of a line that holds none.
+ */
+constexpr auto const no_id = asset_id::num_asset_ids();
+
+/**
+ * @brief How far a batch slot has got through the pipeline.
+ */
+enum class slot_state : std::uint8_t
+{
+    /**
+     * @brief Retired by the writer; the reader may scan the next batch into it.
+     */
+    free,
+
+    /**
+     * @brief Filled by the reader and queued for the workers.
+     */
+    scanned,
+
+    /**
+     * @brief Rendered and encoded by a worker, and written unless the sink is not concurrent;
+     * waiting for the writer.
+     */
+    processed,
+};
+
+/**
+ * @brief Reusable state for a single batch, sized for `batch_num_lines` records.
+ */
+struct batch_slot
+{
+    std::atomic<slot_state> state{slot_state::free};
+    std::size_t num_records = 0U;
+    std::vector<asset_id::input_record> records;
+    std::vector<asset_id::output_item> items;
+
+    /**
+     * @brief Set for each record whose id was already seen in an earlier line; such records are
+     * not processed, only recorded once the outcome of the first line is known.
+     */
+    std::bitset<batch_num_lines> repeated;
+
+    /**
+     * @brief The items of the well formed records, in input order, and the index of the record
+     * each one came from.
+     */
+    std::vector<asset_id::output_item> pending;
+    std::vector<std::size_t> pending_index;
+
+    /**
+     * @brief The builtin encoding of each pending item, for sinks that want it.
+     */
+    std::vector<asset_id::encoded_png_t> encoded;
+};
+
+/**
+ * @brief The state shared by the stages of `process_batch`: the reader scans batches into the
+ * slots in turn, the workers take them from `scanned` in any order, and the writer retires them
+ * in input order.
+ */
+struct pipeline_state
+{
+    pipeline_state()
+    {
+        for (auto& slot: slots)
+        {
+            slot.records.resize(batch_num_lines);
+            slot.items.resize(batch_num_lines);
+            slot.pending.reserve(batch_num_lines);
+            slot.pending_index.reserve(batch_num_lines);
+            slot.encoded.resize(batch_num_lines);
+        }
+    }
+
+    std::array<batch_slot, num_batch_slots> slots;
+
+    /**
+     * @brief The index of every slot scanned by the reader, in input order.
+     */
+    asset_id::spmc_ring<std::size_t, num_batch_slots> scanned;
+
+    /**
+     * @brief The number of batches scanned; final once `reading` is cleared.
+     */
+    std::atomic<std::size_t> num_batches{0U};
+    std::atomic<bool> reading{true};
+
+    /**
+     * @brief Notified whenever the writer frees a slot; the reader waits here.
+     */
+    asset_id::wait_point freed;
+
+    /**
+     * @brief Notified whenever a worker has processed a slot and once the reader has finished;
+     * the writer waits here.
+     */
+    asset_id::wait_point processed;
+};
+
+/**
+ * @brief The reader stage: scan `input` a batch at a time into the slots, skipping the lines
+ * owned by other shards and, unless `dedup` is cleared, marking the repeats of ids already seen,
+ * and queue each batch for the workers.
+ */
+void read_batches(
+    std::string_view const input,
+    bool const dedup,
+    asset_id::shard_spec const shard,
+    pipeline_state& pipeline
+)
+{
+    // One bit per possible id; an id is only processed the first time it is seen.
+    std::bitset<asset_id::num_asset_ids()> seen{};
+
+    auto scanner = asset_id::id_scanner{input};
+    for (auto sequence = std::size_t{0U};; ++sequence)
+    {
+        auto const slot_index = sequence % num_batch_slots;
+        auto& slot = pipeline.slots[slot_index];
+
+        // The slot still holds an earlier batch until the writer has retired it.
+        pipeline.freed.wait_until(
+            [&slot]() { return slot.state.load(std::memory_order_acquire) == slot_state::free; }
+        );
+
+        auto num_records = std::size_t{0U};
+        auto num_lines = std::size_t{0U};
+        auto num_ids = std::size_t{0U};
+        {
+            auto scan_timer = asset_id::stage_timer{asset_id::stats_stage::scan};
+            while (num_records < batch_num_lines)
+            {
+                auto& record = slot.records[num_records];
+                if (!scanner.next(record))
+                {
+                    break;
+                }
+
+                // Every line of an id goes to the same shard, so each shard can tell duplicates
+                // apart on its own.
+                auto const owned = record.id ? shard.owns_id(asset_id::to_number(*record.id))
+                                             : shard.owns_line(record.line_number);
+                if (!owned)
+                {
+                    continue;
+                }
+                ++num_lines;
+
+                auto repeated = false;
+                if (dedup && record.id)
+                {
+                    auto const number = asset_id::to_number(*record.id);
+                    repeated = seen.test(number);
+                    seen.set(number);
+                }
+
+                slot.repeated.set(num_records, repeated);
+                num_ids += (record.id && !repeated) ? 1U : 0U;
+                ++num_records;
+            }
+            scan_timer.set_items(num_lines);
+        }
+        add_count(asset_id::stats_counter::lines, num_lines);
+        add_count(asset_id::stats_counter::ids, num_ids);
+
+        if (num_records == 0U)
+        {
+            break;
+        }
+
+        slot.num_records = num_records;
+        slot.state.store(slot_state::scanned, std::memory_order_relaxed);
+        pipeline.num_batches.store(sequence + 1U, std::memory_order_release);
+        pipeline.scanned.push(slot_index);
+
+        if (num_records < batch_num_lines)
+        {
+            break;
+        }
+    }
+
+    pipeline.reading.store(false, std::memory_order_release);
+    pipeline.scanned.close();
+    pipeline.processed.notify_all();
+}
+
+/**
+ * @brief The compute and encode stages, run by every worker on each batch it takes: look up
+ * the rendered id of every well formed record, encode it when the sink wants the builtin
+ * encoding and, when the sink is concurrent, write the batch.
+ */
+void process_slot(batch_slot& slot, asset_id::output_sink& sink)
+{
+    slot.pending.clear();
+    slot.pending_index.clear();
+    for (auto index = std::size_t{0U}; index < slot.num_records; ++index)
+    {
+        auto const& record = slot.records[index];
+        auto& item = slot.items[index];
+        item = asset_id::output_item{};
+        if (!record.id)
+        {
+            item.error = record.id.error();
+            continue;
+        }
+
+        if (slot.repeated.test(index))
+        {
+            continue;
+        }
+
+        item.file_stem = record.text;
+        item.rendered = &asset_id::lookup_rendered_id(*record.id);
+        slot.pending.push_back(item);
+        slot.pending_index.push_back(index);
+    }
+
+    auto const num_pending = slot.pending.size();
+    if (sink.wants_encoded())
+    {
+        auto const timer = asset_id::stage_timer{asset_id::stats_stage::encode, num_pending};
+        for (auto pending = std::size_t{0U}; pending < num_pending; ++pending)
+        {
+            slot.encoded[pending] = asset_id::encode_png(slot.pending[pending].rendered->pixels);
+            slot.pending[pending].encoded = &slot.encoded[pending];
+        }
+    }
+
+    if (sink.is_concurrent())
+    {
+        sink.write(slot.pending.data(), num_pending);
+    }
+}
+
+/**
+ * @brief Copy the outcome of every pending item of `slot` back to the item of its record.
+ */
+void settle_pending(batch_slot& slot)
+{
+    for (auto pending = std::size_t{0U}; pending < slot.pending.size(); ++pending)
+    {
+        slot.items[slot.pending_index[pending]] = slot.pending[pending];
+    }
+}
+
+/**
+ * @brief Wait until batch `sequence` has been processed by a worker.
+ *
+ * @return false  if the reader has finished without scanning batch `sequence`.
+ */
+bool wait_for_batch(pipeline_state& pipeline, std::size_t const sequence)
+{
+    auto const& slot = pipeline.slots[sequence % num_batch_slots];
+    auto const processed = [&slot]()
+    { return slot.state.load(std::memory_order_acquire) == slot_state::processed; };
+    auto const never_scanned = [&pipeline, sequence]()
+    {
+        return !pipeline.reading.load(std::memory_order_acquire) &&
+               (sequence >= pipeline.num_batches.load(std::memory_order_acquire));
+    };
+
+    pipeline.processed.wait_until([&]() { return processed() || never_scanned(); });
+    return processed();
+}
+
+/**
+ * @brief Adds the outcome of each item to a summary. Every failure is counted and written to
+ * `stream`, when given, straight away, but only the first `max_samples` are kept in memory.
+ *
+ * The items a sink defers are held, along with every failure after them, until the sink
+ * settles them, so the failures are still recorded in input order.
+ *
+ * A repeat of an id is counted as a duplicate if the first line of the id was written, and as
+ * a failure with the same error if it was not; it is held like a failure until that is known.
+ */
+class outcome_recorder
+{
+public:
+    outcome_recorder(
+        asset_id::batch_summary& summary, std::size_t const max_samples, std::ostream* const stream
+    ):
+        _summary(summary),
+        _max_samples(max_samples),
+        _stream(stream)
+    {
+    }
+
+    /**
+     * @param number  the id of the line, or `no_id` if it holds none.
+     */
+    void record(
+        asset_id::output_item const& item,
+        std::size_t const line_number,
+        std::string_view const text,
+        std::uint32_t const number
+    )
+    {
+        if (item.deferred)
+        {
+            _held.push_back({line_number, std::string{text}, item.error, number, true, false});
+        }
+        else if (!item.written)
+        {
+            record_failure(line_number, text, item.error, number);
+        }
+        else if (item.unchanged)
+        {
+            ++_summary.unchanged;
+        }
+        else
+        {
+            ++_summary.written;
+        }
+    }
+
+    void record_failure(
+        std::size_t const line_number,
+        std::string_view const text,
+        asset_id::error_code const error,
+        std::uint32_t const number = no_id
+    )
+    {
+        if (!_held.empty())
+        {
+            _held.push_back({line_number, std::string{text}, error, number, false, false});
+            return;
+        }
+
+        add_failure(line_number, text, error, number);
+    }
+
+    /**
+     * @brief Record a line that repeats the id `number` of an earlier line.
+     */
+    void record_repeat(
+        std::size_t const line_number, std::string_view const text, std::uint32_t const number
+    )
+    {
+        if (!_held.empty())
+        {
+            _held.push_back({line_number, std::string{text}, {}, number, false, true});
+            return;
+        }
+
+        add_repeat(line_number, text, number);
+    }
+
+    /**
+     * @brief Record the outcome of the deferred items `sink` has settled since the last call.
+     *
+     * @param complete  set once `settle_all` has been called on the sink; any item still
+     *                  deferred is then recorded as failed.
+     */
+    void settle(asset_id::output_sink& sink, bool const complete = false)
+    {
+        sink.take_settled(_settled);
+        for (auto const& outcome: _settled)
+        {
+            for (auto remaining = outcome.num_items; remaining > 0U; --remaining)
+            {
+                release_failures();
+                if (_held.empty())
+                {
+                    break;
+                }
+
+                auto const held = std::move(_held.front());
+                _held.pop_front();
+                if (outcome.written)
+                {
+                    ++_summary.written;
+                }
+                else
+                {
+                    add_failure(held.line_number, held.text, outcome.error, held.number);
+                }
+            }
+        }
+        _settled.clear();
+
+        release_failures();
+        while (complete && !_held.empty())
+        {
+            auto const held = std::move(_held.front());
+            _held.pop_front();
+            add_held(held);
+        }
+    }
+
+private:
+    struct held_outcome
+    {
+        std::size_t line_number;
+        std::string text;
+        asset_id::error_code error;
+        std::uint32_t number;
+        bool deferred;
+        bool repeat;
+    };
+
+    /**
+     * @brief Count a failure, write it to the stream and keep it as a sample if there is room.
+     */
+    void add_failure(
+        std::size_t const line_number,
+        std::string_view const text,
+        asset_id::error_code const error,
+        std::uint32_t const number
+    )
+    {
+        if (number != no_id)
+        {
+            _failed_ids.emplace(number, error);
+        }
+
+        ++_summary.num_failures;
+        ++_summary.failures_by_error[static_cast<std::size_t>(error)];
+
+        if (_stream)
+        {
+            *_stream << line_number << '\t' << asset_id::to_string(error) << '\t' << text << '\n';
+        }
+
+        if (_summary.failures.size() < _max_samples)
+        {
+            _summary.failures.push_back({line_number, std::string{text}, error});
+        }
+    }
+
+    /**
+     * @brief Count a repeat of `number` as a duplicate, or as a failure if `number` failed.
+     */
+    void add_repeat(
+        std::size_t const line_number, std::string_view const text, std::uint32_t const number
+    )
+    {
+        auto const failed = _failed_ids.find(number);
+        if (failed == _failed_ids.end())
+        {
+            ++_summary.duplicates;
+            return;
+        }
+
+        add_failure(line_number, text, failed->second, number);
+    }
+
+    void add_held(held_outcome const& held)
+    {
+        if (held.repeat)
+        {
+            add_repeat(held.line_number, held.text, held.number);
+        }
+        else
+        {
+            add_failure(held.line_number, held.text, held.error, held.number);
+        }
+    }
+
+    /**
+     * @brief Record the failures and repeats held behind deferred items that have since been
+     * settled.
+     */
+    void release_failures()
+    {
+        while (!_held.empty() && !_held.front().deferred)
+        {
+            auto const held = std::move(_held.front());
+            _held.pop_front();
+            add_held(held);
+        }
+    }
+
+    asset_id::batch_summary& _summary;
+    std::size_t _max_samples;
+    std::ostream* _stream;
+    std::deque<held_outcome> _held;
+    std::vector<asset_id::deferred_outcome> _settled;
+
+    /**
+     * @brief The error of each id whose file could not be written.
+     */
+    std::unordered_map<std::uint32_t, asset_id::error_code> _failed_ids;
+};
+
+/**
+ * @brief Write the ids `begin` to `end` (exclusive) of `range` owned by `shard` to `sink`, a
+ * chunk at a time, and add their outcomes to `recorder`.
+ *
+ * The file stems are taken from the digits of the precomputed checked ids, so no id is ever
+ * formatted or parsed. A failure is reported on the line the id would have in a list of the
+ * whole range, whichever shard writes it.
+ */
+void write_range_part(
+    asset_id::id_range const range,
+    asset_id::shard_spec const shard,
+    std::uint32_t const begin,
+    std::uint32_t const end,
+    asset_id::output_sink& sink,
+    outcome_recorder& recorder
+)
+{
+    auto const chunk_capacity = std::min<std::size_t>(chunk_num_lines, end - begin);
+    std::vector<asset_id::output_item> items(chunk_capacity);
+    std::vector<std::uint32_t> numbers(chunk_capacity);
+    std::vector<char> stems(chunk_capacity * asset_id::asset_id_length);
+
+    for (auto next = begin; next < end;)
+    {
+        auto num_ids = std::size_t{0U};
+        for (; (next < end) && (num_ids < chunk_capacity); ++next)
+        {
+            if (shard.owns_id(next))
+            {
+                numbers[num_ids++] = next;
+            }
+        }
+
+        for (auto index = std::size_t{0U}; index < num_ids; ++index)
+        {
+            auto const& rendered = asset_id::lookup_rendered_id(numbers[index]);
+            auto* const stem = stems.data() + index * asset_id::asset_id_length;
+            for (auto digit = 0U; digit < asset_id::asset_id_length; ++digit)
+            {
+                stem[digit] = static_cast<char>(
+                    '0' + rendered.checked_id[asset_id::checksum_length + digit].value()
+                );
+            }
+
+            auto& item = items[index];
+            item = asset_id::output_item{};
+            item.file_stem = std::string_view{stem, asset_id::asset_id_length};
+            item.rendered = &rendered;
+        }
+        add_count(asset_id::stats_counter::ids, num_ids);
+
+        sink.write(items.data(), num_ids);
+
+        for (auto index = std::size_t{0U}; index < num_ids; ++index)
+        {
+            auto const line_number = numbers[index] - range.first + 1U;
+            recorder.record(items[index], line_number, items[index].file_stem, numbers[index]);
+        }
+        recorder.settle(sink);
+    }
+}
+} // namespace
+
+namespace asset_id
+{
+batch_summary process_batch(
+    std::string_view const input,
+    options const& settings,
+    output_sink& sink,
+    std::ostream* const failure_stream
+)
+{
+    auto summary = batch_summary{};
+    auto recorder = outcome_recorder{summary, settings.failure_samples, failure_stream};
+
+    auto pipeline = std::make_unique<pipeline_state>();
+    auto reader =
+        std::thread{read_batches, input, settings.dedup, settings.shard, std::ref(*pipeline)};
+
+    auto const worker = [&sink, &pipeline = *pipeline]()
+    {
+        auto slot_index = std::size_t{0U};
+        while (pipeline.scanned.pop(slot_index))
+        {
+            auto& slot = pipeline.slots[slot_index];
+            process_slot(slot, sink);
+            slot.state.store(slot_state::processed, std::memory_order_release);
+            pipeline.processed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers{};
+    workers.reserve(settings.jobs);
+    for (auto thread_index = 0U; thread_index < settings.jobs; ++thread_index)
+    {
+        workers.emplace_back(worker);
+    }
+
+    // The writer stage runs on the calling thread and retires the batches in input order, so
+    // a sink that is not concurrent sees the ids in the order they were listed.
+    for (auto sequence = std::size_t{0U}; wait_for_batch(*pipeline, sequence); ++sequence)
+    {
+        auto& slot = pipeline->slots[sequence % num_batch_slots];
+        if (!sink.is_concurrent())
+        {
+            sink.write(slot.pending.data(), slot.pending.size());
+        }
+        settle_pending(slot);
+
+        for (auto index = std::size_t{0U}; index < slot.num_records; ++index)
+        {
+            auto const& record = slot.records[index];
+            auto const number = record.id ? asset_id::to_number(*record.id) : no_id;
+            if (slot.repeated.test(index))
+            {
+                recorder.record_repeat(record.line_number, record.text, number);
+            }
+            else
+            {
+                recorder.record(slot.items[index], record.line_number, record.text, number);
+            }
+        }
+        recorder.settle(sink);
+
+        slot.state.store(slot_state::free, std::memory_order_release);
+        pipeline->freed.notify_all();
+    }
+
+    reader.join();
+    for (auto& thread: workers)
+    {
+        thread.join();
+    }
+
+    sink.settle_all();
+    recorder.settle(sink, true);
+
+    return summary;
+}
+
+batch_summary process_range(
+    id_range const range,
+    options const& settings,
+    output_sink& sink,
+    std::ostream* const failure_stream
+)
+{
+    auto const end = range.last + 1U;
+    auto const num_ids = end - range.first;
+
+    // Part `p` holds the ids from `range.first + num_ids * p / num_parts`, so the parts differ in
+    // size by at most one id.
+    auto const num_parts =
+        sink.is_concurrent() ? std::min<std::size_t>(settings.jobs, num_ids) : std::size_t{1U};
+    auto const part_begin = [&](std::size_t const part)
+    {
+        return range.first + static_cast<std::uint32_t>(num_ids * part / num_parts);
+    };
+
+    // A range holds at most `num_asset_ids()` ids, so every failure of a part can be kept until
+    // the parts are merged.
+    std::vector<batch_summary> parts(num_parts);
+    std::vector<outcome_recorder> part_recorders{};
+    part_recorders.reserve(num_parts);
+    for (auto part = std::size_t{0U}; part < num_parts; ++part)
+    {
+        part_recorders.emplace_back(parts[part], num_ids, nullptr);
+    }
+
+    auto const worker = [&](std::size_t const part)
+    {
+        write_range_part(
+            range,
+            settings.shard,
+            part_begin(part),
+            part_begin(part + 1U),
+            sink,
+            part_recorders[part]
+        );
+    };
+
+    std::vector<std::thread> threads{};
+    threads.reserve(num_parts - 1U);
+    for (auto part = std::size_t{1U}; part < num_parts; ++part)
+    {
+        threads.emplace_back(worker, part);
+    }
+
+    worker(0U);
+
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    // Only a sink that is not concurrent defers items, and it is written as a single part.
+    sink.settle_all();
+    part_recorders.front().settle(sink, true);
+
+    // The parts are contiguous, so recording their failures part by part keeps them in range
+    // order.
+    auto summary = batch_summary{};
+    auto recorder = outcome_recorder{summary, settings.failure_samples, failure_stream};
+    for (auto const& part: parts)
+    {
+        for (auto const& failure: part.failures)
+        {
+            recorder.record_failure(failure.line_number, failure.text, failure.error);
+        }
+        summary.written += part.written;
+        summary.unchanged += part.unchanged;
+    }
+
+    return summary;
+}
+} // namespace asset_id
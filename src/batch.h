@@ -0,0 +1,156 @@
+/**
+ * @file   batch.h
+ * @brief  Drives the generation of png files for every id listed in an input buffer, or for
+ *         every id in a range.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "options.h"
+#include "output_sink.h"
+#include "result.h"
+
+namespace asset_id
+{
+/**
+ * @brief The `batch_failure` type records an input line for which no png file was generated.
+ */
+struct batch_failure
+{
+    /**
+     * @brief The 1-based number of the line in the input.
+     */
+    std::size_t line_number = 0U;
+
+    /**
+     * @brief The original text of the line, excluding the line terminator.
+     */
+    std::string text;
+
+    /**
+     * @brief Why no png file was generated for the line.
+     */
+    error_code error = error_code::bad_length;
+
+    bool operator==(batch_failure const& other) const
+    {
+        return (line_number == other.line_number) && (text == other.text) &&
+               (error == other.error);
+    }
+};
+
+/**
+ * @brief The `batch_summary` type holds the outcome of a call to `process_batch`.
+ */
+struct batch_summary
+{
+    /**
+     * @brief The first `options::failure_samples` lines for which no png file could be
+     * generated, in input order; the remainder are only counted.
+     */
+    std::vector<batch_failure> failures;
+
+    /**
+     * @brief The number of lines for which no png file could be generated.
+     */
+    std::size_t num_failures = 0U;
+
+    /**
+     * @brief The number of failed lines for each error code, indexed by the value of the error
+     * code.
+     */
+    std::array<std::size_t, num_error_codes> failures_by_error{};
+
+    /**
+     * @brief The number of well formed lines skipped because their id had already been seen
+     * and written; a repeat of an id that could not be written is counted as a failure instead.
+     */
+    std::size_t duplicates = 0U;
+
+    /**
+     * @brief The number of png files written to the sink.
+     */
+    std::size_t written = 0U;
+
+    /**
+     * @brief The number of png files left untouched because they were already up to date.
+     */
+    std::size_t unchanged = 0U;
+};
+
+/**
+ * @brief Generate a png file in `sink` for every id listed, one per line, in `input`.
+ *
+ * The work runs as a pipeline of stages joined by bounded queues. A reader thread scans the
+ * lines into fixed size batches; `settings.jobs` worker threads take the batches in any order,
+ * look up the rendered ids and, when the sink wants the builtin encoding, encode them; the
+ * calling thread retires the batches in input order. A concurrent sink is written to by the
+ * workers, otherwise each batch is handed to the sink by the calling thread. Only a fixed
+ * number of batches is ever in flight: the reader waits while all of them are in use, so the
+ * pipeline runs at the speed of its slowest stage in constant memory. The files written, and
+ * the failures returned, do not depend on the number of jobs.
+ *
+ * Unless `settings.dedup` is cleared, only the first occurrence of each id is processed; later
+ * occurrences are counted and skipped, or reported with the error of the first one if its file
+ * could not be written.
+ *
+ * Only the first `settings.failure_samples` failures are kept in the summary, so memory use
+ * does not grow with the number of failures. Every failure is written to `failure_stream`, when
+ * given, as a `<line number>\t<reason>\t<text>` line, in input order, once the batch holding
+ * it has been retired.
+ *
+ * A sink may defer files whose outcome is only known later, such as the rows of a sprite
+ * sheet; they, and any failure after them, are recorded once the sink settles them. Once every
+ * file has been handed over the sink is asked to settle the rest with `settle_all`, but it is
+ * left to the caller to `finish` it.
+ *
+ * @param input           the buffer holding the ids, one per line; typically a `mapped_file`.
+ * @param settings        the number of jobs, whether to skip duplicates and the number of
+ *                        failures kept; the remaining options are ignored.
+ * @param sink            the destination of the png files.
+ * @param failure_stream  when not null, receives every failure as it occurs.
+ *
+ * @return batch_summary holding the number of failed lines, a sample of them with the reason
+ *         each failed, and the number of files written, left unchanged and skipped as
+ *         duplicates.
+ */
+batch_summary process_batch(
+    std::string_view input,
+    options const& settings,
+    output_sink& sink,
+    std::ostream* failure_stream = nullptr
+);
+
+/**
+ * @brief Generate a png file in `sink` for every id in `range`, without reading any input.
+ *
+ * The ids are generated directly from their numeric values, so there is no scanning, parsing
+ * or deduplication. With a concurrent sink the range is split into `settings.jobs` contiguous
+ * parts, each written by its own thread; otherwise the ids are handed to the sink in increasing
+ * order, a chunk at a time, from the calling thread.
+ *
+ * Failures are sampled and streamed as by `process_batch`, once every id has been written.
+ *
+ * @param range           the ids to generate; `range.last` must be less than `num_asset_ids()`.
+ * @param settings        the number of jobs and failures kept; the remaining options are
+ *                        ignored.
+ * @param sink            the destination of the png files.
+ * @param failure_stream  when not null, receives every failure.
+ *
+ * @return batch_summary holding the ids that could not be written, in increasing order, with
+ *         their 1-based position in the range as their line number, and the number of files
+ *         written and left unchanged.
+ */
+batch_summary process_range(
+    id_range range,
+    options const& settings,
+    output_sink& sink,
+    std::ostream* failure_stream = nullptr
+);
+} // namespace asset_id
@@ -0,0 +1,147 @@
+#include "batch_api.h"
+
+#include "id_table.h"
+
+namespace
+{
+/**
+ * @brief Find the table entry for an id string directly from its characters, without building
+ * its digits through `create_asset_id`.
+ */
+asset_id::item_status resolve(std::string_view const id, asset_id::rendered_id_t const*& rendered)
+{
+    if (id.size() != asset_id::asset_id_length)
+    {
+        return asset_id::item_status::bad_length;
+    }
+
+    auto number = std::uint32_t{0U};
+    for (auto const c: id)
+    {
+        if ((c < '0') || (c > '9'))
+        {
+            return asset_id::item_status::bad_digit;
+        }
+        number = number * 10U + static_cast<std::uint32_t>(c - '0');
+    }
+
+    rendered = &asset_id::lookup_rendered_id(number);
+    return asset_id::item_status::ok;
+}
+
+asset_id::item_status resolve(std::uint32_t const id, asset_id::rendered_id_t const*& rendered)
+{
+    if (id >= asset_id::num_asset_ids())
+    {
+        return asset_id::item_status::out_of_range;
+    }
+
+    rendered = &asset_id::lookup_rendered_id(id);
+    return asset_id::item_status::ok;
+}
+
+/**
+ * @brief Resolve every id, storing `produce(rendered)` for each one that is well formed.
+ */
+template<typename Id, typename Output, typename Produce>
+std::size_t run_batch(
+    Id const* const ids,
+    std::size_t const num_ids,
+    Output* const outputs,
+    asset_id::item_status* const statuses,
+    Produce const& produce
+)
+{
+    auto num_ok = std::size_t{0U};
+    for (auto index = std::size_t{0U}; index < num_ids; ++index)
+    {
+        auto const* rendered = static_cast<asset_id::rendered_id_t const*>(nullptr);
+        statuses[index] = resolve(ids[index], rendered);
+        if (statuses[index] == asset_id::item_status::ok)
+        {
+            outputs[index] = produce(*rendered);
+            ++num_ok;
+        }
+    }
+
+    return num_ok;
+}
+
+asset_id::checked_asset_id_t const& checked_id_of(asset_id::rendered_id_t const& rendered)
+{
+    return rendered.checked_id;
+}
+
+asset_id::image_line_t const& line_of(asset_id::rendered_id_t const& rendered)
+{
+    return rendered.pixels;
+}
+
+asset_id::encoded_png_t png_of(asset_id::rendered_id_t const& rendered)
+{
+    return asset_id::encode_png(rendered.pixels);
+}
+} // namespace
+
+namespace asset_id
+{
+std::size_t make_checked_ids(
+    std::string_view const* const ids,
+    std::size_t const num_ids,
+    checked_asset_id_t* const checked_ids,
+    item_status* const statuses
+)
+{
+    return run_batch(ids, num_ids, checked_ids, statuses, checked_id_of);
+}
+
+std::size_t make_checked_ids(
+    std::uint32_t const* const ids,
+    std::size_t const num_ids,
+    checked_asset_id_t* const checked_ids,
+    item_status* const statuses
+)
+{
+    return run_batch(ids, num_ids, checked_ids, statuses, checked_id_of);
+}
+
+std::size_t render_lines(
+    std::string_view const* const ids,
+    std::size_t const num_ids,
+    image_line_t* const lines,
+    item_status* const statuses
+)
+{
+    return run_batch(ids, num_ids, lines, statuses, line_of);
+}
+
+std::size_t render_lines(
+    std::uint32_t const* const ids,
+    std::size_t const num_ids,
+    image_line_t* const lines,
+    item_status* const statuses
+)
+{
+    return run_batch(ids, num_ids, lines, statuses, line_of);
+}
+
+std::size_t encode_pngs(
+    std::string_view const* const ids,
+    std::size_t const num_ids,
+    encoded_png_t* const pngs,
+    item_status* const statuses
+)
+{
+    return run_batch(ids, num_ids, pngs, statuses, png_of);
+}
+
+std::size_t encode_pngs(
+    std::uint32_t const* const ids,
+    std::size_t const num_ids,
+    encoded_png_t* const pngs,
+    item_status* const statuses
+)
+{
+    return run_batch(ids, num_ids, pngs, statuses, png_of);
+}
+} // namespace asset_id
@@ -0,0 +1,130 @@
+/**
+ * @file   batch_api.h
+ * @brief  A batch interface for embedding the generator in other programs.
+ *
+ * Every function takes a run of ids, either as strings or as numeric values, and writes one
+ * result and one status per id into arrays owned by the caller. Nothing is allocated on the
+ * heap and nothing is written to standard output, so the functions can be called from any
+ * thread of a service; all of the work is a lookup in the precomputed id table, plus the png
+ * encoding for `encode_pngs`.
+ *
+ * An output entry is only written when its status is `item_status::ok`; the entries of failed
+ * ids are left untouched.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "asset_id.h"
+#include "image_line.h"
+#include "png_encoder.h"
+
+namespace asset_id
+{
+/**
+ * @brief The outcome for a single id passed to a batch function.
+ */
+enum class item_status : std::uint8_t
+{
+    ok,
+
+    /**
+     * @brief The id string does not have exactly `asset_id_length` characters.
+     */
+    bad_length,
+
+    /**
+     * @brief The id string holds a character that is not a decimal digit.
+     */
+    bad_digit,
+
+    /**
+     * @brief The numeric id is not less than `num_asset_ids()`.
+     */
+    out_of_range,
+};
+
+/**
+ * @brief Look up the checked id (checksum digits followed by the id digits) of every id.
+ *
+ * @param ids          the ids to look up.
+ * @param num_ids      the number of entries in `ids`, `checked_ids` and `statuses`.
+ * @param checked_ids  receives the checked id of each well formed id.
+ * @param statuses     receives the outcome for each id.
+ *
+ * @return std::size_t holding the number of ids whose status is `item_status::ok`.
+ */
+std::size_t make_checked_ids(
+    std::string_view const* ids,
+    std::size_t num_ids,
+    checked_asset_id_t* checked_ids,
+    item_status* statuses
+);
+
+/**
+ * @copydoc make_checked_ids(std::string_view const*, std::size_t, checked_asset_id_t*, item_status*)
+ */
+std::size_t make_checked_ids(
+    std::uint32_t const* ids,
+    std::size_t num_ids,
+    checked_asset_id_t* checked_ids,
+    item_status* statuses
+);
+
+/**
+ * @brief Look up the rendered image line of every id.
+ *
+ * @param ids       the ids to render.
+ * @param num_ids   the number of entries in `ids`, `lines` and `statuses`.
+ * @param lines     receives the image line of each well formed id.
+ * @param statuses  receives the outcome for each id.
+ *
+ * @return std::size_t holding the number of ids whose status is `item_status::ok`.
+ */
+std::size_t render_lines(
+    std::string_view const* ids,
+    std::size_t num_ids,
+    image_line_t* lines,
+    item_status* statuses
+);
+
+/**
+ * @copydoc render_lines(std::string_view const*, std::size_t, image_line_t*, item_status*)
+ */
+std::size_t render_lines(
+    std::uint32_t const* ids,
+    std::size_t num_ids,
+    image_line_t* lines,
+    item_status* statuses
+);
+
+/**
+ * @brief Encode the complete png file of every id, byte for byte the same as the files written
+ * by the builtin png backend.
+ *
+ * @param ids       the ids to encode.
+ * @param num_ids   the number of entries in `ids`, `pngs` and `statuses`.
+ * @param pngs      receives the png file of each well formed id.
+ * @param statuses  receives the outcome for each id.
+ *
+ * @return std::size_t holding the number of ids whose status is `item_status::ok`.
+ */
+std::size_t encode_pngs(
+    std::string_view const* ids,
+    std::size_t num_ids,
+    encoded_png_t* pngs,
+    item_status* statuses
+);
+
+/**
+ * @copydoc encode_pngs(std::string_view const*, std::size_t, encoded_png_t*, item_status*)
+ */
+std::size_t encode_pngs(
+    std::uint32_t const* ids,
+    std::size_t num_ids,
+    encoded_png_t* pngs,
+    item_status* statuses
+);
+} // namespace asset_id
@@ -0,0 +1,242 @@
+#include "checksum_batch.h"
+
+// SSE2 is part of the x86-64 baseline; AVX2 is enabled per function and checked at run time.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ASSET_ID_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define ASSET_ID_X86_KERNELS 0
+#endif
+
+namespace
+{
+static_assert(asset_id::asset_id_length == 4U, "The batch kernels sum exactly four digits.");
+static_assert(asset_id::digit::base() == 10U, "The batch kernels assume base 10 digits.");
+
+/**
+ * @brief `x / 97 == (x * divide_by_97_multiplier) >> divide_by_97_shift` for every `x` below
+ * 10000, which covers every digit sum; the test suite checks this exhaustively through the
+ * kernels.
+ */
+constexpr auto const divide_by_97_multiplier = 43241U;
+constexpr auto const divide_by_97_shift = 22U;
+
+/**
+ * @brief `r / 10 == (r * divide_by_10_multiplier) >> divide_by_10_shift` for every `r` below 97.
+ */
+constexpr auto const divide_by_10_multiplier = 205U;
+constexpr auto const divide_by_10_shift = 11U;
+
+constexpr auto const checksum_base = 97U;
+
+void checksums_scalar(
+    asset_id::soa_ids const& ids,
+    asset_id::soa_checksums const& checksums,
+    std::size_t const begin
+)
+{
+    for (auto index = begin; index < ids.size; ++index)
+    {
+        // Digit `d` has weight 10^d, exactly as in `calculate_checksum`.
+        auto const sum = ids.digits[0][index] + 10U * ids.digits[1][index] +
+                         100U * ids.digits[2][index] + 1000U * ids.digits[3][index];
+        auto const remainder = sum % checksum_base;
+        checksums.hi[index] = static_cast<std::uint8_t>(remainder / 10U);
+        checksums.lo[index] = static_cast<std::uint8_t>(remainder % 10U);
+    }
+}
+
+#if ASSET_ID_X86_KERNELS
+/**
+ * @brief Split eight digit sums, in 16-bit lanes, into the high and low checksum digits.
+ */
+void split_checksums_sse2(__m128i const sum, __m128i& hi, __m128i& lo)
+{
+    auto const quotient = _mm_srli_epi16(
+        _mm_mulhi_epu16(sum, _mm_set1_epi16(static_cast<short>(divide_by_97_multiplier))),
+        divide_by_97_shift - 16U
+    );
+    auto const remainder =
+        _mm_sub_epi16(sum, _mm_mullo_epi16(quotient, _mm_set1_epi16(checksum_base)));
+
+    hi = _mm_srli_epi16(
+        _mm_mullo_epi16(remainder, _mm_set1_epi16(divide_by_10_multiplier)), divide_by_10_shift
+    );
+    lo = _mm_sub_epi16(remainder, _mm_mullo_epi16(hi, _mm_set1_epi16(10)));
+}
+
+/**
+ * @brief Sum the digits of eight ids held in the 16-bit lanes of each argument.
+ */
+__m128i digit_sum_sse2(__m128i const d0, __m128i const d1, __m128i const d2, __m128i const d3)
+{
+    auto sum = _mm_add_epi16(d0, _mm_mullo_epi16(d1, _mm_set1_epi16(10)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(d2, _mm_set1_epi16(100)));
+    return _mm_add_epi16(sum, _mm_mullo_epi16(d3, _mm_set1_epi16(1000)));
+}
+
+void checksums_sse2(asset_id::soa_ids const& ids, asset_id::soa_checksums const& checksums)
+{
+    constexpr auto const block = std::size_t{16U};
+
+    auto const zero = _mm_setzero_si128();
+    auto index = std::size_t{0U};
+    for (; index + block <= ids.size; index += block)
+    {
+        __m128i low_half[asset_id::asset_id_length];
+        __m128i high_half[asset_id::asset_id_length];
+        for (auto digit = std::size_t{0U}; digit < asset_id::asset_id_length; ++digit)
+        {
+            auto const bytes =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(ids.digits[digit] + index));
+            low_half[digit] = _mm_unpacklo_epi8(bytes, zero);
+            high_half[digit] = _mm_unpackhi_epi8(bytes, zero);
+        }
+
+        __m128i hi_low, lo_low, hi_high, lo_high;
+        split_checksums_sse2(
+            digit_sum_sse2(low_half[0], low_half[1], low_half[2], low_half[3]), hi_low, lo_low
+        );
+        split_checksums_sse2(
+            digit_sum_sse2(high_half[0], high_half[1], high_half[2], high_half[3]),
+            hi_high,
+            lo_high
+        );
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(checksums.hi + index), _mm_packus_epi16(hi_low, hi_high)
+        );
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(checksums.lo + index), _mm_packus_epi16(lo_low, lo_high)
+        );
+    }
+
+    checksums_scalar(ids, checksums, index);
+}
+
+__attribute__((target("avx2"))) void
+split_checksums_avx2(__m256i const sum, __m256i& hi, __m256i& lo)
+{
+    auto const quotient = _mm256_srli_epi16(
+        _mm256_mulhi_epu16(sum, _mm256_set1_epi16(static_cast<short>(divide_by_97_multiplier))),
+        divide_by_97_shift - 16U
+    );
+    auto const remainder =
+        _mm256_sub_epi16(sum, _mm256_mullo_epi16(quotient, _mm256_set1_epi16(checksum_base)));
+
+    hi = _mm256_srli_epi16(
+        _mm256_mullo_epi16(remainder, _mm256_set1_epi16(divide_by_10_multiplier)),
+        divide_by_10_shift
+    );
+    lo = _mm256_sub_epi16(remainder, _mm256_mullo_epi16(hi, _mm256_set1_epi16(10)));
+}
+
+/**
+ * @brief Widen one digit of sixteen ids into 16-bit lanes.
+ */
+__attribute__((target("avx2"))) __m256i
+load_digits_avx2(asset_id::soa_ids const& ids, std::size_t const digit, std::size_t const index)
+{
+    return _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(ids.digits[digit] + index))
+    );
+}
+
+/**
+ * @brief Sum the digits of sixteen ids into 16-bit lanes.
+ */
+__attribute__((target("avx2"))) __m256i
+digit_sum_avx2(asset_id::soa_ids const& ids, std::size_t const index)
+{
+    auto sum = _mm256_add_epi16(
+        load_digits_avx2(ids, 0U, index),
+        _mm256_mullo_epi16(load_digits_avx2(ids, 1U, index), _mm256_set1_epi16(10))
+    );
+    sum = _mm256_add_epi16(
+        sum, _mm256_mullo_epi16(load_digits_avx2(ids, 2U, index), _mm256_set1_epi16(100))
+    );
+    return _mm256_add_epi16(
+        sum, _mm256_mullo_epi16(load_digits_avx2(ids, 3U, index), _mm256_set1_epi16(1000))
+    );
+}
+
+__attribute__((target("avx2"))) void
+checksums_avx2(asset_id::soa_ids const& ids, asset_id::soa_checksums const& checksums)
+{
+    constexpr auto const block = std::size_t{32U};
+
+    auto index = std::size_t{0U};
+    for (; index + block <= ids.size; index += block)
+    {
+        __m256i hi_first, lo_first, hi_second, lo_second;
+        split_checksums_avx2(digit_sum_avx2(ids, index), hi_first, lo_first);
+        split_checksums_avx2(digit_sum_avx2(ids, index + 16U), hi_second, lo_second);
+
+        // Packing works within each 128-bit lane, so the 64-bit quarters are put back in order.
+        auto const hi = _mm256_permute4x64_epi64(_mm256_packus_epi16(hi_first, hi_second), 0xD8);
+        auto const lo = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo_first, lo_second), 0xD8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(checksums.hi + index), hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(checksums.lo + index), lo);
+    }
+
+    // The remaining ids are fewer than a register's worth; a narrower kernel finishes them.
+    auto tail = asset_id::soa_ids{{}, ids.size - index};
+    for (auto digit = std::size_t{0U}; digit < asset_id::asset_id_length; ++digit)
+    {
+        tail.digits[digit] = ids.digits[digit] + index;
+    }
+    checksums_sse2(tail, {checksums.hi + index, checksums.lo + index});
+}
+#endif
+} // namespace
+
+namespace asset_id
+{
+bool is_supported(simd_level const level)
+{
+    switch (level)
+    {
+        case simd_level::scalar:
+            return true;
+#if ASSET_ID_X86_KERNELS
+        case simd_level::sse2:
+            return true;
+        case simd_level::avx2:
+            return __builtin_cpu_supports("avx2");
+#else
+        case simd_level::sse2:
+        case simd_level::avx2:
+            return false;
+#endif
+    }
+
+    return false;
+}
+
+simd_level best_simd_level()
+{
+    static auto const best = is_supported(simd_level::avx2)   ? simd_level::avx2
+                              : is_supported(simd_level::sse2) ? simd_level::sse2
+                                                               : simd_level::scalar;
+    return best;
+}
+
+void calculate_checksums(soa_ids const& ids, soa_checksums const& checksums, simd_level const level)
+{
+    switch (level)
+    {
+#if ASSET_ID_X86_KERNELS
+        case simd_level::avx2:
+            checksums_avx2(ids, checksums);
+            return;
+        case simd_level::sse2:
+            checksums_sse2(ids, checksums);
+            return;
+#endif
+        default:
+            checksums_scalar(ids, checksums, 0U);
+            return;
+    }
+}
+} // namespace asset_id
@@ -0,0 +1,76 @@
+/**
+ * @file   checksum_batch.h
+ * @brief  Calculates the checksums of a large block of ids at once, with SIMD where available.
+ *
+ * The ids are passed in structure-of-arrays layout: one array per digit position, each holding
+ * that digit of every id. A whole register of ids is then summed, reduced modulo 97 and split
+ * into its two checksum digits with a handful of 16-bit multiplies, replacing the divisions of
+ * `calculate_checksum` with multiplications by constants. The widest kernel the host supports is
+ * picked at run time; every kernel gives exactly the result of `calculate_checksum`.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "asset_id.h"
+
+namespace asset_id
+{
+/**
+ * @brief The instruction sets a batch kernel can be built for.
+ */
+enum class simd_level : std::uint8_t
+{
+    scalar,
+    sse2,
+    avx2,
+};
+
+/**
+ * @return true   if the kernel for `level` is built into the tool and the host CPU supports it.
+ * @return false  otherwise.
+ */
+bool is_supported(simd_level level);
+
+/**
+ * @return simd_level holding the widest kernel supported by the host CPU.
+ */
+simd_level best_simd_level();
+
+/**
+ * @brief A block of ids in structure-of-arrays layout: `digits[d][i]` is the value (0 to 9, not
+ * a character) of digit `d` of id `i`, with digits in the order of `asset_id_t`.
+ */
+struct soa_ids
+{
+    std::array<std::uint8_t const*, asset_id_length> digits{};
+    std::size_t size = 0U;
+};
+
+/**
+ * @brief The checksums of a block of ids, also in structure-of-arrays layout: the checksum of
+ * id `i` is `hi[i]` followed by `lo[i]`, as in `checksum_t`.
+ */
+struct soa_checksums
+{
+    std::uint8_t* hi = nullptr;
+    std::uint8_t* lo = nullptr;
+};
+
+/**
+ * @brief Calculate the checksum of every id in a block, as `create_checked_asset_id` does: with
+ * base 10 digits and a checksum base of 97.
+ *
+ * @param ids        the ids; every digit must be in the range 0 to 9.
+ * @param checksums  receives the checksum digits of every id; both arrays must hold at least
+ *                   `ids.size` entries.
+ * @param level      the kernel to use; it must be supported.
+ */
+void calculate_checksums(
+    soa_ids const& ids,
+    soa_checksums const& checksums,
+    simd_level level = best_simd_level()
+);
+} // namespace asset_id
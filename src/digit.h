@@ -5,7 +5,8 @@
 #pragma once
 
 #include <cstdint>
-#include <optional>
+
+#include "result.h"
 
 namespace asset_id
 {
@@ -42,10 +43,10 @@ public:
     *
     * @param character the integer to try to instantiate as a digit.
     *
-    * @return std::optional<digit> containing the correct instance of `digit` if this 
-    *         exists; empty optional otherwise.
+    * @return result<digit> containing the correct instance of `digit` if this exists;
+    *         `error_code::bad_digit` otherwise.
     */
-    static std::optional<digit> from_int(value_t integer_value);
+    static constexpr result<digit> from_int(value_t integer_value);
 
     /**
     * @brief Attempt to create an instance of `digit` from a character.
@@ -54,15 +55,18 @@ public:
     * 
     * @param character the character to try to instantiate as a digit.
     *
-    * @return std::optional<digit> containing the correct instance of `digit` if this 
-    *         exists; empty optional otherwise.
+    * @return result<digit> containing the correct instance of `digit` if this exists;
+    *         `error_code::bad_digit` otherwise.
     */
-    static std::optional<digit> from_char(char character);
+    static constexpr result<digit> from_char(char character);
 
     /**
      * @return value_t holding the value of this instance of `digit`.
      */
-    value_t value() const { return _value; }
+    constexpr value_t value() const { return _value; }
+
+    constexpr bool operator==(digit const other) const { return _value == other._value; }
+    constexpr bool operator!=(digit const other) const { return _value != other._value; }
 
 private:
     /**
@@ -73,7 +77,7 @@ private:
     * @param value The value of the digit to construct; assumed to be in the expected 
     *              range for the digit base.
     */
-    explicit digit(value_t value):
+    explicit constexpr digit(value_t value):
         _value(value)
     {
     }
@@ -91,7 +95,36 @@ private:
     */
     static constexpr bool is_digit(char value);
 
-    value_t _value;
+    value_t _value{0U};
 };
 
+constexpr bool digit::is_digit(char const value)
+{
+    static_assert(digit::base() == 10U, "digit::from_char is assuming base 10 digits are used.");
+
+    return (value >= '0') && (value <= '9');
+}
+
+constexpr result<digit> digit::from_int(value_t const integer_value)
+{
+    static_assert(digit::base() == 10U, "digit::from_int is assuming base 10 digits are used.");
+    if (integer_value >= digit::base())
+    {
+        return error_code::bad_digit;
+    }
+
+    return digit{integer_value};
+}
+
+constexpr result<digit> digit::from_char(char const character)
+{
+    static_assert(digit::base() == 10U, "digit::from_char is assuming base 10 digits are used.");
+    if (!is_digit(character))
+    {
+        return error_code::bad_digit;
+    }
+
+    return digit{static_cast<std::uint8_t>(character - '0')};
+}
+
 } // namespace asset_id
\ No newline at end of file
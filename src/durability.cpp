@@ -0,0 +1,79 @@
+#include "durability.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+
+#include "logger.h"
+#include "stats.h"
+
+namespace
+{
+/**
+ * @brief Run `sync` on `fd`, recording how long it took and logging any error.
+ */
+template<typename Sync>
+bool timed_sync(int const fd, char const* const name, Sync&& sync)
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto const synced = (sync(fd) == 0);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    asset_id::record_stage(
+        asset_id::stats_stage::sync,
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+        )
+    );
+    asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+
+    if (!synced)
+    {
+        asset_id::log_message(
+            asset_id::log_level::error, "Failed to ", name, " the output: ", std::strerror(errno)
+        );
+    }
+    return synced;
+}
+} // namespace
+
+namespace asset_id
+{
+bool sync_file(int const fd)
+{
+    return timed_sync(fd, "fsync", ::fsync);
+}
+
+bool sync_file_system(int const fd)
+{
+    return timed_sync(fd, "syncfs", ::syncfs);
+}
+
+void sync_schedule::files_written(int const fd, std::size_t const num_files)
+{
+    if ((_settings.mode != durability_mode::batch) || (num_files == 0U))
+    {
+        return;
+    }
+
+    // Only the writer whose files take the count past a multiple of the interval syncs, while
+    // the others carry on writing.
+    auto const before = _num_files.fetch_add(num_files, std::memory_order_relaxed);
+    auto const interval = _settings.sync_interval;
+    if (((before / interval) != ((before + num_files) / interval)) && !sync_file_system(fd))
+    {
+        _failed.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool sync_schedule::finish(int const fd)
+{
+    if ((_settings.mode != durability_mode::none) && !sync_file_system(fd))
+    {
+        _failed.store(true, std::memory_order_relaxed);
+    }
+
+    return !_failed.load(std::memory_order_relaxed);
+}
+} // namespace asset_id
@@ -0,0 +1,113 @@
+/**
+ * @file   durability.h
+ * @brief  Decides when the generated files are flushed to disk.
+ *
+ * Every file is complete and replaced atomically whatever the mode, but without a sync it can
+ * still be lost if the machine crashes before the kernel writes it back. `per_file` syncs each
+ * file, and the directory entry naming it, before the file is reported as written, at the cost
+ * of two synchronous disk writes per file. `batch` instead syncs the whole file system holding
+ * the output with a single `syncfs` each time another `sync_interval` files have been written,
+ * and again once the output is complete, so every file of a successful run is on disk before
+ * the tool exits.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace asset_id
+{
+/**
+ * @brief The `durability_mode` type selects when the generated files are synced to disk.
+ */
+enum class durability_mode
+{
+    none,
+    batch,
+    per_file,
+};
+
+/**
+ * @brief The number of files written between two syncs in `batch` mode, unless
+ * `--sync-interval` is given.
+ */
+constexpr std::size_t default_sync_interval = 4096U;
+
+/**
+ * @brief The `durability_settings` type holds the durability options of a run.
+ */
+struct durability_settings
+{
+    durability_mode mode = durability_mode::none;
+
+    /**
+     * @brief In `batch` mode, the number of files written between two syncs; always at least 1.
+     */
+    std::size_t sync_interval = default_sync_interval;
+};
+
+/**
+ * @brief Flush the data and metadata of the open file, or directory, `fd` to disk with `fsync`.
+ *
+ * Every call is recorded as the `sync` stage, whether or not stats are enabled, so that the
+ * summary of a run can report the time spent syncing.
+ *
+ * @return true   if the file was synced.
+ * @return false  otherwise; the error is logged.
+ */
+bool sync_file(int fd);
+
+/**
+ * @brief Flush every file of the file system holding `fd` to disk with `syncfs`; recorded as
+ * by `sync_file`.
+ *
+ * @return true   if the file system was synced.
+ * @return false  otherwise; the error is logged.
+ */
+bool sync_file_system(int fd);
+
+/**
+ * @brief Syncs the files written to a single output as its durability mode requires; may be
+ * shared by every thread writing the output.
+ */
+class sync_schedule
+{
+public:
+    explicit sync_schedule(durability_settings const& settings):
+        _settings(settings)
+    {
+    }
+
+    sync_schedule(sync_schedule const&) = delete;
+    sync_schedule& operator=(sync_schedule const&) = delete;
+
+    durability_mode mode() const { return _settings.mode; }
+
+    /**
+     * @return true  if every file must be synced by its writer before it is reported as
+     *               written.
+     */
+    bool per_file() const { return _settings.mode == durability_mode::per_file; }
+
+    /**
+     * @brief Count `num_files` more files written to the file system holding `fd`; in `batch`
+     * mode the file system is synced each time the count passes another multiple of the sync
+     * interval. A failed sync is logged and reported by `finish`.
+     */
+    void files_written(int fd, std::size_t num_files);
+
+    /**
+     * @brief Sync the file system holding `fd` once the output is complete, unless the mode is
+     * `none`.
+     *
+     * @return true   if the output is as durable as its mode requires.
+     * @return false  if this sync, or any earlier one, failed.
+     */
+    bool finish(int fd);
+
+private:
+    durability_settings _settings;
+    std::atomic<std::size_t> _num_files{0U};
+    std::atomic<bool> _failed{false};
+};
+} // namespace asset_id
@@ -0,0 +1,653 @@
+#include "http_server.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <charconv>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "id_table.h"
+#include "write_png.h"
+
+namespace
+{
+constexpr auto const max_events = 64;
+constexpr auto const read_buffer_num_bytes = std::size_t{16384U};
+
+/**
+ * @brief A request head larger than this is rejected rather than buffered without bound.
+ */
+constexpr auto const max_request_head_num_bytes = std::size_t{8192U};
+
+/**
+ * @brief Once this many bytes of answers wait to be sent to a client, its requests are neither
+ * read nor answered until the client has taken some of them, so that a client that sends
+ * without reading cannot make the server buffer without bound.
+ */
+constexpr auto const max_pending_output_num_bytes = std::size_t{1024U * 1024U};
+
+constexpr auto const png_suffix = std::string_view{".png"};
+constexpr auto const header_terminator = std::string_view{"\r\n\r\n"};
+
+constexpr auto const not_found_response = std::string_view{
+    "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n"};
+constexpr auto const method_not_allowed_response = std::string_view{
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\n"};
+constexpr auto const bad_request_response = std::string_view{
+    "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"};
+constexpr auto const connection_close = std::string_view{"Connection: close\r\n"};
+
+bool equals_ignoring_case(std::string_view const lhs, std::string_view const rhs)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+
+    for (auto index = std::size_t{0U}; index < lhs.size(); ++index)
+    {
+        auto const lower = [](char const c) { return ((c >= 'A') && (c <= 'Z')) ? c + 32 : c; };
+        if (lower(lhs[index]) != lower(rhs[index]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && ((text.front() == ' ') || (text.front() == '\t')))
+    {
+        text.remove_prefix(1U);
+    }
+    while (!text.empty() && ((text.back() == ' ') || (text.back() == '\t')))
+    {
+        text.remove_suffix(1U);
+    }
+    return text;
+}
+
+/**
+ * @brief The parts of a request head that the server acts upon.
+ */
+struct request_head
+{
+    std::string_view method;
+    std::string_view target;
+    bool keep_alive = true;
+    bool has_body = false;
+};
+
+/**
+ * @brief Parse a request head, excluding the blank line that ends it.
+ *
+ * HTTP/1.1 connections stay open unless the client sends `Connection: close`; HTTP/1.0
+ * connections only stay open if the client sends `Connection: keep-alive`. A request that
+ * declares a body through `Content-Length` (other than 0) or `Transfer-Encoding` is marked as
+ * having one.
+ */
+std::optional<request_head> parse_request_head(std::string_view head)
+{
+    auto const line_end = head.find("\r\n");
+    auto const request_line = head.substr(0U, line_end);
+    auto headers = (line_end == std::string_view::npos) ? std::string_view{}
+                                                        : head.substr(line_end + 2U);
+
+    auto const method_end = request_line.find(' ');
+    auto const target_end = request_line.find(' ', method_end + 1U);
+    if ((method_end == std::string_view::npos) || (target_end == std::string_view::npos))
+    {
+        return std::nullopt;
+    }
+
+    auto result = request_head{};
+    result.method = request_line.substr(0U, method_end);
+    result.target = request_line.substr(method_end + 1U, target_end - method_end - 1U);
+
+    auto const version = request_line.substr(target_end + 1U);
+    if (version == "HTTP/1.0")
+    {
+        result.keep_alive = false;
+    }
+    else if (version != "HTTP/1.1")
+    {
+        return std::nullopt;
+    }
+
+    while (!headers.empty())
+    {
+        auto const header_end = headers.find("\r\n");
+        auto const header = headers.substr(0U, header_end);
+        headers = (header_end == std::string_view::npos) ? std::string_view{}
+                                                         : headers.substr(header_end + 2U);
+
+        auto const colon = header.find(':');
+        if (colon == std::string_view::npos)
+        {
+            return std::nullopt;
+        }
+
+        auto const name = trim(header.substr(0U, colon));
+        auto const value = trim(header.substr(colon + 1U));
+        if (equals_ignoring_case(name, "connection"))
+        {
+            if (equals_ignoring_case(value, "close"))
+            {
+                result.keep_alive = false;
+            }
+            else if (equals_ignoring_case(value, "keep-alive"))
+            {
+                result.keep_alive = true;
+            }
+        }
+        else if (equals_ignoring_case(name, "content-length"))
+        {
+            result.has_body = result.has_body || (value != "0");
+        }
+        else if (equals_ignoring_case(name, "transfer-encoding"))
+        {
+            result.has_body = true;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Append `response`, a header lacking its closing blank line, to `output`.
+ */
+void append_response(std::string_view const response, bool const keep_alive, std::string& output)
+{
+    output.append(response);
+    if (!keep_alive)
+    {
+        output.append(connection_close);
+    }
+    output.append("\r\n");
+}
+
+/**
+ * @return asset_id::result<asset_id::asset_id_t> containing the id named by `target` if it has
+ *         the form `/NNNN.png`; `error_code::bad_destination` if it does not name a png file,
+ *         or the error of `create_asset_id` for its stem.
+ */
+asset_id::result<asset_id::asset_id_t> requested_id(std::string_view target)
+{
+    target = target.substr(0U, target.find('?'));
+    if ((target.size() < 1U + png_suffix.size()) || (target.front() != '/') ||
+        (target.substr(target.size() - png_suffix.size()) != png_suffix))
+    {
+        return asset_id::error_code::bad_destination;
+    }
+
+    return asset_id::create_asset_id(target.substr(1U, target.size() - 1U - png_suffix.size()));
+}
+
+int open_tcp_socket(asset_id::listen_address const& address)
+{
+    auto socket_address = sockaddr_in{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(address.port);
+    socket_address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    auto const host = (address.host == "localhost") ? std::string{"127.0.0.1"} : address.host;
+    if (!host.empty() && (inet_pton(AF_INET, host.c_str(), &socket_address.sin_addr) != 1))
+    {
+        return -1;
+    }
+
+    auto const fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    auto const enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    if (bind(fd, reinterpret_cast<sockaddr const*>(&socket_address), sizeof(socket_address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int open_unix_socket(std::string const& path)
+{
+    auto socket_address = sockaddr_un{};
+    socket_address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(socket_address.sun_path))
+    {
+        return -1;
+    }
+    path.copy(socket_address.sun_path, path.size());
+
+    // Only a socket left behind by an earlier run is replaced; any other file is an error.
+    struct stat status
+    {
+    };
+    if ((lstat(path.c_str(), &status) == 0) && S_ISSOCK(status.st_mode))
+    {
+        unlink(path.c_str());
+    }
+
+    auto const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr const*>(&socket_address), sizeof(socket_address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+} // namespace
+
+namespace asset_id
+{
+std::optional<listen_address> parse_listen_address(std::string_view const text)
+{
+    auto result = listen_address{};
+    if (text.find('/') != std::string_view::npos)
+    {
+        result.unix_path = std::string{text};
+        return result;
+    }
+
+    auto const colon = text.rfind(':');
+    if (colon == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+
+    auto const port_text = text.substr(colon + 1U);
+    auto const* const end = port_text.data() + port_text.size();
+    auto const [ptr, ec] = std::from_chars(port_text.data(), end, result.port);
+    if (port_text.empty() || (ec != std::errc{}) || (ptr != end))
+    {
+        return std::nullopt;
+    }
+
+    result.host = std::string{text.substr(0U, colon)};
+    return result;
+}
+
+http_response_cache::http_response_cache():
+    _responses(num_asset_ids())
+{
+}
+
+bool http_response_cache::respond(
+    std::string_view const target,
+    bool const keep_alive,
+    std::string& output
+)
+{
+    auto const asset_id = requested_id(target);
+    if (!asset_id)
+    {
+        append_response(not_found_response, keep_alive, output);
+        return false;
+    }
+
+    auto const checked_id = create_checked_asset_id(*asset_id);
+    if (!checked_id)
+    {
+        append_response(not_found_response, keep_alive, output);
+        return false;
+    }
+
+    auto& cached = _responses[to_number(*asset_id)];
+    if (cached.text.empty())
+    {
+        auto const png = encode_as_png(*checked_id);
+        if (!png)
+        {
+            append_response(not_found_response, keep_alive, output);
+            return false;
+        }
+
+        cached.text = "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: ";
+        cached.text += std::to_string(png->size());
+        cached.text += "\r\n";
+        cached.header_end = cached.text.size();
+        cached.text += "\r\n";
+        cached.text.append(reinterpret_cast<char const*>(png->data()), png->size());
+    }
+
+    auto const text = std::string_view{cached.text};
+    output.append(text.substr(0U, cached.header_end));
+    if (!keep_alive)
+    {
+        output.append(connection_close);
+    }
+    output.append(text.substr(cached.header_end));
+    return true;
+}
+
+std::unique_ptr<http_server> http_server::open(listen_address const& address)
+{
+    auto const listen_fd = address.unix_path.empty() ? open_tcp_socket(address)
+                                                     : open_unix_socket(address.unix_path);
+    if (listen_fd < 0)
+    {
+        return nullptr;
+    }
+
+    auto const epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    auto const stop_fd = eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    auto listen_event = epoll_event{};
+    listen_event.events = EPOLLIN;
+    listen_event.data.fd = listen_fd;
+
+    auto stop_event = epoll_event{};
+    stop_event.events = EPOLLIN;
+    stop_event.data.fd = stop_fd;
+
+    if ((epoll_fd < 0) || (stop_fd < 0) || (listen(listen_fd, SOMAXCONN) != 0) ||
+        (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event) != 0) ||
+        (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &stop_event) != 0))
+    {
+        for (auto const fd: {listen_fd, epoll_fd, stop_fd})
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        return nullptr;
+    }
+
+    return std::unique_ptr<http_server>{
+        new http_server{listen_fd, epoll_fd, stop_fd, address.unix_path}};
+}
+
+http_server::~http_server()
+{
+    for (auto const& [fd, client]: _connections)
+    {
+        close(fd);
+    }
+
+    close(_listen_fd);
+    close(_epoll_fd);
+    close(_stop_fd);
+
+    if (!_unix_path.empty())
+    {
+        unlink(_unix_path.c_str());
+    }
+}
+
+std::uint16_t http_server::port() const
+{
+    auto socket_address = sockaddr_in{};
+    auto length = socklen_t{sizeof(socket_address)};
+    if (!_unix_path.empty() ||
+        (getsockname(_listen_fd, reinterpret_cast<sockaddr*>(&socket_address), &length) != 0))
+    {
+        return 0U;
+    }
+
+    return ntohs(socket_address.sin_port);
+}
+
+bool http_server::run()
+{
+    epoll_event events[max_events];
+    while (true)
+    {
+        auto const num_events = epoll_wait(_epoll_fd, events, max_events, -1);
+        if (num_events < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        for (auto index = 0; index < num_events; ++index)
+        {
+            auto const fd = events[index].data.fd;
+            if (fd == _stop_fd)
+            {
+                auto count = std::uint64_t{0U};
+                return read(_stop_fd, &count, sizeof(count)) == sizeof(count);
+            }
+
+            if (fd == _listen_fd)
+            {
+                accept_connections();
+                continue;
+            }
+
+            auto const client = _connections.find(fd);
+            if (client != _connections.end())
+            {
+                serve(fd, client->second);
+            }
+        }
+    }
+}
+
+void http_server::stop()
+{
+    auto const count = std::uint64_t{1U};
+    [[maybe_unused]] auto const result = write(_stop_fd, &count, sizeof(count));
+}
+
+void http_server::accept_connections()
+{
+    while (true)
+    {
+        auto const fd = accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            // EAGAIN once the backlog is drained; any other error is specific to one client.
+            return;
+        }
+
+        // Responses are written whole, so there is nothing to gain from Nagle's algorithm.
+        auto const enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        auto client = connection{};
+        client.events = EPOLLIN | EPOLLRDHUP;
+        auto event = epoll_event{};
+        event.events = client.events;
+        event.data.fd = fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        _connections.emplace(fd, client);
+    }
+}
+
+bool http_server::connection::is_backlogged() const
+{
+    return output.size() - output_sent >= max_pending_output_num_bytes;
+}
+
+void http_server::serve(int const fd, connection& client)
+{
+    char buffer[read_buffer_num_bytes];
+    auto answered_all = false;
+    while (true)
+    {
+        answered_all = answer_requests(client);
+        if (!send_output(fd, client))
+        {
+            close_connection(fd);
+            return;
+        }
+
+        if (!answered_all)
+        {
+            // Answering stopped at the cap; carry on once the socket has taken enough.
+            if (client.is_backlogged())
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (client.closing || client.peer_closed)
+        {
+            break;
+        }
+
+        auto const num_read = recv(fd, buffer, sizeof(buffer), 0);
+        if (num_read > 0)
+        {
+            client.input.append(buffer, static_cast<std::size_t>(num_read));
+            continue;
+        }
+
+        if ((num_read < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+
+        if ((num_read < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            break;
+        }
+
+        // A client that has stopped sending is still owed the answers to what it did send.
+        client.peer_closed = true;
+    }
+
+    auto const finished = answered_all && (client.closing || client.peer_closed);
+    if ((finished && client.output.empty()) || !watch(fd, client))
+    {
+        close_connection(fd);
+    }
+}
+
+bool http_server::answer_requests(connection& client)
+{
+    auto consumed = std::size_t{0U};
+    auto answered_all = true;
+    while (!client.closing)
+    {
+        if (client.is_backlogged())
+        {
+            answered_all = false;
+            break;
+        }
+
+        auto const input = std::string_view{client.input}.substr(consumed);
+        auto const head_end = input.find(header_terminator);
+        if (head_end == std::string_view::npos)
+        {
+            if (input.size() > max_request_head_num_bytes)
+            {
+                client.output.append(bad_request_response);
+                client.closing = true;
+            }
+            break;
+        }
+
+        consumed += head_end + header_terminator.size();
+
+        auto const head = parse_request_head(input.substr(0U, head_end));
+        if (!head)
+        {
+            client.output.append(bad_request_response);
+            client.closing = true;
+            break;
+        }
+
+        // The server reads no request bodies, so a body would be taken for the next request;
+        // the connection is closed after answering instead.
+        auto const keep_alive = head->keep_alive && !head->has_body;
+        if (head->method == "GET")
+        {
+            _cache.respond(head->target, keep_alive, client.output);
+        }
+        else
+        {
+            append_response(method_not_allowed_response, keep_alive, client.output);
+        }
+        client.closing = !keep_alive;
+    }
+
+    client.input.erase(0U, consumed);
+    return answered_all;
+}
+
+bool http_server::send_output(int const fd, connection& client)
+{
+    while (client.output_sent < client.output.size())
+    {
+        auto const num_sent = send(
+            fd,
+            client.output.data() + client.output_sent,
+            client.output.size() - client.output_sent,
+            MSG_NOSIGNAL
+        );
+        if (num_sent >= 0)
+        {
+            client.output_sent += static_cast<std::size_t>(num_sent);
+            continue;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        // A full socket keeps the remainder until it drains.
+        return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+    }
+
+    client.output.clear();
+    client.output_sent = 0U;
+    return true;
+}
+
+bool http_server::watch(int const fd, connection& client)
+{
+    // More requests are only read while there is room for their answers, and nothing is read
+    // once the client has finished sending or the connection is to be closed; a socket that
+    // is readable, or hung up, would otherwise wake the loop again and again.
+    auto const reading = !client.closing && !client.peer_closed && !client.is_backlogged();
+    auto const events = (reading ? (EPOLLIN | EPOLLRDHUP) : 0U) |
+                        (client.output.empty() ? 0U : EPOLLOUT);
+    if (events == client.events)
+    {
+        return true;
+    }
+
+    auto event = epoll_event{};
+    event.events = events;
+    event.data.fd = fd;
+    client.events = events;
+    return epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void http_server::close_connection(int const fd)
+{
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    _connections.erase(fd);
+}
+} // namespace asset_id
@@ -0,0 +1,206 @@
+/**
+ * @file   http_server.h
+ * @brief  A small HTTP/1.1 server that answers `GET /<id>.png` with the png file of the id.
+ *
+ * The server runs a single threaded epoll event loop over non-blocking sockets. Connections are
+ * kept alive between requests, pipelined requests are answered in order, and every response is
+ * encoded once and then served from memory. A client that sends requests faster than it reads
+ * the answers is no longer read from while a megabyte of answers waits for it.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace asset_id
+{
+/**
+ * @brief The `listen_address` type holds where the server accepts connections; either a tcp
+ * address and port or the path of a unix domain socket.
+ */
+struct listen_address
+{
+    /**
+     * @brief The IPv4 address to bind; empty to bind every interface. Unused for a unix socket.
+     */
+    std::string host;
+
+    /**
+     * @brief The tcp port to bind; 0 picks any free port. Unused for a unix socket.
+     */
+    std::uint16_t port = 0U;
+
+    /**
+     * @brief The path of the unix domain socket; empty for a tcp address.
+     */
+    std::string unix_path;
+};
+
+/**
+ * @brief Attempt to parse the argument of `--serve`.
+ *
+ * Any text holding a `/` is taken as the path of a unix domain socket (write `./name` for a
+ * socket in the current directory); anything else must be `HOST:PORT`, where HOST is a dotted
+ * IPv4 address, `localhost`, or empty for every interface.
+ *
+ * @param text  the address to parse.
+ *
+ * @return std::optional<listen_address> containing the address if `text` is well formed;
+ *         empty optional otherwise.
+ */
+std::optional<listen_address> parse_listen_address(std::string_view text);
+
+/**
+ * @brief The `http_response_cache` type holds the complete HTTP response for every id served
+ * so far; each is encoded the first time it is requested.
+ */
+class http_response_cache
+{
+public:
+    http_response_cache();
+
+    /**
+     * @brief Append the response to a GET of `target` to `output`.
+     *
+     * @param target      the request target, e.g. `/1337.png`; any query string is ignored.
+     * @param keep_alive  whether the connection stays open after this response; when false the
+     *                    response carries `Connection: close`.
+     * @param output      the buffer the response is appended to.
+     *
+     * @return true   if `target` names a png file; the response is `200 OK`.
+     * @return false  otherwise; the response is `404 Not Found`.
+     */
+    bool respond(std::string_view target, bool keep_alive, std::string& output);
+
+private:
+    /**
+     * @brief A complete response; `header_end` is the offset of the blank line ending the
+     * header, where `Connection: close` is inserted when required.
+     */
+    struct cached_response
+    {
+        std::string text;
+        std::size_t header_end = 0U;
+    };
+
+    std::vector<cached_response> _responses;
+};
+
+class http_server
+{
+public:
+    /**
+     * @brief Create a server listening on `address`; a stale unix socket at the same path is
+     * replaced.
+     *
+     * @return std::unique_ptr<http_server> holding the server; null if the socket cannot be
+     *         created or bound.
+     */
+    static std::unique_ptr<http_server> open(listen_address const& address);
+
+    ~http_server();
+
+    http_server(http_server const&) = delete;
+    http_server& operator=(http_server const&) = delete;
+
+    /**
+     * @return std::uint16_t holding the tcp port the server is bound to; 0 for a unix socket.
+     */
+    std::uint16_t port() const;
+
+    /**
+     * @brief Serve requests until `stop` is called.
+     *
+     * @return true   if the server was stopped.
+     * @return false  if the event loop failed.
+     */
+    bool run();
+
+    /**
+     * @brief Make `run` return; safe to call from another thread or from a signal handler.
+     */
+    void stop();
+
+private:
+    /**
+     * @brief The bytes received from, and still to be sent to, a single client.
+     */
+    struct connection
+    {
+        /**
+         * @return true  if so many answers wait to be sent that no more requests are answered.
+         */
+        bool is_backlogged() const;
+
+        std::string input;
+        std::string output;
+        std::size_t output_sent = 0U;
+        bool closing = false;
+
+        /**
+         * @brief Whether the client has finished sending, or its socket has failed.
+         */
+        bool peer_closed = false;
+
+        /**
+         * @brief The epoll events the socket is registered for.
+         */
+        std::uint32_t events = 0U;
+    };
+
+    http_server(int listen_fd, int epoll_fd, int stop_fd, std::string unix_path):
+        _listen_fd(listen_fd),
+        _epoll_fd(epoll_fd),
+        _stop_fd(stop_fd),
+        _unix_path(std::move(unix_path))
+    {
+    }
+
+    void accept_connections();
+
+    /**
+     * @brief Read whatever `fd` has to offer, answer every complete request and send as much
+     * of the answers as the socket accepts, stopping while the client is backlogged.
+     */
+    void serve(int fd, connection& client);
+
+    /**
+     * @brief Answer the complete requests at the start of `client.input`.
+     *
+     * @return true   if every complete request was answered.
+     * @return false  if answering stopped because the client is backlogged.
+     */
+    bool answer_requests(connection& client);
+
+    /**
+     * @brief Send as much of `client.output` as the socket accepts.
+     *
+     * @return false  if the connection has failed and must be closed.
+     */
+    bool send_output(int fd, connection& client);
+
+    /**
+     * @brief Register `fd` for the events `client` now waits for.
+     *
+     * @return false  if the registration failed and the connection must be closed.
+     */
+    bool watch(int fd, connection& client);
+
+    void close_connection(int fd);
+
+    int _listen_fd;
+    int _epoll_fd;
+    int _stop_fd;
+    std::string _unix_path;
+
+    http_response_cache _cache;
+    std::unordered_map<int, connection> _connections;
+};
+} // namespace asset_id
@@ -0,0 +1,84 @@
+/**
+ * @file   id_geometry.h
+ * @brief  Describes a family of asset ids, and the image lines they are rendered to, at
+ *         compile time.
+ *
+ * Each family fixes the number of digits in an id and in its checksum, the checksum modulus,
+ * the width of the rendered line and where on the line the digits start. Every combination is
+ * checked when the geometry is instantiated, so the functions working on a geometry need no
+ * run time bounds checks and, as all of their sizes are constants, are fully unrolled.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "digit.h"
+
+namespace asset_id
+{
+/**
+ * @return std::uint64_t holding `base` raised to the power `exponent`.
+ */
+constexpr std::uint64_t integer_power(std::uint64_t const base, unsigned const exponent)
+{
+    auto result = std::uint64_t{1U};
+    for (auto index = 0U; index < exponent; ++index)
+    {
+        result *= base;
+    }
+    return result;
+}
+
+/**
+ * @brief The geometry of a family of asset ids.
+ *
+ * @tparam IdLength        the number of digits in an id.
+ * @tparam ChecksumLength  the number of digits in its checksum.
+ * @tparam ChecksumBase    the modulus of the checksum.
+ * @tparam LineNumBytes    the number of bytes (of 8 pixels each) in a rendered line.
+ * @tparam StartByte       the index of the first byte of the line that carries the digits.
+ */
+template<
+    unsigned IdLength,
+    unsigned ChecksumLength,
+    unsigned ChecksumBase,
+    unsigned LineNumBytes,
+    unsigned StartByte>
+struct id_geometry
+{
+    static constexpr auto id_length = IdLength;
+    static constexpr auto checksum_length = ChecksumLength;
+    static constexpr auto checksum_base = ChecksumBase;
+    static constexpr auto checked_id_length = IdLength + ChecksumLength;
+
+    static constexpr auto line_num_bytes = LineNumBytes;
+    static constexpr auto line_width_pixels = 8U * LineNumBytes;
+    static constexpr auto start_byte = StartByte;
+
+    using id_t = std::array<digit, id_length>;
+    using checksum_t = std::array<digit, checksum_length>;
+    using checked_id_t = std::array<digit, checked_id_length>;
+    using line_t = std::array<std::uint8_t, line_num_bytes>;
+
+    static_assert(IdLength > 0U, "An id needs at least one digit.");
+    static_assert(
+        IdLength <= 19U, "The value of an id, and its checksum sum, must fit in 64 bits."
+    );
+    static_assert(ChecksumBase >= 2U, "The checksum modulus must be at least 2.");
+    static_assert(
+        ChecksumBase <= integer_power(digit::base(), ChecksumLength),
+        "Every remainder of the checksum modulus must fit in the checksum digits."
+    );
+    static_assert(
+        StartByte + IdLength + ChecksumLength <= LineNumBytes,
+        "Every digit of a checked id must be rendered within the line."
+    );
+};
+
+/**
+ * @brief The geometry used by the tool: 4 digit ids with a 2 digit checksum modulo 97, drawn
+ * from the second byte of a 256 pixel line.
+ */
+using default_geometry = id_geometry<4U, 2U, 97U, 32U, 1U>;
+} // namespace asset_id
@@ -0,0 +1,110 @@
+#include "id_table.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+
+#include "checksum_batch.h"
+#include "render_batch.h"
+#include "stats.h"
+
+namespace
+{
+using asset_id::rendered_id_t;
+
+using rendered_id_table_t = std::array<rendered_id_t, asset_id::num_asset_ids()>;
+
+/**
+ * @brief Build the table: the checksums and then the image lines of all of the ids are
+ * calculated at once by the batch kernels.
+ *
+ * The table is deliberately built when the program is loaded rather than as a constant
+ * expression: evaluating the ten thousand entries in the compiler takes several seconds and
+ * exceeds the default constexpr evaluation limits of both gcc and clang, whereas at load time
+ * it costs well under a millisecond.
+ */
+rendered_id_table_t make_rendered_id_table()
+{
+    // This runs before `--stats` is parsed, so it is always timed; the cost is two clock reads.
+    auto const start = std::chrono::steady_clock::now();
+
+    constexpr auto const num_ids = asset_id::num_asset_ids();
+
+    // The digits of every id, one array per digit position, as the batch kernel expects.
+    std::array<std::vector<std::uint8_t>, asset_id::asset_id_length> digits{};
+    std::vector<std::uint8_t> checksum_hi(num_ids);
+    std::vector<std::uint8_t> checksum_lo(num_ids);
+
+    auto ids = asset_id::soa_ids{{}, num_ids};
+    for (auto position = std::size_t{0U}; position < asset_id::asset_id_length; ++position)
+    {
+        digits[position].resize(num_ids);
+        ids.digits[position] = digits[position].data();
+    }
+
+    for (auto number = std::uint32_t{0U}; number < num_ids; ++number)
+    {
+        auto remainder = number;
+        for (auto position = asset_id::asset_id_length; position > 0U; --position)
+        {
+            digits[position - 1U][number] =
+                static_cast<std::uint8_t>(remainder % asset_id::digit::base());
+            remainder /= asset_id::digit::base();
+        }
+    }
+
+    asset_id::calculate_checksums(ids, {checksum_hi.data(), checksum_lo.data()});
+
+    std::vector<asset_id::checked_asset_id_t> checked_ids(num_ids);
+    for (auto number = std::uint32_t{0U}; number < num_ids; ++number)
+    {
+        // Every value here is a single digit, so none of the conversions can fail.
+        auto& checked_id = checked_ids[number];
+        checked_id[0] = *asset_id::digit::from_int(checksum_hi[number]);
+        checked_id[1] = *asset_id::digit::from_int(checksum_lo[number]);
+        for (auto position = std::size_t{0U}; position < asset_id::asset_id_length; ++position)
+        {
+            checked_id[asset_id::checksum_length + position] =
+                *asset_id::digit::from_int(digits[position][number]);
+        }
+    }
+
+    // The lines are rendered a block at a time into an aligned buffer, then copied beside their
+    // checked ids. This is the only place the tool renders lines; everything else looks them up.
+    constexpr auto const block_num_ids = std::size_t{256U};
+    alignas(asset_id::image_line_alignment) std::array<asset_id::image_line_t, block_num_ids>
+        lines{};
+
+    rendered_id_table_t table{};
+    for (auto first = std::size_t{0U}; first < num_ids; first += block_num_ids)
+    {
+        auto const count = std::min<std::size_t>(block_num_ids, num_ids - first);
+        asset_id::render_image_lines(&checked_ids[first], count, lines.data());
+        for (auto index = std::size_t{0U}; index < count; ++index)
+        {
+            table[first + index] = rendered_id_t{checked_ids[first + index], lines[index]};
+        }
+    }
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    asset_id::record_stage(
+        asset_id::stats_stage::render,
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+        ),
+        table.size()
+    );
+
+    return table;
+}
+
+rendered_id_table_t const rendered_id_table = make_rendered_id_table();
+} // namespace
+
+namespace asset_id
+{
+rendered_id_t const& lookup_rendered_id(std::uint32_t const number)
+{
+    return rendered_id_table[number];
+}
+} // namespace asset_id
@@ -0,0 +1,67 @@
+/**
+ * @file   id_table.h
+ * @brief  Precomputed checked ids and image lines for every possible asset id.
+ *
+ * An asset id has a fixed number of decimal digits, so there are only 10^asset_id_length
+ * distinct checked ids and image lines. These are all calculated once, when the program is
+ * loaded, using the same functions as the rest of the tool, so the hot path reduces to a
+ * single table lookup.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "asset_id.h"
+#include "image_line.h"
+
+namespace asset_id
+{
+/**
+ * @brief The number of distinct values of asset_id_t.
+ */
+constexpr std::uint32_t num_asset_ids()
+{
+    auto result = std::uint32_t{1U};
+    for (auto index = 0U; index < asset_id_length; ++index)
+    {
+        result *= digit::base();
+    }
+    return result;
+}
+
+/**
+ * @brief The `rendered_id_t` type holds everything derived from an instance of asset_id_t that
+ * is needed to write its png file.
+ */
+struct rendered_id_t
+{
+    checked_asset_id_t checked_id;
+
+    /**
+     * @brief The rendered digits of `checked_id`, starting at `image_line_start_byte`.
+     */
+    image_line_t pixels;
+};
+
+/**
+ * @brief Look up the checked id and image line of an asset id from its numeric value.
+ *
+ * @param number  the numeric value of the asset id; must be less than `num_asset_ids()`.
+ *
+ * @return rendered_id_t const& holding the precomputed values for this id.
+ */
+rendered_id_t const& lookup_rendered_id(std::uint32_t number);
+
+/**
+ * @brief Look up the checked id and image line of an asset id.
+ *
+ * @param asset_id  the asset id to look up.
+ *
+ * @return rendered_id_t const& holding the precomputed values for this id.
+ */
+inline rendered_id_t const& lookup_rendered_id(asset_id_t const& asset_id)
+{
+    return lookup_rendered_id(to_number(asset_id));
+}
+} // namespace asset_id
@@ -9,9 +9,11 @@
 #pragma once
 
 #include <array>
-#include <optional>
+#include <cstddef>
+#include <utility>
 
 #include "asset_id.h"
+#include "result.h"
 
 namespace asset_id
 {
@@ -30,13 +32,35 @@ using pixel_byte_t = std::uint8_t;
  * @brief This tool will write png images that are 256 pixels wide (and 1 pixel high) and each
  * pixel only requires 1 bit.
  */
-constexpr auto const image_line_width_pixels = 256U;
-constexpr auto const image_line_num_bytes = 32U;
+constexpr auto const image_line_width_pixels = default_geometry::line_width_pixels;
+constexpr auto const image_line_num_bytes = default_geometry::line_num_bytes;
 
 /**
  * @brief The `image_line_t` is used to hold a the bits that will be written as a single line png file.
  */
-using image_line_t = std::array<pixel_byte_t, image_line_num_bytes>;
+using image_line_t = default_geometry::line_t;
+
+/**
+ * @brief The index of the first entry of `image_line_t` that carries the rendered digits in the
+ * png files written by this tool.
+ */
+constexpr auto const image_line_start_byte = default_geometry::start_byte;
+
+/**
+ * @brief The bit-patterns for each base 10 digit, indexed by the value of the digit.
+ */
+constexpr std::array<pixel_byte_t, 10U> const pixels_per_digit = {
+    0b01110111,
+    0b01000010,
+    0b10110110,
+    0b11010110,
+    0b11000011,
+    0b11010101,
+    0b11110101,
+    0b01000110,
+    0b11110111,
+    0b11010111,
+};
 
 /**
  * @brief Convert an instance of `digit` to the corresponding bit-pattern that will render the digit 
@@ -44,10 +68,10 @@ using image_line_t = std::array<pixel_byte_t, image_line_num_bytes>;
  * 
  * @param a_digit the digit to map.
  *
- * @return std::optional<pixel_byte_t> containing the bit-pattern if the mapping was successful; 
- *         empty optional otherwise.
+ * @return result<pixel_byte_t> containing the bit-pattern if the mapping was successful;
+ *         `error_code::render_failed` otherwise.
  */
-std::optional<pixel_byte_t> digit_to_pixel(digit a_digit);
+constexpr result<pixel_byte_t> digit_to_pixel(digit a_digit);
 
 /**
  * @brief Attempt to instantiate `image_line_t` containing the bit-patterns to render a given asset id 
@@ -61,9 +85,83 @@ std::optional<pixel_byte_t> digit_to_pixel(digit a_digit);
  * @param asset_id     the collection of digits for a checksum and asset id to render.
  * @param start_index  the index of the first entry in `image_line_t` to carry the bit-patterns.
  *
- * @return std::optional<image_line_t> containing the asset id bit patterns if successfully created; 
- *        the empty optional otherwise, including a value of `start_index` that would cause out of bounds access.
+ * @return result<image_line_t> containing the asset id bit patterns if successfully created;
+ *         `error_code::render_failed` otherwise, including a value of `start_index` that would
+ *         cause out of bounds access.
  */
-std::optional<image_line_t>
+constexpr result<image_line_t>
 create_image_line(checked_asset_id_t const& asset_id, std::size_t start_index);
+
+/**
+ * @brief Create the image line of a checked id of any geometry, with its bit-patterns starting
+ * at `Geometry::start_byte`; the geometry guarantees that they fit.
+ *
+ * All pixels apart from the bit-patterns will be set to 0.
+ */
+template<typename Geometry>
+constexpr typename Geometry::line_t create_line(typename Geometry::checked_id_t const& checked_id);
+
+constexpr result<pixel_byte_t> digit_to_pixel(digit const a_digit)
+{
+    static_assert(
+        static_cast<std::uint8_t>(digit::base()) == pixels_per_digit.size(),
+        "digit_to_pixel is assuming base 10 digits are used."
+    );
+
+    if (a_digit.value() >= digit::base())
+    {
+        return error_code::render_failed;
+    }
+
+    return pixels_per_digit[a_digit.value()];
+}
+
+constexpr result<image_line_t>
+create_image_line(checked_asset_id_t const& asset_id, std::size_t const start_index)
+{
+    if (start_index + asset_id.size() > image_line_num_bytes)
+    {
+        return error_code::render_failed;
+    }
+
+    image_line_t result{};
+    for (auto digit_index = 0U; digit_index < asset_id.size(); ++digit_index)
+    {
+        auto const& digit = asset_id[digit_index];
+        auto const pixel_byte = digit_to_pixel(digit);
+        if (!pixel_byte)
+        {
+            return pixel_byte.error();
+        }
+
+        result[digit_index + start_index] = *pixel_byte;
+    }
+
+    return result;
+}
+
+namespace detail
+{
+template<typename Geometry, std::size_t... Index>
+constexpr typename Geometry::line_t
+render_line(typename Geometry::checked_id_t const& checked_id, std::index_sequence<Index...>)
+{
+    // Every digit is in range by construction, so the bit-patterns are looked up directly.
+    auto line = typename Geometry::line_t{};
+    ((line[Geometry::start_byte + Index] = pixels_per_digit[checked_id[Index].value()]), ...);
+    return line;
+}
+} // namespace detail
+
+template<typename Geometry>
+constexpr typename Geometry::line_t create_line(typename Geometry::checked_id_t const& checked_id)
+{
+    static_assert(
+        digit::base() == pixels_per_digit.size(), "create_line is assuming base 10 digits are used."
+    );
+
+    return detail::render_line<Geometry>(
+        checked_id, std::make_index_sequence<Geometry::checked_id_length>{}
+    );
+}
 } // namespace asset_id
\ No newline at end of file
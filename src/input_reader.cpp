@@ -0,0 +1,251 @@
+#include "input_reader.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+// SSE2 is part of the x86-64 baseline; AVX2 is enabled per function and checked at run time.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ASSET_ID_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define ASSET_ID_X86_KERNELS 0
+#endif
+
+namespace
+{
+/**
+ * @brief Every well formed record is `asset_id_length` digits followed by a newline.
+ */
+constexpr auto const record_length = std::size_t{asset_id::asset_id_length + 1U};
+
+/**
+ * @brief Build the movemask bit patterns for `num_records` consecutive records: the bits set
+ * at the newline positions and at the digit positions respectively.
+ */
+constexpr unsigned newline_mask(std::size_t const num_records)
+{
+    auto mask = 0U;
+    for (auto record = std::size_t{0U}; record < num_records; ++record)
+    {
+        mask |= 1U << (record * record_length + asset_id::asset_id_length);
+    }
+    return mask;
+}
+
+constexpr unsigned digit_mask(std::size_t const num_records)
+{
+    auto const all_bits = (num_records * record_length == 32U)
+                              ? ~0U
+                              : ((1U << (num_records * record_length)) - 1U);
+    return all_bits & ~newline_mask(num_records);
+}
+
+/**
+ * @brief Check one record with plain compares.
+ *
+ * @return std::size_t holding 1 if the record at `data` is well formed, 0 otherwise.
+ */
+std::size_t validate_scalar(char const* data)
+{
+    for (auto index = std::size_t{0U}; index < asset_id::asset_id_length; ++index)
+    {
+        if ((data[index] < '0') || (data[index] > '9'))
+        {
+            return 0U;
+        }
+    }
+    return (data[asset_id::asset_id_length] == '\n') ? 1U : 0U;
+}
+
+#if ASSET_ID_X86_KERNELS
+constexpr auto const sse2_num_bytes = std::size_t{16U};
+constexpr auto const sse2_num_records = sse2_num_bytes / record_length;
+
+/**
+ * @brief Check the records in the 16 bytes at `data` at once.
+ *
+ * @return std::size_t holding `sse2_num_records` if they are all well formed, 0 otherwise.
+ */
+std::size_t validate_sse2(char const* data)
+{
+    auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+
+    auto const offset = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+    auto const is_digit = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(9)), offset);
+    auto const is_newline = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+
+    auto const digits = static_cast<unsigned>(_mm_movemask_epi8(is_digit));
+    auto const newlines = static_cast<unsigned>(_mm_movemask_epi8(is_newline));
+
+    constexpr auto const expected_digits = digit_mask(sse2_num_records);
+    constexpr auto const expected_newlines = newline_mask(sse2_num_records);
+
+    auto const valid = ((digits & expected_digits) == expected_digits) &&
+                       ((newlines & expected_newlines) == expected_newlines);
+    return valid ? sse2_num_records : 0U;
+}
+
+constexpr auto const avx2_num_bytes = std::size_t{32U};
+constexpr auto const avx2_num_records = avx2_num_bytes / record_length;
+
+/**
+ * @brief Check the records in the 32 bytes at `data` at once, as `validate_sse2` does.
+ */
+__attribute__((target("avx2"))) std::size_t validate_avx2(char const* data)
+{
+    auto const bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data));
+
+    auto const offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8('0'));
+    auto const is_digit =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(9)), offset);
+    auto const is_newline = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+
+    auto const digits = static_cast<unsigned>(_mm256_movemask_epi8(is_digit));
+    auto const newlines = static_cast<unsigned>(_mm256_movemask_epi8(is_newline));
+
+    constexpr auto const expected_digits = digit_mask(avx2_num_records);
+    constexpr auto const expected_newlines = newline_mask(avx2_num_records);
+
+    auto const valid = ((digits & expected_digits) == expected_digits) &&
+                       ((newlines & expected_newlines) == expected_newlines);
+    return valid ? avx2_num_records : 0U;
+}
+
+static_assert(sse2_num_records > 0U, "A SIMD block must hold at least one record.");
+#endif
+
+/**
+ * @brief Convert the characters of a line already known to be well formed into digits.
+ */
+asset_id::asset_id_t to_asset_id(char const* data)
+{
+    auto result = asset_id::asset_id_t{};
+    for (auto index = std::size_t{0U}; index < result.size(); ++index)
+    {
+        result[index] = *asset_id::digit::from_char(data[index]);
+    }
+    return result;
+}
+} // namespace
+
+namespace asset_id
+{
+std::optional<mapped_file> mapped_file::open(std::filesystem::path const& path)
+{
+    auto const descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        return std::nullopt;
+    }
+
+    struct stat status
+    {
+    };
+    if ((fstat(descriptor, &status) != 0) || !S_ISREG(status.st_mode))
+    {
+        close(descriptor);
+        return std::nullopt;
+    }
+
+    auto const size = static_cast<std::size_t>(status.st_size);
+    if (size == 0U)
+    {
+        close(descriptor);
+        return mapped_file{nullptr, 0U};
+    }
+
+    auto* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (data == MAP_FAILED)
+    {
+        return std::nullopt;
+    }
+
+    // The file is read once, front to back.
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    return mapped_file{static_cast<char const*>(data), size};
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept:
+    _data(std::exchange(other._data, nullptr)),
+    _size(std::exchange(other._size, 0U))
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->~mapped_file();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0U);
+    }
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    if (_data)
+    {
+        munmap(const_cast<char*>(_data), _size);
+    }
+}
+
+std::size_t id_scanner::validate_block() const
+{
+    auto const remaining = _buffer.size() - _position;
+    auto const* const data = _buffer.data() + _position;
+
+    switch (_level)
+    {
+#if ASSET_ID_X86_KERNELS
+        case simd_level::avx2:
+            return (remaining >= avx2_num_bytes) ? validate_avx2(data) : 0U;
+        case simd_level::sse2:
+            return (remaining >= sse2_num_bytes) ? validate_sse2(data) : 0U;
+#endif
+        default:
+            return (remaining >= record_length) ? validate_scalar(data) : 0U;
+    }
+}
+
+bool id_scanner::next(input_record& record)
+{
+    if (_position >= _buffer.size())
+    {
+        return false;
+    }
+
+    if (_validated == 0U)
+    {
+        _validated = validate_block();
+    }
+
+    auto const* const start = _buffer.data() + _position;
+    record.line_number = ++_line_number;
+
+    if (_validated > 0U)
+    {
+        --_validated;
+        record.text = std::string_view{start, asset_id_length};
+        record.id = to_asset_id(start);
+        _position += record_length;
+        return true;
+    }
+
+    auto const remaining = _buffer.size() - _position;
+    auto const* const newline = static_cast<char const*>(std::memchr(start, '\n', remaining));
+    auto const length = newline ? static_cast<std::size_t>(newline - start) : remaining;
+
+    record.text = std::string_view{start, length};
+    record.id = create_asset_id(record.text);
+
+    _position += newline ? length + 1U : length;
+    return true;
+}
+} // namespace asset_id
@@ -0,0 +1,134 @@
+/**
+ * @file   input_reader.h
+ * @brief  Reads the asset ids listed in an input file without copying or allocating per line.
+ *
+ * The input file is memory mapped and scanned in place. Almost every line of a real input is a
+ * well formed `NNNN\n` record, so the scanner validates several consecutive records at once
+ * with SIMD compares (AVX2 when the host CPU supports it, otherwise SSE2, with a scalar
+ * fallback on other targets) and only inspects the remaining lines one at a time.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include "asset_id.h"
+#include "checksum_batch.h"
+
+namespace asset_id
+{
+/**
+ * @brief A read-only memory mapping of a whole file; the mapping is released on destruction.
+ */
+class mapped_file
+{
+public:
+    /**
+     * @brief Attempt to map a file into memory.
+     *
+     * @param path  the file to map.
+     *
+     * @return std::optional<mapped_file> containing the mapping if the file could be opened and
+     *         mapped; empty optional otherwise.
+     */
+    static std::optional<mapped_file> open(std::filesystem::path const& path);
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+
+    mapped_file& operator=(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    ~mapped_file();
+
+    /**
+     * @return std::string_view over the whole of the file; empty for an empty file.
+     */
+    std::string_view contents() const { return {_data, _size}; }
+
+private:
+    mapped_file(char const* data, std::size_t size):
+        _data(data),
+        _size(size)
+    {
+    }
+
+    char const* _data = nullptr;
+    std::size_t _size = 0U;
+};
+
+/**
+ * @brief The `input_record` type describes a single line of the input.
+ */
+struct input_record
+{
+    /**
+     * @brief The 1-based number of the line in the input.
+     */
+    std::size_t line_number = 0U;
+
+    /**
+     * @brief The text of the line, excluding the line terminator; refers into the scanned buffer.
+     */
+    std::string_view text;
+
+    /**
+     * @brief The digits of the id if `text` is a well formed asset id; otherwise the reason it
+     * is not, as reported by `create_asset_id`.
+     */
+    result<asset_id_t> id = error_code::bad_length;
+};
+
+/**
+ * @brief Splits a buffer into lines and validates each line as an asset id.
+ *
+ * Lines are split exactly as `std::getline` would: every `\n` terminates a line and a final
+ * line without a terminator is still reported, but a buffer ending in `\n` does not produce a
+ * trailing empty line. No other characters (including `\r`) are stripped.
+ */
+class id_scanner
+{
+public:
+    /**
+     * @param buffer  the text to scan; it must outlive the scanner.
+     * @param level   the SIMD kernel used to validate records; it must be supported.
+     */
+    explicit id_scanner(std::string_view buffer, simd_level level = best_simd_level()):
+        _buffer(buffer),
+        _level(level)
+    {
+    }
+
+    /**
+     * @brief Read the next line of the buffer.
+     *
+     * @param record  overwritten with the next line if there is one.
+     *
+     * @return true   if `record` holds the next line.
+     * @return false  if the whole buffer has been read.
+     */
+    bool next(input_record& record);
+
+private:
+    /**
+     * @brief Count how many well formed records start at the current position, checking a
+     * whole SIMD register's worth of records at once.
+     *
+     * @return std::size_t holding the number of records known to be well formed; either 0
+     *         or the number of records that fit in one register.
+     */
+    std::size_t validate_block() const;
+
+    std::string_view _buffer;
+    simd_level _level;
+    std::size_t _position = 0U;
+    std::size_t _line_number = 0U;
+
+    /**
+     * @brief The number of records from `_position` onwards already known to be well formed.
+     */
+    std::size_t _validated = 0U;
+};
+} // namespace asset_id
@@ -0,0 +1,301 @@
+#include "logger.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+namespace
+{
+/**
+ * @brief A bounded multi-producer queue of log records; each slot carries a sequence number
+ * that tells producers and the single consumer whose turn it is (Vyukov's bounded queue).
+ */
+class log_ring
+{
+public:
+    static constexpr auto const capacity = std::size_t{4096U};
+
+    log_ring()
+    {
+        for (auto index = std::size_t{0U}; index < capacity; ++index)
+        {
+            _slots[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @return false  if the ring is full.
+     */
+    bool try_push(asset_id::log_record const& record)
+    {
+        auto position = _tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto& slot = _slots[position % capacity];
+            auto const sequence = slot.sequence.load(std::memory_order_acquire);
+            auto const lag = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lag == 0)
+            {
+                if (_tail.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed))
+                {
+                    slot.record = record;
+                    slot.sequence.store(position + 1U, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Take the oldest record; only ever called by the drain thread.
+     *
+     * @return false  if the ring is empty.
+     */
+    bool try_pop(asset_id::log_record& record)
+    {
+        auto& slot = _slots[_head % capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != _head + 1U)
+        {
+            return false;
+        }
+
+        record = slot.record;
+        slot.sequence.store(_head + capacity, std::memory_order_release);
+        ++_head;
+        return true;
+    }
+
+private:
+    struct slot_t
+    {
+        std::atomic<std::size_t> sequence{0U};
+        asset_id::log_record record;
+    };
+
+    std::array<slot_t, capacity> _slots;
+    alignas(64) std::atomic<std::size_t> _tail{0U};
+    alignas(64) std::size_t _head = 0U;
+};
+
+/**
+ * @brief The state shared by every producer and the drain thread.
+ */
+struct logger_state
+{
+    log_ring ring;
+
+    std::atomic<bool> draining{false};
+    std::ostream* output = nullptr;
+
+    /**
+     * @brief The number of producers that may be pushing onto the ring; a drain is only stopped
+     * once none is left, so that no record is pushed after its last pass.
+     */
+    std::atomic<std::size_t> num_producers{0U};
+
+    /**
+     * @brief Serialises records written straight away when no drain is running; held while a
+     * drain stops, so that they are only written after every record queued before them.
+     */
+    std::mutex direct_mutex;
+
+    /**
+     * @brief Lets the drain thread sleep while there is nothing to write; producers only take
+     * the mutex when the drain thread is, or is about to be, asleep.
+     */
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::atomic<bool> drain_idle{false};
+    std::atomic<bool> stopping{false};
+
+    std::thread thread;
+};
+
+logger_state& state()
+{
+    static auto instance = logger_state{};
+    return instance;
+}
+
+void wake_drain(logger_state& logger)
+{
+    if (logger.drain_idle.load())
+    {
+        auto const lock = std::lock_guard<std::mutex>{logger.wake_mutex};
+        logger.wake.notify_one();
+    }
+}
+
+/**
+ * @brief Write every queued record to the output in as few writes as possible.
+ *
+ * @return true  if any record was written.
+ */
+bool drain_ring(logger_state& logger)
+{
+    static constexpr auto const block_num_bytes = std::size_t{64U * 1024U};
+    static char block[block_num_bytes];
+
+    auto record = asset_id::log_record{};
+    auto size = std::size_t{0U};
+    auto any = false;
+    while (logger.ring.try_pop(record))
+    {
+        auto const text = record.text();
+        if (size + text.size() + 1U > block_num_bytes)
+        {
+            logger.output->write(block, static_cast<std::streamsize>(size));
+            size = 0U;
+        }
+
+        std::memcpy(block + size, text.data(), text.size());
+        size += text.size();
+        block[size++] = '\n';
+        any = true;
+    }
+
+    if (any)
+    {
+        logger.output->write(block, static_cast<std::streamsize>(size));
+        logger.output->flush();
+    }
+
+    return any;
+}
+
+void run_drain(logger_state& logger)
+{
+    while (true)
+    {
+        if (drain_ring(logger))
+        {
+            continue;
+        }
+
+        if (logger.stopping.load())
+        {
+            // Producers have finished; one last pass picks up anything pushed meanwhile.
+            drain_ring(logger);
+            return;
+        }
+
+        auto lock = std::unique_lock<std::mutex>{logger.wake_mutex};
+        logger.drain_idle.store(true);
+        // The timeout bounds the delay of a record pushed just before the flag was set.
+        logger.wake.wait_for(lock, std::chrono::milliseconds{50});
+        logger.drain_idle.store(false);
+    }
+}
+} // namespace
+
+namespace asset_id
+{
+namespace detail
+{
+std::atomic<log_level> current_log_level{default_log_level};
+} // namespace detail
+
+std::optional<log_level> parse_log_level(std::string_view const text)
+{
+    constexpr std::pair<std::string_view, log_level> const names[] = {
+        {"debug", log_level::debug},
+        {"info", log_level::info},
+        {"warning", log_level::warning},
+        {"error", log_level::error},
+        {"off", log_level::off},
+    };
+
+    for (auto const& [name, level]: names)
+    {
+        if (text == name)
+        {
+            return level;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void set_log_level(log_level const level)
+{
+    detail::current_log_level.store(level, std::memory_order_relaxed);
+}
+
+void log_record::append(std::string_view const text)
+{
+    auto const count = std::min(text.size(), capacity - _size);
+    std::memcpy(_text + _size, text.data(), count);
+    _size = static_cast<std::uint16_t>(_size + count);
+}
+
+void submit_log_record(log_record const& record)
+{
+    auto& logger = state();
+
+    // Announcing the producer before checking the flag pairs with the drain clearing the flag
+    // before counting the producers: either this record goes straight out, or the drain waits
+    // for it.
+    logger.num_producers.fetch_add(1U);
+    if (!logger.draining.load())
+    {
+        logger.num_producers.fetch_sub(1U);
+
+        auto const lock = std::lock_guard<std::mutex>{logger.direct_mutex};
+        auto& output = logger.output ? *logger.output : std::cout;
+        output << record.text() << '\n';
+        return;
+    }
+
+    while (!logger.ring.try_push(record))
+    {
+        wake_drain(logger);
+        std::this_thread::yield();
+    }
+    wake_drain(logger);
+    logger.num_producers.fetch_sub(1U, std::memory_order_release);
+}
+
+log_drain::log_drain(std::ostream& output)
+{
+    auto& logger = state();
+    logger.output = &output;
+    logger.stopping.store(false);
+    logger.thread = std::thread{run_drain, std::ref(logger)};
+    logger.draining.store(true);
+}
+
+log_drain::~log_drain()
+{
+    auto& logger = state();
+    auto const direct_lock = std::lock_guard<std::mutex>{logger.direct_mutex};
+
+    // The drain thread keeps making room for the producers already pushing until they are done.
+    logger.draining.store(false);
+    while (logger.num_producers.load() != 0U)
+    {
+        std::this_thread::yield();
+    }
+
+    logger.stopping.store(true);
+    {
+        auto const lock = std::lock_guard<std::mutex>{logger.wake_mutex};
+        logger.wake.notify_one();
+    }
+    logger.thread.join();
+    logger.output = nullptr;
+}
+} // namespace asset_id
@@ -0,0 +1,164 @@
+/**
+ * @file   logger.h
+ * @brief  A leveled logger whose messages are drained to standard output by a background thread.
+ *
+ * A message is formatted into a fixed size record on the calling thread and pushed onto a
+ * lock-free ring buffer; a single drain thread, owned by a `log_drain`, writes the records out
+ * in large blocks. When no drain is running the records are written straight away, which keeps
+ * the behaviour of tests and embedding programs simple.
+ *
+ * A message below the current level costs a single relaxed atomic load: `log_message` checks
+ * `log_enabled` before any formatting is done.
+ */
+#pragma once
+
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace asset_id
+{
+/**
+ * @brief The severity of a log message; messages below the current level are discarded.
+ *
+ * The tool itself only logs warnings and errors about the output; `debug` and `info` remain
+ * for programs embedding the library and for diagnostics while developing.
+ */
+enum class log_level : std::uint8_t
+{
+    debug,
+    info,
+    warning,
+    error,
+
+    /**
+     * @brief Only used as a level threshold: no message is logged.
+     */
+    off,
+};
+
+/**
+ * @brief The level used when neither `--quiet` nor `--log-level` is given; every diagnostic
+ * about the input and output is logged.
+ */
+constexpr auto const default_log_level = log_level::warning;
+
+/**
+ * @brief Attempt to parse the argument of `--log-level`.
+ *
+ * @return std::optional<log_level> containing the level if `text` is one of `debug`, `info`,
+ *         `warning`, `error` or `off`; empty optional otherwise.
+ */
+std::optional<log_level> parse_log_level(std::string_view text);
+
+namespace detail
+{
+extern std::atomic<log_level> current_log_level;
+} // namespace detail
+
+/**
+ * @brief Set the level below which messages are discarded.
+ */
+void set_log_level(log_level level);
+
+/**
+ * @return true   if a message at `level` would be logged.
+ * @return false  otherwise.
+ */
+inline bool log_enabled(log_level const level)
+{
+    return level >= detail::current_log_level.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief A single log message, formatted without allocating; text beyond the capacity of the
+ * record is truncated.
+ */
+class log_record
+{
+public:
+    static constexpr auto const capacity = std::size_t{240U};
+
+    log_record() = default;
+
+    explicit log_record(log_level level):
+        _level(level)
+    {
+    }
+
+    log_level level() const { return _level; }
+
+    std::string_view text() const { return {_text, _size}; }
+
+    void append(std::string_view text);
+
+    void append(char const* text) { append(std::string_view{text}); }
+
+    void append(char const character) { append(std::string_view{&character, 1U}); }
+
+    /**
+     * @brief Append the decimal value of `value`; single byte integers are written as numbers,
+     * not as characters.
+     */
+    template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+    void append(Integer const value)
+    {
+        char digits[24];
+        auto const result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view{digits, static_cast<std::size_t>(result.ptr - digits)});
+    }
+
+    void append(bool) = delete;
+
+private:
+    log_level _level = log_level::info;
+    std::uint16_t _size = 0U;
+    char _text[capacity];
+};
+
+/**
+ * @brief Hand a formatted record to the logger; it is queued for the drain thread if one is
+ * running, and otherwise written straight away.
+ */
+void submit_log_record(log_record const& record);
+
+/**
+ * @brief Log the concatenation of `parts` at `level`, if that level is enabled. A newline is
+ * added to every message.
+ */
+template<typename... Parts>
+void log_message(log_level const level, Parts const&... parts)
+{
+    if (!log_enabled(level))
+    {
+        return;
+    }
+
+    auto record = log_record{level};
+    (record.append(parts), ...);
+    submit_log_record(record);
+}
+
+/**
+ * @brief Owns the background thread that drains logged messages to `output`.
+ *
+ * Only one drain may exist at a time. Producers never lose a message: when the ring buffer is
+ * full they wait for the drain thread to make room. Destroying the drain waits for the producers
+ * already pushing and writes every message still queued before the thread is joined; a message
+ * logged meanwhile is written straight away once that is done.
+ */
+class log_drain
+{
+public:
+    explicit log_drain(std::ostream& output);
+    ~log_drain();
+
+    log_drain(log_drain const&) = delete;
+    log_drain& operator=(log_drain const&) = delete;
+};
+} // namespace asset_id
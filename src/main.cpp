@@ -1,12 +1,27 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <unistd.h>
+#include <memory>
+#include <optional>
 #include <vector>
+#include <unistd.h>
 
-#include "asset_id.h"
-#include "write_png.h"
+#include "batch.h"
+#include "http_server.h"
+#include "input_reader.h"
+#include "logger.h"
+#include "options.h"
+#include "output_sink.h"
+#include "sheet_sink.h"
+#include "stats.h"
+#include "tar_sink.h"
+#include "uring_sink.h"
+#include "verify.h"
 
 using namespace asset_id;
 
@@ -30,12 +45,55 @@ namespace
 void usage(void)
 {
     std::cout << "Creates display pngs for specified list of asset ids.\n";
-    std::cout << "Usage:\n 'asset_id' : displays this usage message.\n 'asset_id <INPUT_FILE> "
-                 "<OUTPUT_DIR>' where:\n";
+    std::cout << "Usage:\n 'asset_id' : displays this usage message.\n 'asset_id [OPTIONS] "
+                 "<INPUT_FILE> <OUTPUT_DIR>'\n 'asset_id [OPTIONS] --archive <ARCHIVE> "
+                 "<INPUT_FILE>'\n 'asset_id [OPTIONS] --range START-END <OUTPUT_DIR>'\n "
+                 "'asset_id [OPTIONS] --range START-END --archive <ARCHIVE>'\n "
+                 "'asset_id --serve <ADDRESS>'\n 'asset_id [OPTIONS] --verify <DIR>' where:\n";
     std::cout << "\t <INPUT_FILE> is a path to a text file containing a list of 4 digit "
                  "asset ids, one per line. \n"
                  "\t <OUTPUT_DIR> is a path to a directory that "
-                 "will hold the generated png files.\n";
+                 "will hold the generated png files.\n"
+                 "\t <ARCHIVE> is the path of a tar archive that will hold the generated png "
+                 "files, or '-' for standard output.\n"
+                 "\t <ADDRESS> is 'HOST:PORT' or the path of a unix socket on which "
+                 "'GET /<id>.png' is answered until the process is interrupted.\n";
+    std::cout << "Options:\n"
+                 "\t --jobs N sets the number of threads generating png files; defaults to "
+                 "the number of hardware threads.\n"
+                 "\t --png-backend selects the png encoder; 'builtin' (the default) or 'libpng' "
+                 "when available.\n"
+                 "\t --output-backend selects how files are written; 'direct' (the default) or "
+                 "'io_uring', which falls back to 'direct' when unavailable.\n"
+                 "\t --queue-depth N sets the number of files in flight with 'io_uring'.\n"
+                 "\t --sheet N writes the ids as the rows of 256xN pixel sprite sheets, "
+                 "'sheet_<K>.png', each with a 'sheet_<K>.index' of the id on every row.\n"
+                 "\t --range START-END generates every id from START to END, inclusive, instead "
+                 "of reading <INPUT_FILE>.\n"
+                 "\t --all generates every id; the same as '--range 0000-9999'.\n"
+                 "\t --shard I/N only handles the ids whose value modulo N is I, so N processes "
+                 "given shards 0 to N-1 share out the job.\n"
+                 "\t --durability selects when files are synced to disk; 'none' (the default), "
+                 "'batch', which syncs the file system every --sync-interval files and at the "
+                 "end, or 'per-file'.\n"
+                 "\t --sync-interval N sets the number of files between syncs with "
+                 "'--durability batch'; defaults to 4096.\n"
+                 "\t --no-dedup processes every occurrence of a repeated id; by default only the "
+                 "first is processed.\n"
+                 "\t --incremental leaves png files that already hold the expected bytes "
+                 "untouched.\n"
+                 "\t --verify DIR checks that every '<id>.png' in DIR decodes to the id it is "
+                 "named after, with the right checksum, and lists the files that do not.\n"
+                 "\t --failures-file PATH writes every failure to PATH ('-' for standard error) "
+                 "as it occurs, one '<line>\\t<reason>\\t<text>' line each.\n"
+                 "\t --failure-samples N sets the number of failures listed at the end of the "
+                 "run; defaults to 1000.\n"
+                 "\t --log-level selects the diagnostics shown; 'debug', 'info', 'warning' (the "
+                 "default), 'error' or 'off'.\n"
+                 "\t --quiet only shows errors; the same as '--log-level error'.\n"
+                 "\t --stats prints the time spent in each stage, and other counters, as JSON "
+                 "on exit.\n"
+                 "\t --stats-file PATH writes the JSON stats to PATH instead.\n";
     std::cout << "If a png file cannot be created for a given input row then this id will be "
                  "logged as a failure.\n";
     std::cout << "Caveats:\n"
@@ -48,81 +106,379 @@ void usage(void)
 
     std::cout << "\n";
 }
-} // namespace
 
-int main(int argc, char* argv[])
+/**
+ * @brief Write the stats collected since `start` as JSON, when `--stats` is given.
+ */
+void report_stats(options const& settings, std::chrono::steady_clock::time_point const start)
 {
-    if ((1 != argc) && (3 != argc))
+    if (!settings.stats)
+    {
+        return;
+    }
+
+    auto const wall_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto const stats = snapshot_stats();
+
+    if (settings.stats_file.empty())
+    {
+        write_stats_json(std::cout, stats, wall_seconds);
+        return;
+    }
+
+    auto output = std::ofstream{settings.stats_file};
+    write_stats_json(output, stats, wall_seconds);
+    if (!output)
+    {
+        std::cout << "ERROR: Cannot write stats to " << settings.stats_file.string() << " .\n";
+    }
+}
+
+/**
+ * @brief Print the number of syncs made during the run and how long they took.
+ */
+void report_syncs()
+{
+    auto const stats = snapshot_stats();
+    auto const& sync = stats.stages[static_cast<std::size_t>(stats_stage::sync)];
+    auto const milliseconds = [](std::uint64_t const nanoseconds)
+    {
+        return static_cast<double>(nanoseconds) / 1e6;
+    };
+
+    std::cout << "Synced the output " << sync.calls << " times in "
+              << milliseconds(sync.total_ns) << " ms";
+    if (sync.calls > 0U)
+    {
+        std::cout << " (mean " << milliseconds(sync.total_ns / sync.calls) << " ms, max "
+                  << milliseconds(sync.max_ns) << " ms)";
+    }
+    std::cout << ".\n";
+}
+
+/**
+ * @brief The server stopped by SIGINT and SIGTERM while `--serve` is running.
+ */
+std::atomic<http_server*> running_server{nullptr};
+
+void stop_server(int)
+{
+    if (auto* const server = running_server.load())
+    {
+        server->stop();
+    }
+}
+
+/**
+ * @brief Open the destination of `--failures-file`, if any. Every failure is streamed out as it
+ * occurs, as only a sample is kept in memory.
+ *
+ * @return false if the file cannot be created; `stream` is left null when no file is given.
+ */
+bool open_failure_stream(options const& settings, std::ofstream& file, std::ostream*& stream)
+{
+    if (settings.failures_file == "-")
+    {
+        stream = &std::cerr;
+    }
+    else if (!settings.failures_file.empty())
+    {
+        file.open(settings.failures_file, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "ERROR: Cannot create failures file " << settings.failures_file.string()
+                      << " .\n";
+            return false;
+        }
+        stream = &file;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Print how many failures there were of each cause.
+ */
+void report_failure_causes(std::array<std::size_t, num_error_codes> const& failures_by_error)
+{
+    std::cout << "Failures by cause:\n";
+    for (auto error = std::size_t{0U}; error < num_error_codes; ++error)
+    {
+        if (failures_by_error[error] > 0U)
+        {
+            std::cout << "\t" << to_string(static_cast<error_code>(error)) << ": "
+                      << failures_by_error[error] << "\n";
+        }
+    }
+}
+
+/**
+ * @brief Print the sampled failures followed by the number left out of the sample.
+ */
+template<typename Failure, typename Print>
+void report_failures(
+    options const& settings,
+    std::vector<Failure> const& samples,
+    std::size_t const num_failures,
+    Print const& print
+)
+{
+    std::cout << "ERROR: failures occurred:\n";
+    for (auto const& failure: samples)
+    {
+        print(failure);
+    }
+
+    if (num_failures > samples.size())
+    {
+        std::cout << "\t... and " << (num_failures - samples.size()) << " more";
+        if (settings.failures_file.empty())
+        {
+            std::cout << "; pass --failures-file to record them all";
+        }
+        std::cout << ".\n";
+    }
+}
+
+int verify(options const& settings)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    auto failures_file = std::ofstream{};
+    auto* failure_stream = static_cast<std::ostream*>(nullptr);
+    if (!open_failure_stream(settings, failures_file, failure_stream))
     {
-        std::cout << "Unsupported number of arguments: " << argc << "\n";
-        usage();
         return EXIT_FAILURE;
     }
 
+    auto const summary = verify_directory(*settings.verify, settings, failure_stream);
+    report_stats(settings, start);
+    if (!summary)
+    {
+        std::cout << "ERROR: Cannot read directory " << settings.verify->string() << " .\n";
+        return EXIT_FAILURE;
+    }
+
+    if (failure_stream && !failure_stream->flush())
+    {
+        std::cout << "ERROR: Failed to write the failures to " << settings.failures_file.string()
+                  << " .\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Verified " << summary->num_files << " png files.\n";
+    if (summary->num_failures == 0U)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    report_failures(
+        settings,
+        summary->failures,
+        summary->num_failures,
+        [](verify_failure const& failure)
+        { std::cout << "\t" << failure.file_name << ": " << to_string(failure.error) << "\n"; }
+    );
+    report_failure_causes(summary->failures_by_error);
+    return EXIT_FAILURE;
+}
+
+int serve(options const& settings)
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto const& address = *settings.serve;
+
+    auto const server = http_server::open(address);
+    if (!server)
+    {
+        std::cout << "ERROR: Cannot listen on the requested address.\n";
+        return EXIT_FAILURE;
+    }
+
+    running_server = server.get();
+    std::signal(SIGINT, stop_server);
+    std::signal(SIGTERM, stop_server);
+
+    if (address.unix_path.empty())
+    {
+        std::cout << "Serving png files on port " << server->port() << ".\n";
+    }
+    else
+    {
+        std::cout << "Serving png files on " << address.unix_path << ".\n";
+    }
+    std::cout.flush();
+
+    auto const stopped = server->run();
+    running_server = nullptr;
+
+    report_stats(settings, start);
+
+    return stopped ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
     if (1 == argc)
     {
         usage();
         return EXIT_SUCCESS;
     }
 
-    auto const input_file = std::filesystem::path{argv[1]};
-    if (!is_accessible(input_file, R_OK))
+    auto const parsed = parse_options(argc, argv);
+    if (!parsed)
     {
-        std::cout << "ERROR: Input path " << input_file.string() << " is inaccessible.\n";
+        usage();
         return EXIT_FAILURE;
     }
 
-    auto const output_dir = std::filesystem::path{argv[2]};
-    if (!is_accessible(output_dir, W_OK))
+    set_log_level(parsed->log_threshold);
+    enable_stats(parsed->stats);
+    auto const start = std::chrono::steady_clock::now();
+
+    if (parsed->serve)
     {
-        std::cout << "ERROR: Output path " << output_dir.string() << " is inaccessible.\n";
-        return EXIT_FAILURE;
+        return serve(*parsed);
     }
 
-    auto input = std::ifstream(input_file);
-    if (!input.is_open())
+    if (parsed->verify)
     {
-        std::cout << "ERROR: Cannot open input file " << input_file.string() << " .\n";
+        return verify(*parsed);
+    }
+
+    // An archive written to standard output must not be interleaved with diagnostics.
+    if (parsed->archive == "-")
+    {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    auto const& input_file = parsed->input_file;
+    if (!parsed->range && !is_accessible(input_file, R_OK))
+    {
+        std::cout << "ERROR: Input path " << input_file.string() << " is inaccessible.\n";
         return EXIT_FAILURE;
     }
 
-    std::string id_string;
-    std::vector<std::string> failures{};
+    auto const& output_dir = parsed->output_dir;
+    if (!parsed->archive && !is_accessible(output_dir, W_OK))
+    {
+        std::cout << "ERROR: Output path " << output_dir.string() << " is inaccessible.\n";
+        return EXIT_FAILURE;
+    }
 
-    while (std::getline(input, id_string))
+    // A range of ids is generated directly, without an input file.
+    auto input = std::optional<mapped_file>{};
+    if (!parsed->range)
     {
-        std::cout.flush();
-        
-        auto const id_digits = create_asset_id(id_string);
-        if (!id_digits)
+        auto const timer = stage_timer{stats_stage::read};
+        input = mapped_file::open(input_file);
+        if (!input)
         {
-            failures.push_back(id_string);
-            continue;
+            std::cout << "ERROR: Cannot open input file " << input_file.string() << " .\n";
+            return EXIT_FAILURE;
         }
+    }
 
-        auto const checked_id = create_checked_asset_id(*id_digits);
-        if (!checked_id)
+    auto sink = std::unique_ptr<output_sink>{};
+    if (parsed->archive)
+    {
+        sink = tar_sink::open(*parsed->archive, parsed->durability);
+        if (!sink)
         {
-            failures.push_back(id_string);
-            continue;
+            std::cout << "ERROR: Cannot create archive " << parsed->archive->string() << " .\n";
+            return EXIT_FAILURE;
         }
-
-        auto const output_file = (output_dir / id_string).replace_extension("png");
-
-        if (!write_as_png(*checked_id, output_file))
+    }
+    else if (parsed->sheet_rows > 0U)
+    {
+        sink = std::make_unique<sheet_sink>(output_dir, parsed->sheet_rows, parsed->durability);
+    }
+    else if (parsed->output == output_backend::io_uring)
+    {
+        sink = make_uring_sink(
+            output_dir, parsed->queue_depth, parsed->incremental, parsed->durability
+        );
+        if (!sink)
         {
-            failures.push_back(id_string);
-            continue;
+            log_message(
+                log_level::warning, "io_uring is not available; writing files directly instead."
+            );
         }
     }
 
-    if (!failures.empty())
+    if (!sink)
     {
-        std::cout << "ERROR: failures occurred:\n";
-        for (auto const& failure: failures)
-        {
-            std::cout << "\t" << failure << std::endl;
-        }
+        sink = std::make_unique<directory_sink>(
+            output_dir, parsed->backend, parsed->incremental, parsed->durability
+        );
+    }
+
+    auto failures_file = std::ofstream{};
+    auto* failure_stream = static_cast<std::ostream*>(nullptr);
+    if (!open_failure_stream(*parsed, failures_file, failure_stream))
+    {
+        return EXIT_FAILURE;
+    }
+
+    auto summary = batch_summary{};
+    auto finished = false;
+    {
+        // Diagnostics are written by a background thread while the batch runs, and are all out
+        // before the summary below.
+        auto const drain = log_drain{std::cout};
+        summary = parsed->range
+                      ? process_range(*parsed->range, *parsed, *sink, failure_stream)
+                      : process_batch(input->contents(), *parsed, *sink, failure_stream);
+        auto const timer = stage_timer{stats_stage::finish};
+        finished = sink->finish();
+    }
+
+    report_stats(*parsed, start);
+
+    if (failure_stream && !failure_stream->flush())
+    {
+        std::cout << "ERROR: Failed to write the failures to " << parsed->failures_file.string()
+                  << " .\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!finished)
+    {
+        std::cout << "ERROR: Failed to complete the output.\n";
+        return EXIT_FAILURE;
+    }
+
+    if (parsed->durability.mode != durability_mode::none)
+    {
+        report_syncs();
+    }
+
+    if (summary.duplicates > 0U)
+    {
+        std::cout << "Skipped " << summary.duplicates << " duplicate ids.\n";
+    }
+
+    if (parsed->incremental)
+    {
+        std::cout << "Wrote " << summary.written << " files, skipped " << summary.unchanged
+                  << " up-to-date files.\n";
+    }
+
+    if (summary.num_failures > 0U)
+    {
+        report_failures(
+            *parsed,
+            summary.failures,
+            summary.num_failures,
+            [](batch_failure const& failure)
+            {
+                std::cout << "\t" << failure.text << " (line " << failure.line_number
+                          << "): " << to_string(failure.error) << "\n";
+            }
+        );
+        report_failure_causes(summary.failures_by_error);
         return EXIT_FAILURE;
     }
 
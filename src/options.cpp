@@ -0,0 +1,570 @@
+#include "options.h"
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "id_table.h"
+#include "sheet_sink.h"
+
+namespace
+{
+/**
+ * @brief Parse a strictly positive integer, rejecting any trailing characters.
+ */
+std::optional<unsigned> parse_positive(std::string_view const text)
+{
+    auto value = 0U;
+    auto const* const end = text.data() + text.size();
+    auto const [ptr, ec] = std::from_chars(text.data(), end, value);
+    if ((ec != std::errc{}) || (ptr != end) || (value == 0U))
+    {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Parse the numeric value of an id, rejecting any trailing characters.
+ */
+std::optional<std::uint32_t> parse_id_number(std::string_view const text)
+{
+    auto value = std::uint32_t{0U};
+    auto const* const end = text.data() + text.size();
+    auto const [ptr, ec] = std::from_chars(text.data(), end, value);
+    if ((ec != std::errc{}) || (ptr != end) || (value >= asset_id::num_asset_ids()))
+    {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Parse a range of ids given as `START-END`, where neither end may be past the last id
+ * and START may not be greater than END.
+ */
+std::optional<asset_id::id_range> parse_range(std::string_view const text)
+{
+    auto const separator = text.find('-');
+    if (separator == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+
+    auto const first = parse_id_number(text.substr(0U, separator));
+    auto const last = parse_id_number(text.substr(separator + 1U));
+    if (!first || !last || (*first > *last))
+    {
+        return std::nullopt;
+    }
+
+    return asset_id::id_range{*first, *last};
+}
+
+/**
+ * @brief Parse a shard given as `I/N`, where N is at least 1 and I is less than N.
+ */
+std::optional<asset_id::shard_spec> parse_shard(std::string_view const text)
+{
+    auto const separator = text.find('/');
+    if (separator == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+
+    auto index = std::uint32_t{0U};
+    auto const index_text = text.substr(0U, separator);
+    auto const* const index_end = index_text.data() + index_text.size();
+    auto const [index_ptr, index_ec] = std::from_chars(index_text.data(), index_end, index);
+    auto const count = parse_positive(text.substr(separator + 1U));
+    if ((index_ec != std::errc{}) || (index_ptr != index_end) || index_text.empty() || !count ||
+        (index >= *count))
+    {
+        return std::nullopt;
+    }
+
+    return asset_id::shard_spec{index, *count};
+}
+
+std::optional<asset_id::png_backend> parse_backend(std::string_view const text)
+{
+    if (text == "builtin")
+    {
+        return asset_id::png_backend::builtin;
+    }
+
+    if (text == "libpng")
+    {
+        return asset_id::png_backend::libpng;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<asset_id::output_backend> parse_output_backend(std::string_view const text)
+{
+    if (text == "direct")
+    {
+        return asset_id::output_backend::direct;
+    }
+
+    if (text == "io_uring")
+    {
+        return asset_id::output_backend::io_uring;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<asset_id::durability_mode> parse_durability(std::string_view const text)
+{
+    if (text == "none")
+    {
+        return asset_id::durability_mode::none;
+    }
+
+    if (text == "batch")
+    {
+        return asset_id::durability_mode::batch;
+    }
+
+    if (text == "per-file")
+    {
+        return asset_id::durability_mode::per_file;
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * @brief Walks the command line, handing out the values of options that take one.
+ */
+class argument_reader
+{
+public:
+    argument_reader(int const argc, char const* const argv[]):
+        _argc(argc),
+        _argv(argv)
+    {
+    }
+
+    bool done() const { return _index >= _argc; }
+
+    std::string_view next() { return _argv[_index++]; }
+
+    /**
+     * @brief Take the value following `option`, reporting its absence.
+     */
+    std::optional<std::string_view> value_of(std::string_view const option)
+    {
+        if (done())
+        {
+            std::cout << "Option '" << option << "' requires a value.\n";
+            return std::nullopt;
+        }
+
+        return next();
+    }
+
+    /**
+     * @brief Take the strictly positive integer value following `option`, reporting any error.
+     */
+    std::optional<unsigned> positive_value_of(std::string_view const option)
+    {
+        auto const text = value_of(option);
+        if (!text)
+        {
+            return std::nullopt;
+        }
+
+        auto const value = parse_positive(*text);
+        if (!value)
+        {
+            std::cout << "Option '" << option << "' requires a positive integer, got '" << *text
+                      << "'.\n";
+        }
+
+        return value;
+    }
+
+private:
+    int _argc;
+    char const* const* _argv;
+    int _index = 1;
+};
+} // namespace
+
+namespace asset_id
+{
+unsigned default_jobs()
+{
+    auto const hardware_jobs = std::thread::hardware_concurrency();
+    return (hardware_jobs == 0U) ? 1U : hardware_jobs;
+}
+
+std::optional<options> parse_options(int const argc, char const* const argv[])
+{
+    auto result = options{};
+    result.jobs = default_jobs();
+
+    std::vector<std::string_view> positional{};
+
+    auto arguments = argument_reader{argc, argv};
+    while (!arguments.done())
+    {
+        auto const argument = arguments.next();
+
+        if (argument == "--jobs")
+        {
+            auto const jobs = arguments.positive_value_of(argument);
+            if (!jobs)
+            {
+                return std::nullopt;
+            }
+
+            result.jobs = *jobs;
+            continue;
+        }
+
+        if (argument == "--png-backend")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const backend = text ? parse_backend(*text) : std::nullopt;
+            if (!backend)
+            {
+                std::cout << "Option '--png-backend' requires one of 'builtin' or 'libpng'.\n";
+                return std::nullopt;
+            }
+
+            if (!is_available(*backend))
+            {
+                std::cout << "The png backend '" << *text << "' is not available in this build.\n";
+                return std::nullopt;
+            }
+
+            result.backend = *backend;
+            continue;
+        }
+
+        if (argument == "--output-backend")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const backend = text ? parse_output_backend(*text) : std::nullopt;
+            if (!backend)
+            {
+                std::cout << "Option '--output-backend' requires one of 'direct' or 'io_uring'.\n";
+                return std::nullopt;
+            }
+
+            result.output = *backend;
+            continue;
+        }
+
+        if (argument == "--queue-depth")
+        {
+            auto const queue_depth = arguments.positive_value_of(argument);
+            if (!queue_depth)
+            {
+                return std::nullopt;
+            }
+
+            result.queue_depth = *queue_depth;
+            continue;
+        }
+
+        if (argument == "--archive")
+        {
+            auto const path = arguments.value_of(argument);
+            if (!path)
+            {
+                return std::nullopt;
+            }
+
+            result.archive = std::filesystem::path{*path};
+            continue;
+        }
+
+        if (argument == "--sheet")
+        {
+            auto const rows = arguments.positive_value_of(argument);
+            if (!rows)
+            {
+                return std::nullopt;
+            }
+
+            if (!sheets_available())
+            {
+                std::cout << "Sprite sheets are not available in this build.\n";
+                return std::nullopt;
+            }
+
+            result.sheet_rows = *rows;
+            continue;
+        }
+
+        if (argument == "--range")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const range = text ? parse_range(*text) : std::nullopt;
+            if (!range)
+            {
+                std::cout << "Option '--range' requires 'START-END' with START <= END <= "
+                          << (num_asset_ids() - 1U) << ".\n";
+                return std::nullopt;
+            }
+
+            result.range = *range;
+            continue;
+        }
+
+        if (argument == "--all")
+        {
+            result.range = id_range{0U, num_asset_ids() - 1U};
+            continue;
+        }
+
+        if (argument == "--shard")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const shard = text ? parse_shard(*text) : std::nullopt;
+            if (!shard)
+            {
+                std::cout << "Option '--shard' requires 'I/N' with 0 <= I < N.\n";
+                return std::nullopt;
+            }
+
+            result.shard = *shard;
+            continue;
+        }
+
+        if (argument == "--durability")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const mode = text ? parse_durability(*text) : std::nullopt;
+            if (!mode)
+            {
+                std::cout << "Option '--durability' requires one of 'none', 'batch' or "
+                             "'per-file'.\n";
+                return std::nullopt;
+            }
+
+            result.durability.mode = *mode;
+            continue;
+        }
+
+        if (argument == "--sync-interval")
+        {
+            auto const interval = arguments.positive_value_of(argument);
+            if (!interval)
+            {
+                return std::nullopt;
+            }
+
+            result.durability.sync_interval = *interval;
+            continue;
+        }
+
+        if (argument == "--no-dedup")
+        {
+            result.dedup = false;
+            continue;
+        }
+
+        if (argument == "--incremental")
+        {
+            result.incremental = true;
+            continue;
+        }
+
+        if (argument == "--verify")
+        {
+            auto const path = arguments.value_of(argument);
+            if (!path)
+            {
+                return std::nullopt;
+            }
+
+            result.verify = std::filesystem::path{*path};
+            continue;
+        }
+
+        if (argument == "--failures-file")
+        {
+            auto const path = arguments.value_of(argument);
+            if (!path)
+            {
+                return std::nullopt;
+            }
+
+            result.failures_file = std::filesystem::path{*path};
+            continue;
+        }
+
+        if (argument == "--failure-samples")
+        {
+            auto const samples = arguments.positive_value_of(argument);
+            if (!samples)
+            {
+                return std::nullopt;
+            }
+
+            result.failure_samples = *samples;
+            continue;
+        }
+
+        if (argument == "--quiet")
+        {
+            result.log_threshold = log_level::error;
+            continue;
+        }
+
+        if (argument == "--log-level")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const level = text ? parse_log_level(*text) : std::nullopt;
+            if (!level)
+            {
+                std::cout << "Option '--log-level' requires one of 'debug', 'info', 'warning', "
+                             "'error' or 'off'.\n";
+                return std::nullopt;
+            }
+
+            result.log_threshold = *level;
+            continue;
+        }
+
+        if (argument == "--stats")
+        {
+            result.stats = true;
+            continue;
+        }
+
+        if (argument == "--stats-file")
+        {
+            auto const path = arguments.value_of(argument);
+            if (!path)
+            {
+                return std::nullopt;
+            }
+
+            result.stats = true;
+            result.stats_file = std::filesystem::path{*path};
+            continue;
+        }
+
+        if (argument == "--serve")
+        {
+            auto const text = arguments.value_of(argument);
+            auto const address = text ? parse_listen_address(*text) : std::nullopt;
+            if (!address)
+            {
+                std::cout << "Option '--serve' requires 'HOST:PORT' or the path of a unix "
+                             "socket.\n";
+                return std::nullopt;
+            }
+
+            result.serve = *address;
+            continue;
+        }
+
+        if ((argument.size() > 1U) && (argument[0] == '-'))
+        {
+            std::cout << "Unsupported option '" << argument << "'.\n";
+            return std::nullopt;
+        }
+
+        positional.push_back(argument);
+    }
+
+    // `--range` takes the place of the input file, and `--archive` of the output directory.
+    auto const num_positional = (result.serve || result.verify)
+                                    ? 0U
+                                    : (2U - (result.range ? 1U : 0U) - (result.archive ? 1U : 0U));
+    if (positional.size() != num_positional)
+    {
+        std::cout << "Unsupported number of arguments: " << positional.size() << "\n";
+        return std::nullopt;
+    }
+
+    if ((result.output == output_backend::io_uring) && (result.backend != png_backend::builtin))
+    {
+        std::cout << "The io_uring output backend only supports the builtin png backend.\n";
+        return std::nullopt;
+    }
+
+    if (result.archive && (result.backend != png_backend::builtin))
+    {
+        std::cout << "Archives only support the builtin png backend.\n";
+        return std::nullopt;
+    }
+
+    if (result.incremental && (result.archive || (result.backend != png_backend::builtin)))
+    {
+        std::cout << "Incremental runs need an output directory and the builtin png backend.\n";
+        return std::nullopt;
+    }
+
+    // The sheets of every shard would be numbered, and named, from 0.
+    if ((result.sheet_rows > 0U) &&
+        (result.archive || result.serve || result.incremental || (result.shard.count > 1U) ||
+         (result.backend != png_backend::builtin) || (result.output != output_backend::direct)))
+    {
+        std::cout << "Sprite sheets need an output directory and cannot be combined with "
+                     "--archive, --serve, --incremental, --shard or another backend.\n";
+        return std::nullopt;
+    }
+
+    auto const sharded = (result.shard.count > 1U);
+
+    auto const durable = (result.durability.mode != durability_mode::none);
+    if (durable && (result.archive == "-"))
+    {
+        std::cout << "An archive written to standard output cannot be made durable.\n";
+        return std::nullopt;
+    }
+
+    if (result.verify)
+    {
+        if (result.serve || result.archive || result.range || result.incremental ||
+            (result.sheet_rows > 0U) || (result.output != output_backend::direct) || durable ||
+            sharded)
+        {
+            std::cout << "Verifying cannot be combined with --serve, --archive, --range, "
+                         "--incremental, --sheet, --durability, --shard or another output "
+                         "backend.\n";
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    if (result.serve)
+    {
+        if (result.archive || result.range || result.incremental || durable || sharded ||
+            (result.backend != png_backend::builtin) || (result.output != output_backend::direct))
+        {
+            std::cout << "Serving cannot be combined with --archive, --range, --incremental, "
+                         "--durability, --shard, the libpng backend or another output "
+                         "backend.\n";
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    auto next_positional = positional.begin();
+    if (!result.range)
+    {
+        result.input_file = *next_positional++;
+    }
+    if (!result.archive)
+    {
+        result.output_dir = *next_positional++;
+    }
+
+    return result;
+}
+} // namespace asset_id
@@ -0,0 +1,214 @@
+/**
+ * @file   options.h
+ * @brief  Command line options accepted by the `asset_id` tool.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "durability.h"
+#include "http_server.h"
+#include "logger.h"
+#include "uring_sink.h"
+#include "write_png.h"
+
+namespace asset_id
+{
+/**
+ * @brief The `output_backend` type selects how png files are written to the output directory.
+ *
+ * `direct` writes each file with plain system calls into a temporary file that is then linked
+ * or renamed into place; `io_uring` batches the same atomic sequence through io_uring where the
+ * build and kernel support it, and otherwise falls back to `direct`.
+ */
+enum class output_backend
+{
+    direct,
+    io_uring,
+};
+
+/**
+ * @brief The number of failures listed in the summary at the end of a run, unless
+ * `--failure-samples` is given.
+ */
+constexpr std::size_t default_failure_samples = 1000U;
+
+/**
+ * @brief The `id_range` type holds an inclusive range of ids by their numeric values.
+ */
+struct id_range
+{
+    std::uint32_t first = 0U;
+    std::uint32_t last = 0U;
+};
+
+/**
+ * @brief The `shard_spec` type selects the part of a job handled by one of several processes.
+ *
+ * A well formed id belongs to shard `number % count`, so every occurrence of an id, and the
+ * decision whether it is a duplicate, lands in the same shard. A malformed line has no id and
+ * belongs to shard `(line_number - 1) % count` instead. The shards of a job therefore share
+ * out every line exactly once, and their summaries add up to that of a single run.
+ */
+struct shard_spec
+{
+    /**
+     * @brief The shard handled by this process; less than `count`.
+     */
+    std::uint32_t index = 0U;
+
+    /**
+     * @brief The number of shards the job is split into; 1 handles the whole job.
+     */
+    std::uint32_t count = 1U;
+
+    bool owns_id(std::uint32_t const number) const { return (number % count) == index; }
+
+    bool owns_line(std::size_t const line_number) const
+    {
+        return ((line_number - 1U) % count) == index;
+    }
+};
+
+/**
+ * @brief The `options` type holds the validated command line of a single invocation of the tool.
+ */
+struct options
+{
+    /**
+     * @brief The file listing the ids; empty when `range` or `serve` is given.
+     */
+    std::filesystem::path input_file;
+
+    /**
+     * @brief When given, every id in this range is generated, in increasing order, instead of
+     * the ids listed in `input_file`.
+     */
+    std::optional<id_range> range;
+
+    /**
+     * @brief The part of the input, or range, handled by this process.
+     */
+    shard_spec shard;
+
+    /**
+     * @brief The directory holding the png files; empty when `archive` is given.
+     */
+    std::filesystem::path output_dir;
+
+    /**
+     * @brief When given, every png file is written into this tar archive (`-` for standard
+     * output) instead of into `output_dir`.
+     */
+    std::optional<std::filesystem::path> archive;
+
+    /**
+     * @brief When not 0, the ids are written into `output_dir` as the rows of sprite sheets
+     * holding at most this many ids each, instead of one png file per id.
+     */
+    unsigned sheet_rows = 0U;
+
+    /**
+     * @brief Number of worker threads used to generate the png files; always at least 1.
+     */
+    unsigned jobs = 1U;
+
+    /**
+     * @brief The encoder used to write the png files.
+     */
+    png_backend backend = png_backend::builtin;
+
+    /**
+     * @brief How the png files are written to the output directory.
+     */
+    output_backend output = output_backend::direct;
+
+    /**
+     * @brief The number of files in flight at once with the io_uring output backend.
+     */
+    unsigned queue_depth = default_queue_depth;
+
+    /**
+     * @brief When, and how often, the generated files are synced to disk.
+     */
+    durability_settings durability;
+
+    /**
+     * @brief Whether repeated ids are skipped after their first occurrence.
+     */
+    bool dedup = true;
+
+    /**
+     * @brief Whether png files already holding the expected bytes are left untouched.
+     */
+    bool incremental = false;
+
+    /**
+     * @brief When given, the tool serves png files over HTTP on this address instead of
+     * processing an input file; `input_file` and `output_dir` are then empty.
+     */
+    std::optional<listen_address> serve;
+
+    /**
+     * @brief When given, the png files already in this directory are verified instead of
+     * generating any; `input_file` and `output_dir` are then empty.
+     */
+    std::optional<std::filesystem::path> verify;
+
+    /**
+     * @brief The most failures kept in memory for the summary; the remainder are only counted.
+     */
+    std::size_t failure_samples = default_failure_samples;
+
+    /**
+     * @brief When not empty, every failure is written to this file (`-` for standard error) as
+     * soon as it occurs.
+     */
+    std::filesystem::path failures_file;
+
+    /**
+     * @brief Diagnostics below this level are discarded.
+     */
+    log_level log_threshold = default_log_level;
+
+    /**
+     * @brief Whether stage timings and counters are collected and written as JSON on exit.
+     */
+    bool stats = false;
+
+    /**
+     * @brief When not empty, the JSON stats are written to this file instead of standard output.
+     */
+    std::filesystem::path stats_file;
+};
+
+/**
+ * @return unsigned holding the number of jobs used when `--jobs` is not given; this is the
+ *         hardware concurrency of the host, or 1 if that cannot be determined.
+ */
+unsigned default_jobs();
+
+/**
+ * @brief Attempt to parse the command line of the tool.
+ *
+ * Flags (`--jobs N`, `--png-backend builtin|libpng`, `--output-backend direct|io_uring`,
+ * `--queue-depth N`, `--archive PATH`, `--sheet N`, `--range START-END`, `--all`,
+ * `--shard I/N`, `--durability none|batch|per-file`, `--sync-interval N`, `--no-dedup`,
+ * `--incremental`, `--serve ADDRESS`, `--verify DIR`, `--failures-file PATH`,
+ * `--failure-samples N`, `--quiet`, `--log-level LEVEL`, `--stats`, `--stats-file PATH`) may
+ * appear anywhere on the command line; the remaining arguments are taken, in order, as the
+ * input file and output directory. There is no input file with `--range` or `--all`, no output
+ * directory when `--archive` is given, and no positional argument at all with `--serve` or
+ * `--verify`.
+ *
+ * @param argc  the number of entries in `argv`, including the program name.
+ * @param argv  the command line arguments.
+ *
+ * @return std::optional<options> containing the parsed options if the command line is
+ *         well formed; empty optional otherwise.
+ */
+std::optional<options> parse_options(int argc, char const* const argv[]);
+} // namespace asset_id
@@ -0,0 +1,132 @@
+#include "output_sink.h"
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atomic_write.h"
+#include "stats.h"
+
+namespace asset_id
+{
+bool file_matches(int const dir_fd, char const* const name, encoded_png_t const& expected)
+{
+    auto const fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // Every file is tiny, so a size check followed by a single read and compare is cheaper than
+    // hashing either side.
+    struct stat status
+    {
+    };
+    auto matches = (fstat(fd, &status) == 0) &&
+                   (static_cast<std::size_t>(status.st_size) == expected.size());
+
+    if (matches)
+    {
+        auto actual = encoded_png_t{};
+        matches = (pread(fd, actual.data(), actual.size(), 0) ==
+                   static_cast<ssize_t>(actual.size())) &&
+                  (std::memcmp(actual.data(), expected.data(), actual.size()) == 0);
+    }
+
+    close(fd);
+    return matches;
+}
+
+encoded_png_t builtin_encoding(output_item const& item)
+{
+    if (item.encoded)
+    {
+        return *item.encoded;
+    }
+
+    auto const timer = stage_timer{stats_stage::encode};
+    return encode_png(item.rendered->pixels);
+}
+
+directory_sink::directory_sink(
+    std::filesystem::path const& output_dir,
+    png_backend const backend,
+    bool const incremental,
+    durability_settings const& durability
+):
+    _dir_fd(open(output_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)),
+    _backend(backend),
+    _incremental(incremental),
+    _sync(durability)
+{
+}
+
+directory_sink::~directory_sink()
+{
+    if (_dir_fd >= 0)
+    {
+        close(_dir_fd);
+    }
+}
+
+void directory_sink::write(output_item* const items, std::size_t const num_items)
+{
+    // Only the name of each file is resolved, relative to the directory opened once up front.
+    auto name = std::string{};
+    auto num_written = std::size_t{0U};
+    for (auto index = std::size_t{0U}; index < num_items; ++index)
+    {
+        auto& item = items[index];
+        if (_dir_fd < 0)
+        {
+            item.error = error_code::io_error;
+            continue;
+        }
+
+        name.assign(item.file_stem);
+        name += ".png";
+
+        if (_incremental && file_matches(_dir_fd, name.c_str(), builtin_encoding(item)))
+        {
+            item.written = true;
+            item.unchanged = true;
+            continue;
+        }
+
+        auto const written = [&]()
+        {
+            if (!item.encoded || (_backend != png_backend::builtin))
+            {
+                return write_as_png(
+                    item.rendered->pixels, _dir_fd, name.c_str(), _backend, _sync.per_file()
+                );
+            }
+
+            auto const timer = stage_timer{stats_stage::write};
+            return write_file_atomically(
+                _dir_fd,
+                name.c_str(),
+                item.encoded->data(),
+                item.encoded->size(),
+                _sync.per_file()
+            );
+        }();
+        item.written = written.has_value();
+        if (!written)
+        {
+            item.error = written.error();
+            continue;
+        }
+        ++num_written;
+    }
+
+    _sync.files_written(_dir_fd, num_written);
+}
+
+bool directory_sink::finish()
+{
+    // Without a directory no file was written, and each one has been reported as failed.
+    return (_dir_fd < 0) || _sync.finish(_dir_fd);
+}
+} // namespace asset_id
@@ -0,0 +1,198 @@
+/**
+ * @file   output_sink.h
+ * @brief  Destinations for the png files generated by the tool.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "durability.h"
+#include "id_table.h"
+#include "write_png.h"
+
+namespace asset_id
+{
+/**
+ * @brief The `output_item` type describes a single png file to be written by an `output_sink`.
+ */
+struct output_item
+{
+    /**
+     * @brief The name of the file without its `.png` extension; normally the asset id text.
+     */
+    std::string_view file_stem;
+
+    /**
+     * @brief The precomputed checked id and pixels to write.
+     */
+    rendered_id_t const* rendered = nullptr;
+
+    /**
+     * @brief Set by the sink once the file has been completely written, or found to be up to
+     * date already.
+     */
+    bool written = false;
+
+    /**
+     * @brief Set by an incremental sink, along with `written`, when the existing file already
+     * held the expected bytes and was left untouched.
+     */
+    bool unchanged = false;
+
+    /**
+     * @brief Set by the sink to the reason the file could not be written; only meaningful when
+     * `written` is false.
+     */
+    error_code error = error_code::io_error;
+
+    /**
+     * @brief The builtin png encoding of `rendered` when the batch has encoded it already;
+     * otherwise null, and a sink that needs the encoding creates it itself.
+     */
+    encoded_png_t const* encoded = nullptr;
+
+    /**
+     * @brief Set by a sink, instead of `written`, when the file has been accepted but its
+     * outcome is only known once more of the output is complete; see
+     * `output_sink::take_settled`.
+     */
+    bool deferred = false;
+};
+
+/**
+ * @brief The outcome of a run of deferred items, in the order they were handed to the sink.
+ */
+struct deferred_outcome
+{
+    std::size_t num_items = 0U;
+    bool written = false;
+
+    /**
+     * @brief Why the items could not be written; only meaningful when `written` is false.
+     */
+    error_code error = error_code::io_error;
+};
+
+/**
+ * @brief Check whether an existing file holds exactly the expected png file.
+ *
+ * @param dir_fd    the directory that `name` is relative to, or `AT_FDCWD`.
+ * @param name      the path of the file to check.
+ * @param expected  the bytes the file should hold.
+ *
+ * @return true   if the file exists and its contents are identical to `expected`.
+ * @return false  otherwise.
+ */
+bool file_matches(int dir_fd, char const* name, encoded_png_t const& expected);
+
+/**
+ * @return encoded_png_t holding the builtin png encoding of `item`; taken from `item.encoded`
+ *         when it is set, otherwise encoded from its pixels.
+ */
+encoded_png_t builtin_encoding(output_item const& item);
+
+/**
+ * @brief Interface implemented by every destination of the generated png files.
+ */
+class output_sink
+{
+public:
+    output_sink() = default;
+    output_sink(output_sink const&) = delete;
+    output_sink(output_sink&&) = delete;
+
+    output_sink& operator=(output_sink const&) = delete;
+    output_sink& operator=(output_sink&&) = delete;
+
+    virtual ~output_sink() = default;
+
+    /**
+     * @brief Write a group of png files, setting `written` on each item that succeeded.
+     *
+     * @param items      the files to write.
+     * @param num_items  the number of entries in `items`.
+     */
+    virtual void write(output_item* items, std::size_t num_items) = 0;
+
+    /**
+     * @return true   if `write` may be called from several threads at once with disjoint items;
+     *                the batch then writes each file from the worker thread that rendered it.
+     * @return false  if every call to `write` must come from a single thread; the batch then
+     *                hands over whole chunks of items, in input order.
+     */
+    virtual bool is_concurrent() const = 0;
+
+    /**
+     * @return true   if the sink writes the builtin encoding of every file; the batch then
+     *                encodes the files on its worker threads and sets `output_item::encoded`.
+     * @return false  if the sink encodes the pixels in its own way.
+     */
+    virtual bool wants_encoded() const { return false; }
+
+    /**
+     * @brief Append the outcome of the items deferred by `write` that have been settled since
+     * the last call, oldest first; only a sink that is not concurrent defers items.
+     */
+    virtual void take_settled(std::vector<deferred_outcome>& /*outcomes*/) {}
+
+    /**
+     * @brief Settle every item deferred so far; called once every file has been handed to
+     * `write`, and before `finish`.
+     */
+    virtual void settle_all() {}
+
+    /**
+     * @brief Complete the output once every file has been written.
+     *
+     * @return true   if all of the output was completed.
+     * @return false  otherwise; the files reported as written may not all be usable.
+     */
+    virtual bool finish() { return true; }
+};
+
+/**
+ * @brief Writes each png file into a directory, replacing any existing file atomically.
+ *
+ * The directory is opened once, and every file is written relative to it with
+ * `write_file_atomically`, so a reader never sees a partially written file. An incremental
+ * sink first compares any existing file with the builtin encoding of the id and leaves it
+ * untouched if they are identical; incremental sinks therefore require the builtin png
+ * backend. The files are synced to disk as `durability` requires.
+ */
+class directory_sink final : public output_sink
+{
+public:
+    /**
+     * @brief Open `output_dir` for writing; if it cannot be opened every item fails with
+     * `error_code::io_error`.
+     */
+    directory_sink(
+        std::filesystem::path const& output_dir,
+        png_backend backend,
+        bool incremental = false,
+        durability_settings const& durability = {}
+    );
+
+    ~directory_sink() override;
+
+    void write(output_item* items, std::size_t num_items) override;
+
+    bool is_concurrent() const override { return true; }
+
+    bool wants_encoded() const override { return _backend == png_backend::builtin; }
+
+    /**
+     * @brief Sync the output directory to disk unless the durability mode is `none`.
+     */
+    bool finish() override;
+
+private:
+    int _dir_fd;
+    png_backend _backend;
+    bool _incremental;
+    sync_schedule _sync;
+};
+} // namespace asset_id
@@ -0,0 +1,271 @@
+#include "png_decoder.h"
+#include <array>
+#include <cstring>
+
+#ifndef ASSET_ID_WITH_ZLIB
+#define ASSET_ID_WITH_ZLIB 0
+#endif
+
+#if ASSET_ID_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "png_encoder.h"
+
+namespace
+{
+constexpr std::uint8_t const png_signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+/**
+ * @brief The data of the only IHDR chunk accepted: 256x1 pixels, 1 bit grayscale, deflate,
+ * adaptive filtering and no interlacing.
+ */
+constexpr std::uint8_t const expected_ihdr[] = {0, 0, 1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0};
+static_assert(asset_id::image_line_width_pixels == 256U);
+
+/**
+ * @brief A single scanline: the filter type followed by the packed pixels.
+ */
+constexpr auto const scanline_length = std::size_t{1U} + asset_id::image_line_num_bytes;
+
+/**
+ * @brief The most image data accepted across all IDAT chunks; a valid file needs far less.
+ */
+constexpr auto const max_idat_bytes = std::size_t{4096U};
+
+/**
+ * @brief The decompressed image data, with room for one extra byte so that an oversized
+ * stream is detected.
+ */
+using scanline_buffer_t = std::array<std::uint8_t, scanline_length + 1U>;
+
+std::uint32_t get_u32(std::uint8_t const* const bytes)
+{
+    return (std::uint32_t{bytes[0]} << 24U) | (std::uint32_t{bytes[1]} << 16U) |
+           (std::uint32_t{bytes[2]} << 8U) | std::uint32_t{bytes[3]};
+}
+
+bool has_tag(std::uint8_t const* const tag, char const (&expected)[5])
+{
+    return std::memcmp(tag, expected, 4U) == 0;
+}
+
+/**
+ * @brief Decode a zlib stream made only of stored deflate blocks, as written by `encode_png`.
+ *
+ * @return result<std::size_t> holding the number of bytes decoded into `output`;
+ *         `error_code::backend_unavailable` if the stream holds a compressed block, and
+ *         `error_code::corrupt_png` if it is malformed.
+ */
+asset_id::result<std::size_t> inflate_stored(
+    std::uint8_t const* const stream, std::size_t const size, scanline_buffer_t& output
+)
+{
+    // The zlib header has already been checked; the Adler-32 follows the last block.
+    auto position = std::size_t{2U};
+    auto num_decoded = std::size_t{0U};
+    auto final_block = false;
+    while (!final_block)
+    {
+        if (position + 5U > size)
+        {
+            return asset_id::error_code::corrupt_png;
+        }
+
+        final_block = (stream[position] & 1U) != 0U;
+        if (((stream[position] >> 1U) & 3U) != 0U)
+        {
+            return asset_id::error_code::backend_unavailable;
+        }
+
+        auto const length = std::size_t{stream[position + 1U]} |
+                            (std::size_t{stream[position + 2U]} << 8U);
+        auto const complement = std::size_t{stream[position + 3U]} |
+                                (std::size_t{stream[position + 4U]} << 8U);
+        position += 5U;
+        if (((length ^ complement) != 0xFFFFU) || (position + length > size) ||
+            (num_decoded + length > output.size()))
+        {
+            return asset_id::error_code::corrupt_png;
+        }
+
+        std::memcpy(output.data() + num_decoded, stream + position, length);
+        num_decoded += length;
+        position += length;
+    }
+
+    if ((position + 4U != size) ||
+        (get_u32(stream + position) != asset_id::adler32(output.data(), num_decoded)))
+    {
+        return asset_id::error_code::corrupt_png;
+    }
+
+    return num_decoded;
+}
+
+/**
+ * @brief Decode any zlib stream through zlib, which also checks its Adler-32.
+ */
+asset_id::result<std::size_t> inflate_zlib(
+    [[maybe_unused]] std::uint8_t const* const stream,
+    [[maybe_unused]] std::size_t const size,
+    [[maybe_unused]] scanline_buffer_t& output
+)
+{
+#if ASSET_ID_WITH_ZLIB
+    z_stream inflater{};
+    if (inflateInit(&inflater) != Z_OK)
+    {
+        return asset_id::error_code::backend_unavailable;
+    }
+
+    inflater.next_in = const_cast<Bytef*>(stream);
+    inflater.avail_in = static_cast<uInt>(size);
+    inflater.next_out = output.data();
+    inflater.avail_out = static_cast<uInt>(output.size());
+    auto const status = inflate(&inflater, Z_FINISH);
+    auto const num_decoded = output.size() - inflater.avail_out;
+    auto const all_used = (inflater.avail_in == 0U);
+    inflateEnd(&inflater);
+
+    if ((status != Z_STREAM_END) || !all_used)
+    {
+        return asset_id::error_code::corrupt_png;
+    }
+
+    return num_decoded;
+#else
+    return asset_id::error_code::backend_unavailable;
+#endif
+}
+
+/**
+ * @brief Undo the filter of the only scanline. With no row above it, `Up` leaves the bytes
+ * unchanged and `Paeth` always predicts from the byte to the left, like `Sub`.
+ */
+bool unfilter(std::uint8_t* const bytes, std::size_t const length, std::uint8_t const filter)
+{
+    switch (filter)
+    {
+        case 0U: // None
+        case 2U: // Up
+            return true;
+        case 1U: // Sub
+        case 4U: // Paeth
+            for (auto index = std::size_t{1U}; index < length; ++index)
+            {
+                bytes[index] = static_cast<std::uint8_t>(bytes[index] + bytes[index - 1U]);
+            }
+            return true;
+        case 3U: // Average
+            for (auto index = std::size_t{1U}; index < length; ++index)
+            {
+                bytes[index] = static_cast<std::uint8_t>(bytes[index] + bytes[index - 1U] / 2U);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+} // namespace
+
+namespace asset_id
+{
+result<image_line_t> decode_png(std::uint8_t const* const data, std::size_t const size)
+{
+    if ((size < sizeof(png_signature)) ||
+        (std::memcmp(data, png_signature, sizeof(png_signature)) != 0))
+    {
+        return error_code::corrupt_png;
+    }
+
+    // Gather the image data from every IDAT chunk, checking each chunk on the way to IEND.
+    std::array<std::uint8_t, max_idat_bytes> idat{};
+    auto idat_size = std::size_t{0U};
+    auto position = sizeof(png_signature);
+    auto first_chunk = true;
+    auto ended = false;
+    while (!ended)
+    {
+        if (size - position < 12U)
+        {
+            return error_code::corrupt_png;
+        }
+
+        auto const length = std::size_t{get_u32(data + position)};
+        if (length > size - position - 12U)
+        {
+            return error_code::corrupt_png;
+        }
+
+        auto const* const tag = data + position + 4U;
+        auto const* const chunk_data = tag + 4U;
+        if (~crc32_update(0xFFFFFFFFU, tag, 4U + length) != get_u32(chunk_data + length))
+        {
+            return error_code::corrupt_png;
+        }
+
+        if (first_chunk)
+        {
+            if (!has_tag(tag, "IHDR") || (length != sizeof(expected_ihdr)) ||
+                (std::memcmp(chunk_data, expected_ihdr, sizeof(expected_ihdr)) != 0))
+            {
+                return error_code::corrupt_png;
+            }
+        }
+        else if (has_tag(tag, "IDAT"))
+        {
+            if (idat_size + length > idat.size())
+            {
+                return error_code::corrupt_png;
+            }
+            std::memcpy(idat.data() + idat_size, chunk_data, length);
+            idat_size += length;
+        }
+        else if (has_tag(tag, "IEND"))
+        {
+            ended = true;
+        }
+        else if ((tag[0] & 0x20U) == 0U)
+        {
+            // An unknown critical chunk, or a palette, cannot be part of these images.
+            return error_code::corrupt_png;
+        }
+
+        first_chunk = false;
+        position += 12U + length;
+    }
+
+    // Nothing may follow IEND; the zlib header must name deflate without a dictionary.
+    if ((position != size) || (idat_size < 6U) || ((idat[0] & 0x0FU) != 8U) ||
+        ((idat[1] & 0x20U) != 0U) || (((idat[0] << 8U) | idat[1]) % 31U != 0U))
+    {
+        return error_code::corrupt_png;
+    }
+
+    scanline_buffer_t scanline{};
+    auto decoded = inflate_stored(idat.data(), idat_size, scanline);
+    if (!decoded && (decoded.error() == error_code::backend_unavailable))
+    {
+        decoded = inflate_zlib(idat.data(), idat_size, scanline);
+    }
+    if (!decoded)
+    {
+        return decoded.error();
+    }
+
+    if ((*decoded != scanline_length) ||
+        !unfilter(scanline.data() + 1U, image_line_num_bytes, scanline[0]))
+    {
+        return error_code::corrupt_png;
+    }
+
+    // A set bit in the image is white, while a set bit in an image line is black.
+    auto pixels = image_line_t{};
+    for (auto index = std::size_t{0U}; index < pixels.size(); ++index)
+    {
+        pixels[index] = static_cast<std::uint8_t>(~scanline[1U + index]);
+    }
+    return pixels;
+}
+} // namespace asset_id
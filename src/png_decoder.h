@@ -0,0 +1,32 @@
+/**
+ * @file   png_decoder.h
+ * @brief  Decodes the single line png files written by this tool back into image lines.
+ *
+ * Only the geometry the tool writes (256x1 pixels, 1 bit grayscale, not interlaced) is
+ * accepted, and every chunk crc and the Adler-32 of the image data are checked. Stored deflate
+ * blocks, as written by `encode_png`, are decoded directly; compressed blocks, as written by
+ * libpng, are only decoded when the tool is built with `ASSET_ID_WITH_ZLIB`.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "image_line.h"
+#include "result.h"
+
+namespace asset_id
+{
+/**
+ * @brief Decode a png file held in memory into the line of pixels it shows.
+ *
+ * @param data  the bytes of the file.
+ * @param size  the number of bytes in `data`.
+ *
+ * @return result<image_line_t> holding the pixels, with a set bit for every black pixel as in
+ *         `encode_png`; otherwise `error_code::corrupt_png` if the file is malformed, has a
+ *         different geometry or fails a checksum, and `error_code::backend_unavailable` if its
+ *         image data is compressed and zlib is not part of this build.
+ */
+result<image_line_t> decode_png(std::uint8_t const* data, std::size_t size);
+} // namespace asset_id
@@ -0,0 +1,185 @@
+#include "png_encoder.h"
+
+namespace
+{
+using asset_id::encoded_png_t;
+
+/**
+ * @brief Byte-wise lookup table for the CRC-32 polynomial used by png (0xEDB88320, reflected).
+ */
+constexpr std::array<std::uint32_t, 256U> make_crc_table()
+{
+    std::array<std::uint32_t, 256U> table{};
+    for (auto index = 0U; index < table.size(); ++index)
+    {
+        auto value = std::uint32_t{index};
+        for (auto bit = 0U; bit < 8U; ++bit)
+        {
+            value = (value & 1U) ? (0xEDB88320U ^ (value >> 1U)) : (value >> 1U);
+        }
+        table[index] = value;
+    }
+    return table;
+}
+
+constexpr auto const crc_table = make_crc_table();
+
+constexpr std::uint32_t
+crc32_update_impl(std::uint32_t crc, std::uint8_t const* data, std::size_t const length)
+{
+    for (auto index = std::size_t{0U}; index < length; ++index)
+    {
+        crc = crc_table[(crc ^ data[index]) & 0xFFU] ^ (crc >> 8U);
+    }
+    return crc;
+}
+
+/**
+ * @brief Layout of the encoded file; every offset is into `encoded_png_t`.
+ *
+ * The IDAT chunk holds a zlib stream made of a two byte header, a single stored deflate block
+ * (a five byte header followed by the raw scanline) and the Adler-32 of the scanline.
+ */
+constexpr auto const ihdr_offset = std::size_t{8U};
+constexpr auto const ihdr_data_length = std::size_t{13U};
+constexpr auto const idat_offset = ihdr_offset + 12U + ihdr_data_length;
+constexpr auto const scanline_length = std::size_t{1U} + asset_id::image_line_num_bytes;
+constexpr auto const idat_data_length = std::size_t{2U} + 5U + scanline_length + 4U;
+constexpr auto const scanline_offset = idat_offset + 8U + 2U + 5U;
+constexpr auto const adler_offset = scanline_offset + scanline_length;
+constexpr auto const idat_crc_offset = adler_offset + 4U;
+constexpr auto const iend_offset = idat_crc_offset + 4U;
+
+static_assert(iend_offset + 12U == asset_id::encoded_png_num_bytes);
+static_assert(scanline_length < 0x10000U, "A stored deflate block holds at most 65535 bytes.");
+
+constexpr void put_u32(encoded_png_t& buffer, std::size_t const offset, std::uint32_t const value)
+{
+    buffer[offset] = static_cast<std::uint8_t>(value >> 24U);
+    buffer[offset + 1U] = static_cast<std::uint8_t>(value >> 16U);
+    buffer[offset + 2U] = static_cast<std::uint8_t>(value >> 8U);
+    buffer[offset + 3U] = static_cast<std::uint8_t>(value);
+}
+
+constexpr void put_tag(encoded_png_t& buffer, std::size_t const offset, char const (&tag)[5])
+{
+    for (auto index = 0U; index < 4U; ++index)
+    {
+        buffer[offset + index] = static_cast<std::uint8_t>(tag[index]);
+    }
+}
+
+constexpr std::uint32_t chunk_crc(encoded_png_t const& buffer, std::size_t const chunk_offset)
+{
+    // The crc covers the chunk type and data, but not the length.
+    auto const data_length = (std::uint32_t{buffer[chunk_offset]} << 24U) |
+                             (std::uint32_t{buffer[chunk_offset + 1U]} << 16U) |
+                             (std::uint32_t{buffer[chunk_offset + 2U]} << 8U) |
+                             std::uint32_t{buffer[chunk_offset + 3U]};
+    return ~crc32_update_impl(0xFFFFFFFFU, buffer.data() + chunk_offset + 4U, 4U + data_length);
+}
+
+/**
+ * @brief Build every byte of the file that does not depend on the pixels.
+ */
+constexpr encoded_png_t make_template()
+{
+    encoded_png_t buffer{};
+
+    constexpr std::uint8_t const signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    for (auto index = 0U; index < sizeof(signature); ++index)
+    {
+        buffer[index] = signature[index];
+    }
+
+    put_u32(buffer, ihdr_offset, ihdr_data_length);
+    put_tag(buffer, ihdr_offset + 4U, "IHDR");
+    put_u32(buffer, ihdr_offset + 8U, asset_id::image_line_width_pixels);
+    put_u32(buffer, ihdr_offset + 12U, 1U); // height
+    buffer[ihdr_offset + 16U] = 1U;          // bit depth
+    buffer[ihdr_offset + 17U] = 0U;          // colour type: grayscale
+    buffer[ihdr_offset + 18U] = 0U;          // compression method: deflate
+    buffer[ihdr_offset + 19U] = 0U;          // filter method: adaptive
+    buffer[ihdr_offset + 20U] = 0U;          // interlace method: none
+    put_u32(buffer, ihdr_offset + 8U + ihdr_data_length, chunk_crc(buffer, ihdr_offset));
+
+    put_u32(buffer, idat_offset, idat_data_length);
+    put_tag(buffer, idat_offset + 4U, "IDAT");
+    buffer[idat_offset + 8U] = 0x78;  // zlib CMF: deflate, 32K window
+    buffer[idat_offset + 9U] = 0x01;  // zlib FLG: no dictionary, fastest; header is a multiple of 31
+    buffer[idat_offset + 10U] = 0x01; // BFINAL = 1, BTYPE = 00 (stored)
+    buffer[idat_offset + 11U] = static_cast<std::uint8_t>(scanline_length & 0xFFU);
+    buffer[idat_offset + 12U] = static_cast<std::uint8_t>(scanline_length >> 8U);
+    buffer[idat_offset + 13U] = static_cast<std::uint8_t>(~scanline_length & 0xFFU);
+    buffer[idat_offset + 14U] = static_cast<std::uint8_t>((~scanline_length >> 8U) & 0xFFU);
+    buffer[scanline_offset] = 0U; // filter type: none
+
+    put_u32(buffer, iend_offset, 0U);
+    put_tag(buffer, iend_offset + 4U, "IEND");
+    put_u32(buffer, iend_offset + 8U, chunk_crc(buffer, iend_offset));
+
+    return buffer;
+}
+
+constexpr auto const png_template = make_template();
+
+/**
+ * @brief The running crc of the IDAT chunk up to, but excluding, the scanline pixels; the
+ * per image crc only needs to be continued over the pixels and the Adler-32.
+ */
+constexpr auto const idat_prefix_crc = crc32_update_impl(
+    0xFFFFFFFFU, png_template.data() + idat_offset + 4U, scanline_offset + 1U - (idat_offset + 4U)
+);
+} // namespace
+
+namespace asset_id
+{
+std::uint32_t crc32_update(std::uint32_t const crc, std::uint8_t const* data, std::size_t length)
+{
+    return crc32_update_impl(crc, data, length);
+}
+
+std::uint32_t adler32(std::uint8_t const* data, std::size_t const length)
+{
+    constexpr auto const modulus = std::uint32_t{65521U};
+
+    // The largest block for which the sums cannot overflow before they are reduced.
+    constexpr auto const max_block = std::size_t{5552U};
+
+    auto low = std::uint32_t{1U};
+    auto high = std::uint32_t{0U};
+    for (auto start = std::size_t{0U}; start < length; start += max_block)
+    {
+        auto const end = (length - start > max_block) ? start + max_block : length;
+        for (auto index = start; index < end; ++index)
+        {
+            low += data[index];
+            high += low;
+        }
+        low %= modulus;
+        high %= modulus;
+    }
+
+    return (high << 16U) | low;
+}
+
+encoded_png_t encode_png(image_line_t const& pixels)
+{
+    auto result = png_template;
+
+    // A set bit in `pixels` is rendered black, so the grayscale values are inverted.
+    auto* const scanline_pixels = result.data() + scanline_offset + 1U;
+    for (auto index = std::size_t{0U}; index < pixels.size(); ++index)
+    {
+        scanline_pixels[index] = static_cast<std::uint8_t>(~pixels[index]);
+    }
+
+    put_u32(result, adler_offset, adler32(result.data() + scanline_offset, scanline_length));
+
+    auto const idat_crc =
+        crc32_update_impl(idat_prefix_crc, scanline_pixels, image_line_num_bytes + 4U);
+    put_u32(result, idat_crc_offset, ~idat_crc);
+
+    return result;
+}
+} // namespace asset_id
@@ -0,0 +1,63 @@
+/**
+ * @file   png_encoder.h
+ * @brief  A dedicated png encoder for the single line images produced by this tool.
+ *
+ * Every image written by this tool has the same geometry (256x1 pixels, 1 bit grayscale) so
+ * all of the png file, apart from the pixels and the two checksums that cover them, is known
+ * at compile time. This encoder builds the file directly into a fixed size buffer without
+ * using libpng or zlib; the pixels are held in a single `stored` (uncompressed) deflate block.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "image_line.h"
+
+namespace asset_id
+{
+/**
+ * @brief The size of every png file created by `encode_png`:
+ *        signature (8) + IHDR chunk (25) + IDAT chunk (56) + IEND chunk (12).
+ */
+constexpr auto const encoded_png_num_bytes = std::size_t{101U};
+
+/**
+ * @brief The `encoded_png_t` type holds the complete contents of a png file.
+ */
+using encoded_png_t = std::array<std::uint8_t, encoded_png_num_bytes>;
+
+/**
+ * @brief Update a running CRC-32 (as used by png chunks) with a block of bytes.
+ *
+ * @param crc     the running value; start from `0xFFFFFFFF` and invert the final value.
+ * @param data    the bytes to add.
+ * @param length  the number of bytes in `data`.
+ *
+ * @return std::uint32_t holding the updated running value.
+ */
+std::uint32_t crc32_update(std::uint32_t crc, std::uint8_t const* data, std::size_t length);
+
+/**
+ * @brief Calculate the Adler-32 checksum (as used by zlib streams) of a block of bytes.
+ *
+ * @param data    the bytes to checksum.
+ * @param length  the number of bytes in `data`.
+ *
+ * @return std::uint32_t holding the checksum.
+ */
+std::uint32_t adler32(std::uint8_t const* data, std::size_t length);
+
+/**
+ * @brief Encode an instance of `image_line_t` as a complete png file.
+ *
+ * The image is encoded as a 256x1, 1 bit grayscale png with the pixel values inverted, so a
+ * set bit in `pixels` is rendered black; this matches the files written through libpng.
+ *
+ * @param pixels  the line of pixels to encode.
+ *
+ * @return encoded_png_t holding the bytes of the png file.
+ */
+encoded_png_t encode_png(image_line_t const& pixels);
+} // namespace asset_id
@@ -0,0 +1,235 @@
+#include "render_batch.h"
+#include <cstdint>
+
+// SSE2 is part of the x86-64 baseline; AVX2 is enabled per function and checked at run time.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ASSET_ID_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define ASSET_ID_X86_KERNELS 0
+#endif
+
+namespace
+{
+using asset_id::checked_asset_id_t;
+using asset_id::image_line_t;
+
+static_assert(
+    sizeof(checked_asset_id_t) == asset_id::checked_asset_id_length,
+    "The batch kernels read the digits of each checked id as consecutive bytes."
+);
+static_assert(
+    asset_id::image_line_start_byte + asset_id::checked_asset_id_length <= 16U,
+    "The batch kernels render every digit into the first 16 bytes of a line."
+);
+
+/**
+ * @return std::uint8_t const* to the digit values of the checked id `index`.
+ */
+std::uint8_t const*
+digit_bytes(checked_asset_id_t const* const checked_ids, std::size_t const index)
+{
+    return reinterpret_cast<std::uint8_t const*>(checked_ids + index);
+}
+
+void render_scalar(
+    checked_asset_id_t const* const checked_ids,
+    std::size_t const num_ids,
+    image_line_t* const lines,
+    std::size_t const begin
+)
+{
+    for (auto index = begin; index < num_ids; ++index)
+    {
+        auto line = image_line_t{};
+        for (auto position = std::size_t{0U}; position < asset_id::checked_asset_id_length;
+             ++position)
+        {
+            line[asset_id::image_line_start_byte + position] =
+                asset_id::pixels_per_digit[checked_ids[index][position].value()];
+        }
+        lines[index] = line;
+    }
+}
+
+#if ASSET_ID_X86_KERNELS
+/**
+ * @return bool holding whether `lines` can be written with aligned stores.
+ */
+bool is_aligned(image_line_t const* const lines)
+{
+    return reinterpret_cast<std::uintptr_t>(lines) % asset_id::image_line_alignment == 0U;
+}
+
+/**
+ * @brief A mask holding 0xff in the bytes of a line that carry a digit, and 0 elsewhere.
+ */
+__m128i digit_byte_mask()
+{
+    alignas(16) std::uint8_t mask[16]{};
+    for (auto position = std::size_t{0U}; position < asset_id::checked_asset_id_length; ++position)
+    {
+        mask[asset_id::image_line_start_byte + position] = 0xffU;
+    }
+    return _mm_load_si128(reinterpret_cast<__m128i const*>(mask));
+}
+
+/**
+ * @brief SSE2 has no byte shuffle, so each line selects its bit-patterns by comparing every
+ * byte with each of the ten digits in turn.
+ */
+template<bool aligned>
+void render_sse2(
+    checked_asset_id_t const* const checked_ids,
+    std::size_t const num_ids,
+    image_line_t* const lines
+)
+{
+    auto const zero = _mm_setzero_si128();
+    auto const digit_mask = digit_byte_mask();
+    auto const not_digit_mask = _mm_andnot_si128(digit_mask, _mm_set1_epi8(-1));
+
+    __m128i patterns[asset_id::pixels_per_digit.size()];
+    for (auto value = std::size_t{0U}; value < asset_id::pixels_per_digit.size(); ++value)
+    {
+        patterns[value] = _mm_set1_epi8(static_cast<char>(asset_id::pixels_per_digit[value]));
+    }
+
+    // Each load reads eight bytes, so the last id is left to the scalar kernel.
+    auto index = std::size_t{0U};
+    for (; index + 1U < num_ids; ++index)
+    {
+        auto const digits = _mm_slli_si128(
+            _mm_loadl_epi64(reinterpret_cast<__m128i const*>(digit_bytes(checked_ids, index))),
+            asset_id::image_line_start_byte
+        );
+        // Bytes that carry no digit become 0xff, which matches no digit and so renders as 0.
+        auto const values = _mm_or_si128(_mm_and_si128(digits, digit_mask), not_digit_mask);
+
+        auto pixels = zero;
+        for (auto value = std::size_t{0U}; value < asset_id::pixels_per_digit.size(); ++value)
+        {
+            auto const matches =
+                _mm_cmpeq_epi8(values, _mm_set1_epi8(static_cast<char>(value)));
+            pixels = _mm_or_si128(pixels, _mm_and_si128(matches, patterns[value]));
+        }
+
+        auto* const line = reinterpret_cast<__m128i*>(lines + index);
+        if constexpr (aligned)
+        {
+            _mm_store_si128(line, pixels);
+            _mm_store_si128(line + 1, zero);
+        }
+        else
+        {
+            _mm_storeu_si128(line, pixels);
+            _mm_storeu_si128(line + 1, zero);
+        }
+    }
+
+    render_scalar(checked_ids, num_ids, lines, index);
+}
+
+template<bool aligned>
+__attribute__((target("avx2"))) void store_line_avx2(image_line_t* const line, __m256i const pixels)
+{
+    if constexpr (aligned)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(line), pixels);
+    }
+    else
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(line), pixels);
+    }
+}
+
+/**
+ * @brief Render two ids per iteration: the low 128-bit lane of each register works on the
+ * first id and the high lane on the second.
+ */
+template<bool aligned>
+__attribute__((target("avx2"))) void render_avx2(
+    checked_asset_id_t const* const checked_ids,
+    std::size_t const num_ids,
+    image_line_t* const lines
+)
+{
+    constexpr auto const start = asset_id::image_line_start_byte;
+    constexpr auto const length = asset_id::checked_asset_id_length;
+
+    // Moves the digits of the first id (bytes 0 to 5) and of the second (bytes 6 to 11) to
+    // their bytes of the line in each lane, and sets the byte of every other position to 0x80,
+    // which a shuffle renders as 0.
+    alignas(32) std::uint8_t placement[32];
+    alignas(16) std::uint8_t table[16]{};
+    for (auto position = std::size_t{0U}; position < 16U; ++position)
+    {
+        auto const is_digit = (position >= start) && (position < start + length);
+        placement[position] = is_digit ? static_cast<std::uint8_t>(position - start) : 0x80U;
+        placement[16U + position] =
+            is_digit ? static_cast<std::uint8_t>(length + position - start) : 0x80U;
+    }
+    for (auto value = std::size_t{0U}; value < asset_id::pixels_per_digit.size(); ++value)
+    {
+        table[value] = asset_id::pixels_per_digit[value];
+    }
+
+    auto const placement_shuffle = _mm256_load_si256(reinterpret_cast<__m256i const*>(placement));
+    auto const not_digit_mask = _mm256_cmpeq_epi8(
+        _mm256_and_si256(placement_shuffle, _mm256_set1_epi8(static_cast<char>(0x80))),
+        _mm256_set1_epi8(static_cast<char>(0x80))
+    );
+    auto const pixel_table =
+        _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(table)));
+
+    // Each load reads sixteen bytes, into the digits of a third id, so the last two ids are
+    // left to the scalar kernel.
+    auto index = std::size_t{0U};
+    for (; index + 2U < num_ids; index += 2U)
+    {
+        auto const digits = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(digit_bytes(checked_ids, index)))
+        );
+        auto const values =
+            _mm256_or_si256(_mm256_shuffle_epi8(digits, placement_shuffle), not_digit_mask);
+        auto const pixels = _mm256_shuffle_epi8(pixel_table, values);
+
+        // Each line is one lane of pixels followed by sixteen bytes of 0.
+        store_line_avx2<aligned>(lines + index, _mm256_permute2x128_si256(pixels, pixels, 0x80));
+        store_line_avx2<aligned>(
+            lines + index + 1U, _mm256_permute2x128_si256(pixels, pixels, 0x81)
+        );
+    }
+
+    render_scalar(checked_ids, num_ids, lines, index);
+}
+#endif
+} // namespace
+
+namespace asset_id
+{
+void render_image_lines(
+    checked_asset_id_t const* const checked_ids,
+    std::size_t const num_ids,
+    image_line_t* const lines,
+    simd_level const level
+)
+{
+    switch (level)
+    {
+#if ASSET_ID_X86_KERNELS
+        case simd_level::avx2:
+            is_aligned(lines) ? render_avx2<true>(checked_ids, num_ids, lines)
+                              : render_avx2<false>(checked_ids, num_ids, lines);
+            return;
+        case simd_level::sse2:
+            is_aligned(lines) ? render_sse2<true>(checked_ids, num_ids, lines)
+                              : render_sse2<false>(checked_ids, num_ids, lines);
+            return;
+#endif
+        default:
+            render_scalar(checked_ids, num_ids, lines, 0U);
+            return;
+    }
+}
+} // namespace asset_id
@@ -0,0 +1,48 @@
+/**
+ * @file   render_batch.h
+ * @brief  Renders the image lines of a large block of checked ids at once, with SIMD where
+ *         available.
+ *
+ * Every digit of a `checked_asset_id_t` is already known to be valid, so the bit-patterns of a
+ * whole id can be looked up in one go: the AVX2 kernel places the digits of two ids at their
+ * bytes of the line and maps them through `pixels_per_digit` with a single byte shuffle
+ * (`vpshufb`), then writes each 32-byte line with one store. Every kernel gives exactly the
+ * result of `create_image_line` with a start of `image_line_start_byte`.
+ *
+ * The tool renders each id only once, when the table of `id_table.h` is built at start-up (all
+ * 10000 ids take about 12 microseconds); every id is then rendered by a lookup. These kernels
+ * only shorten that one-off build and do not affect the throughput of a run.
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "asset_id.h"
+#include "checksum_batch.h"
+#include "image_line.h"
+
+namespace asset_id
+{
+/**
+ * @brief The alignment of the output of `render_image_lines` at which every line is written
+ * with aligned stores.
+ */
+constexpr auto const image_line_alignment = std::size_t{32U};
+
+/**
+ * @brief Render the image line of every checked id in a block, as `create_image_line` does
+ * with a start of `image_line_start_byte`.
+ *
+ * @param checked_ids  the checked ids to render.
+ * @param num_ids      the number of entries in `checked_ids`.
+ * @param lines        receives the image line of every id; must hold at least `num_ids` entries
+ *                     and is best aligned to `image_line_alignment`.
+ * @param level        the kernel to use; it must be supported.
+ */
+void render_image_lines(
+    checked_asset_id_t const* checked_ids,
+    std::size_t num_ids,
+    image_line_t* lines,
+    simd_level level = best_simd_level()
+);
+} // namespace asset_id
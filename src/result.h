@@ -0,0 +1,209 @@
+/**
+ * @file   result.h
+ * @brief  The error codes of the tool and a small `expected`-style type that carries either a
+ *         value or one of them.
+ *
+ * Every stage of the pipeline returns a `result`, so a caller can tell why an id failed without
+ * any text being formatted; the text for an error code is only produced on demand by
+ * `to_string`.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace asset_id
+{
+/**
+ * @brief Why a stage of the pipeline failed.
+ */
+enum class error_code : std::uint8_t
+{
+    /**
+     * @brief An id string does not have exactly `asset_id_length` characters.
+     */
+    bad_length,
+
+    /**
+     * @brief An id string holds a character that is not a decimal digit, or a value is not a
+     * single digit.
+     */
+    bad_digit,
+
+    /**
+     * @brief A checksum does not fit in `checksum_length` digits.
+     */
+    checksum_overflow,
+
+    /**
+     * @brief The digits cannot be rendered into an image line.
+     */
+    render_failed,
+
+    /**
+     * @brief The png encoder failed.
+     */
+    encode_failed,
+
+    /**
+     * @brief An output file or archive could not be opened, written or closed.
+     */
+    io_error,
+
+    /**
+     * @brief The output path does not name a png file.
+     */
+    bad_destination,
+
+    /**
+     * @brief The requested png backend is not part of this build.
+     */
+    backend_unavailable,
+
+    /**
+     * @brief A file name cannot be stored in a tar archive header.
+     */
+    name_too_long,
+
+    /**
+     * @brief A file is not a well formed 256x1 pixel, 1 bit grayscale png file.
+     */
+    corrupt_png,
+
+    /**
+     * @brief A byte of an image line is neither blank nor the segments of a digit where one is
+     * expected.
+     */
+    unknown_segment,
+
+    /**
+     * @brief The checksum drawn in an image does not match the id drawn next to it.
+     */
+    checksum_mismatch,
+
+    /**
+     * @brief The id drawn in an image is not the id its file is named after.
+     */
+    id_mismatch,
+};
+
+/**
+ * @brief The number of values of `error_code`; the values are contiguous from 0, so an array of
+ * this size can be indexed by error code.
+ */
+constexpr auto const num_error_codes = static_cast<std::size_t>(error_code::id_mismatch) + 1U;
+
+/**
+ * @return std::string_view holding the name of `error`, as it is spelt in the source.
+ */
+constexpr std::string_view to_string(error_code const error)
+{
+    switch (error)
+    {
+        case error_code::bad_length:
+            return "bad_length";
+        case error_code::bad_digit:
+            return "bad_digit";
+        case error_code::checksum_overflow:
+            return "checksum_overflow";
+        case error_code::render_failed:
+            return "render_failed";
+        case error_code::encode_failed:
+            return "encode_failed";
+        case error_code::io_error:
+            return "io_error";
+        case error_code::bad_destination:
+            return "bad_destination";
+        case error_code::backend_unavailable:
+            return "backend_unavailable";
+        case error_code::name_too_long:
+            return "name_too_long";
+        case error_code::corrupt_png:
+            return "corrupt_png";
+        case error_code::unknown_segment:
+            return "unknown_segment";
+        case error_code::checksum_mismatch:
+            return "checksum_mismatch";
+        case error_code::id_mismatch:
+            return "id_mismatch";
+    }
+
+    return "unknown";
+}
+
+/**
+ * @brief The `result` type holds either a value of type `T` or the `error_code` explaining why
+ * there is none.
+ *
+ * Its interface follows `std::optional` (a contextual conversion to bool, `*` and `->`) with
+ * `error()` added, and it is usable in constant expressions. `T` must be default constructible.
+ */
+template<typename T>
+class result
+{
+public:
+    constexpr result(T const& value):
+        _value(value),
+        _has_value(true)
+    {
+    }
+
+    constexpr result(error_code const error):
+        _error(error)
+    {
+    }
+
+    constexpr bool has_value() const { return _has_value; }
+
+    constexpr explicit operator bool() const { return _has_value; }
+
+    /**
+     * @brief Access the value; only valid when `has_value()`.
+     */
+    constexpr T const& operator*() const { return _value; }
+    constexpr T& operator*() { return _value; }
+    constexpr T const* operator->() const { return &_value; }
+
+    /**
+     * @brief The reason there is no value; only valid when `!has_value()`.
+     */
+    constexpr error_code error() const { return _error; }
+
+private:
+    T _value{};
+    error_code _error = error_code::bad_length;
+    bool _has_value = false;
+};
+
+/**
+ * @brief The outcome of a stage that produces no value: success, or an `error_code`.
+ */
+template<>
+class result<void>
+{
+public:
+    constexpr result():
+        _has_value(true)
+    {
+    }
+
+    constexpr result(error_code const error):
+        _error(error)
+    {
+    }
+
+    constexpr bool has_value() const { return _has_value; }
+
+    constexpr explicit operator bool() const { return _has_value; }
+
+    /**
+     * @brief The reason for the failure; only valid when `!has_value()`.
+     */
+    constexpr error_code error() const { return _error; }
+
+private:
+    error_code _error = error_code::bad_length;
+    bool _has_value = false;
+};
+} // namespace asset_id
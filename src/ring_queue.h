@@ -0,0 +1,252 @@
+/**
+ * @file   ring_queue.h
+ * @brief  A bounded single-producer, multi-consumer queue that joins the stages of the batch
+ *         pipeline.
+ *
+ * The queue is a ring of slots, each carrying a sequence number that tells the producer and the
+ * consumers whose turn it is (Vyukov's bounded queue), so neither side takes a lock to push or
+ * pop. A full queue holds the producer back until a consumer catches up, which bounds both the
+ * memory in flight and how far a fast stage can run ahead of a slow one; a side that has to
+ * wait yields for a while and then sleeps until the other side wakes it.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace asset_id
+{
+/**
+ * @brief Where threads wait for a change made by another thread: a few yields, then asleep
+ * until woken, so a stage that is waiting on a slower one neither takes its processor away nor
+ * keeps polling.
+ *
+ * The thread making a change calls `notify_all` after it; this only takes the lock when some
+ * thread is asleep, so a stage that keeps up with the others never does.
+ */
+class wait_point
+{
+public:
+    /**
+     * @brief Return once `ready()` holds; it is called again on every wake up, including
+     * spurious ones, and must only depend on state whose changes are followed by `notify_all`.
+     * It is called under a lock, so it must not notify a wait point itself.
+     */
+    template<typename Predicate>
+    void wait_until(Predicate ready)
+    {
+        for (auto num_yields = 0U; num_yields < max_yields; ++num_yields)
+        {
+            if (ready())
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        // Either the waker sees this thread counted and wakes it, or the change it made before
+        // looking is seen by `ready` under the lock.
+        _num_sleeping.fetch_add(1U, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            auto lock = std::unique_lock<std::mutex>{_mutex};
+            _wake_up.wait(lock, ready);
+        }
+        _num_sleeping.fetch_sub(1U, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Wake every thread asleep in `wait_until`.
+     */
+    void notify_all()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_num_sleeping.load(std::memory_order_relaxed) == 0U)
+        {
+            return;
+        }
+
+        // A sleeper checks `ready` and goes to sleep under the lock, so once the lock has been
+        // taken it is either asleep or sees the change.
+        {
+            auto const lock = std::lock_guard<std::mutex>{_mutex};
+        }
+        _wake_up.notify_all();
+    }
+
+private:
+    static constexpr auto const max_yields = 64U;
+
+    std::atomic<unsigned> _num_sleeping{0U};
+    std::mutex _mutex;
+    std::condition_variable _wake_up;
+};
+
+/**
+ * @brief A bounded queue with a single producer and any number of consumers.
+ *
+ * @tparam T         the type of the values queued; copied in and out of the ring.
+ * @tparam Capacity  the number of values the queue holds at most.
+ */
+template<typename T, std::size_t Capacity>
+class spmc_ring
+{
+public:
+    static_assert(Capacity >= 2U, "A ring needs at least two slots.");
+
+    static constexpr auto const capacity = Capacity;
+
+    spmc_ring()
+    {
+        for (auto index = std::size_t{0U}; index < capacity; ++index)
+        {
+            _slots[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    spmc_ring(spmc_ring const&) = delete;
+    spmc_ring& operator=(spmc_ring const&) = delete;
+
+    /**
+     * @brief Append a value; only ever called by the producer.
+     *
+     * @return false  if the queue is full.
+     */
+    bool try_push(T const& value)
+    {
+        if (!has_room())
+        {
+            return false;
+        }
+
+        auto& slot = _slots[_tail % capacity];
+        slot.value = value;
+        slot.sequence.store(_tail + 1U, std::memory_order_release);
+        ++_tail;
+        _pushed.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Append a value, waiting for a consumer to make room if the queue is full.
+     */
+    void push(T const& value)
+    {
+        while (!try_push(value))
+        {
+            _popped.wait_until([this]() { return has_room(); });
+        }
+    }
+
+    /**
+     * @brief Take the oldest value; may be called by any number of consumers at once.
+     *
+     * @return false  if the queue is empty.
+     */
+    bool try_pop(T& value)
+    {
+        auto position = _head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto& slot = _slots[position % capacity];
+            auto const sequence = slot.sequence.load(std::memory_order_acquire);
+            auto const lag = static_cast<std::ptrdiff_t>(sequence - (position + 1U));
+            if (lag == 0)
+            {
+                if (_head.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed))
+                {
+                    value = slot.value;
+                    slot.sequence.store(position + capacity, std::memory_order_release);
+                    _popped.notify_all();
+                    return true;
+                }
+            }
+            else if (lag < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Take the oldest value, waiting for the producer if the queue is empty.
+     *
+     * @return false  once the queue is closed and every value has been taken.
+     */
+    bool pop(T& value)
+    {
+        while (!try_pop(value))
+        {
+            // A value pushed before `close` is visible once `closed` is, so one more attempt
+            // settles whether the queue is drained.
+            if (_closed.load(std::memory_order_acquire))
+            {
+                return try_pop(value);
+            }
+            _pushed.wait_until(
+                [this]() { return has_value() || _closed.load(std::memory_order_acquire); }
+            );
+        }
+        return true;
+    }
+
+    /**
+     * @brief Tell the consumers that no more values will be pushed; only ever called by the
+     * producer.
+     */
+    void close()
+    {
+        _closed.store(true, std::memory_order_release);
+        _pushed.notify_all();
+    }
+
+private:
+    /**
+     * @return true  if the slot at the tail is free for the producer.
+     */
+    bool has_room() const
+    {
+        return _slots[_tail % capacity].sequence.load(std::memory_order_acquire) == _tail;
+    }
+
+    /**
+     * @return true  unless the slot at the head is still waiting for a value; it may already
+     *               have been taken by another consumer.
+     */
+    bool has_value() const
+    {
+        auto const position = _head.load(std::memory_order_relaxed);
+        auto const sequence = _slots[position % capacity].sequence.load(std::memory_order_acquire);
+        return static_cast<std::ptrdiff_t>(sequence - (position + 1U)) >= 0;
+    }
+
+    struct slot_t
+    {
+        std::atomic<std::size_t> sequence{0U};
+        T value{};
+    };
+
+    std::array<slot_t, capacity> _slots;
+    alignas(64) std::size_t _tail = 0U;
+    alignas(64) std::atomic<std::size_t> _head{0U};
+    std::atomic<bool> _closed{false};
+
+    /**
+     * @brief Notified of each value pushed and of `close`; consumers wait here.
+     */
+    wait_point _pushed;
+
+    /**
+     * @brief Notified of each value popped; the producer waits here.
+     */
+    wait_point _popped;
+};
+} // namespace asset_id
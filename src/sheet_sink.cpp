@@ -0,0 +1,473 @@
+#include "sheet_sink.h"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifndef ASSET_ID_WITH_ZLIB
+#define ASSET_ID_WITH_ZLIB 0
+#endif
+
+#if ASSET_ID_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "atomic_write.h"
+#include "logger.h"
+#include "png_encoder.h"
+#include "stats.h"
+
+namespace
+{
+/**
+ * @return std::string holding the name, without extension, of sheet `number`.
+ */
+std::string sheet_stem(std::size_t const number)
+{
+    auto digits = std::to_string(number);
+    if (digits.size() < 5U)
+    {
+        digits.insert(0U, 5U - digits.size(), '0');
+    }
+    return "sheet_" + digits;
+}
+
+#if ASSET_ID_WITH_ZLIB
+constexpr std::uint8_t const png_signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+/**
+ * @brief The IHDR chunk follows the signature, and its height field is only known once the
+ * sheet is complete.
+ */
+constexpr auto const ihdr_offset = sizeof(png_signature);
+constexpr auto const ihdr_data_length = std::size_t{13U};
+constexpr auto const ihdr_chunk_length = 12U + ihdr_data_length;
+
+/**
+ * @brief The most compressed bytes held in a single IDAT chunk.
+ */
+constexpr auto const idat_capacity = std::size_t{64U * 1024U};
+
+/**
+ * @brief The filter types, from the png specification, that start every scanline.
+ */
+constexpr auto const filter_none = std::uint8_t{0U};
+constexpr auto const filter_up = std::uint8_t{2U};
+
+void put_u32(std::uint8_t* const buffer, std::uint32_t const value)
+{
+    buffer[0] = static_cast<std::uint8_t>(value >> 24U);
+    buffer[1] = static_cast<std::uint8_t>(value >> 16U);
+    buffer[2] = static_cast<std::uint8_t>(value >> 8U);
+    buffer[3] = static_cast<std::uint8_t>(value);
+}
+
+/**
+ * @brief Fill in the length, tag and crc of a chunk whose `length` bytes of data start 8 bytes
+ * into `chunk`; `chunk` must have room for the 4 byte crc after the data.
+ */
+void seal_chunk(std::uint8_t* const chunk, char const (&tag)[5], std::size_t const length)
+{
+    put_u32(chunk, static_cast<std::uint32_t>(length));
+    std::memcpy(chunk + 4U, tag, 4U);
+    auto const crc = asset_id::crc32_update(0xFFFFFFFFU, chunk + 4U, 4U + length);
+    put_u32(chunk + 8U + length, ~crc);
+}
+
+std::array<std::uint8_t, ihdr_chunk_length> make_ihdr(std::uint32_t const height)
+{
+    std::array<std::uint8_t, ihdr_chunk_length> chunk{};
+    auto* const data = chunk.data() + 8U;
+    put_u32(data, asset_id::image_line_width_pixels);
+    put_u32(data + 4U, height);
+    data[8] = 1U;  // bit depth
+    data[9] = 0U;  // colour type: grayscale
+    data[10] = 0U; // compression method: deflate
+    data[11] = 0U; // filter method: adaptive
+    data[12] = 0U; // interlace method: none
+    seal_chunk(chunk.data(), "IHDR", ihdr_data_length);
+    return chunk;
+}
+#endif
+} // namespace
+
+namespace asset_id
+{
+#if ASSET_ID_WITH_ZLIB
+/**
+ * @brief Streams the rows of a single sheet, and its index, to disk.
+ */
+class sheet_writer
+{
+public:
+    /**
+     * @return std::unique_ptr<sheet_writer> holding a writer for a new sheet, `<stem>.png`
+     *         and `<stem>.index` in the directory `dir_fd`; null if the sheet cannot be
+     *         created.
+     */
+    static std::unique_ptr<sheet_writer> open(int const dir_fd, std::string const& stem)
+    {
+        auto file = staged_file::create(dir_fd, stem + ".png");
+        if (!file)
+        {
+            return nullptr;
+        }
+
+        auto sheet = std::unique_ptr<sheet_writer>{new sheet_writer{dir_fd, stem, std::move(file)}};
+        if (deflateInit(&sheet->_stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+        {
+            return nullptr;
+        }
+        sheet->_stream_open = true;
+
+        // The height is filled in by `finish`.
+        auto const ihdr = make_ihdr(0U);
+        if (!sheet->write_all(png_signature, sizeof(png_signature)) ||
+            !sheet->write_all(ihdr.data(), ihdr.size()))
+        {
+            return nullptr;
+        }
+
+        sheet->start_chunk();
+        return sheet;
+    }
+
+    sheet_writer(sheet_writer const&) = delete;
+    sheet_writer& operator=(sheet_writer const&) = delete;
+
+    ~sheet_writer()
+    {
+        if (_stream_open)
+        {
+            deflateEnd(&_stream);
+        }
+    }
+
+    std::size_t num_rows() const { return _num_rows; }
+
+    /**
+     * @brief Append the pixels of `item` as the next row, and its file stem to the index.
+     */
+    bool append(output_item const& item)
+    {
+        auto const timer = stage_timer{stats_stage::encode};
+
+        // A set bit is rendered black, so the grayscale values are inverted as in `encode_png`.
+        // The first row has no row above it, which the `Up` filter treats as zero anyway.
+        auto const& pixels = item.rendered->pixels;
+        std::array<std::uint8_t, 1U + image_line_num_bytes> scanline{};
+        scanline[0] = (_num_rows == 0U) ? filter_none : filter_up;
+        for (auto index = std::size_t{0U}; index < pixels.size(); ++index)
+        {
+            auto const value = static_cast<std::uint8_t>(~pixels[index]);
+            scanline[1U + index] = static_cast<std::uint8_t>(value - _previous[index]);
+            _previous[index] = value;
+        }
+
+        _index += std::to_string(_num_rows);
+        _index += '\t';
+        _index += item.file_stem;
+        _index += '\n';
+        ++_num_rows;
+
+        _stream.next_in = scanline.data();
+        _stream.avail_in = static_cast<uInt>(scanline.size());
+        return run_deflate(Z_NO_FLUSH);
+    }
+
+    /**
+     * @brief Complete the deflate stream and the png file and fill in its height, then move
+     * the sheet, and its index, into place.
+     */
+    bool finish()
+    {
+        if (!run_deflate(Z_FINISH) || !flush_chunk())
+        {
+            return false;
+        }
+
+        std::array<std::uint8_t, 12U> iend{};
+        seal_chunk(iend.data(), "IEND", 0U);
+        if (!write_all(iend.data(), iend.size()))
+        {
+            return false;
+        }
+
+        auto const ihdr = make_ihdr(static_cast<std::uint32_t>(_num_rows));
+        if (::pwrite(_file->fd(), ihdr.data(), ihdr.size(), ihdr_offset) !=
+            static_cast<ssize_t>(ihdr.size()))
+        {
+            log_message(log_level::error, "Failed to write a sheet: ", std::strerror(errno));
+            return false;
+        }
+        add_count(stats_counter::syscalls, 1U);
+
+        // Until both are in place, the sheet and its index are only ever seen complete.
+        auto const index_name = _stem + ".index";
+        if (!_file->commit() ||
+            !write_file_atomically(
+                _dir_fd,
+                index_name.c_str(),
+                reinterpret_cast<std::uint8_t const*>(_index.data()),
+                _index.size()
+            ))
+        {
+            log_message(log_level::error, "Failed to move the sheet ", _stem, " into place.");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    sheet_writer(int const dir_fd, std::string stem, std::unique_ptr<staged_file> file):
+        _dir_fd(dir_fd),
+        _stem(std::move(stem)),
+        _file(std::move(file))
+    {
+        _chunk.resize(8U + idat_capacity + 4U);
+    }
+
+    /**
+     * @brief Point the output of the deflate stream at the data of an empty IDAT chunk.
+     */
+    void start_chunk()
+    {
+        _stream.next_out = _chunk.data() + 8U;
+        _stream.avail_out = static_cast<uInt>(idat_capacity);
+    }
+
+    /**
+     * @brief Write the IDAT chunk holding the output of the deflate stream so far, if any.
+     */
+    bool flush_chunk()
+    {
+        auto const length = idat_capacity - _stream.avail_out;
+        if (length == 0U)
+        {
+            return true;
+        }
+
+        seal_chunk(_chunk.data(), "IDAT", length);
+        auto const written = write_all(_chunk.data(), 8U + length + 4U);
+        start_chunk();
+        return written;
+    }
+
+    /**
+     * @brief Compress all of the pending input, writing an IDAT chunk whenever one fills up.
+     */
+    bool run_deflate(int const flush)
+    {
+        while (true)
+        {
+            auto const status = deflate(&_stream, flush);
+            if ((status != Z_OK) && (status != Z_STREAM_END) && (status != Z_BUF_ERROR))
+            {
+                log_message(log_level::error, "Failed to compress a sheet.");
+                return false;
+            }
+
+            if (_stream.avail_out == 0U)
+            {
+                if (!flush_chunk())
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            // With room left for output, deflate only stops once it has used all of the input,
+            // or, when finishing, once the stream is complete.
+            if ((flush != Z_FINISH) || (status == Z_STREAM_END))
+            {
+                return true;
+            }
+        }
+    }
+
+    bool write_all(void const* const data, std::size_t const size)
+    {
+        auto const timer = stage_timer{stats_stage::write};
+
+        auto const* bytes = static_cast<std::uint8_t const*>(data);
+        auto remaining = size;
+        while (remaining > 0U)
+        {
+            auto const written = ::write(_file->fd(), bytes, remaining);
+            add_count(stats_counter::syscalls, 1U);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                log_message(log_level::error, "Failed to write a sheet: ", std::strerror(errno));
+                return false;
+            }
+
+            bytes += written;
+            remaining -= static_cast<std::size_t>(written);
+            add_count(stats_counter::bytes_written, static_cast<std::uint64_t>(written));
+        }
+
+        return true;
+    }
+
+    int _dir_fd;
+    std::string _stem;
+
+    /**
+     * @brief The png file, written out of sight until it is complete.
+     */
+    std::unique_ptr<staged_file> _file;
+    z_stream _stream{};
+    bool _stream_open = false;
+
+    /**
+     * @brief The lines of the index, written once the sheet is in place.
+     */
+    std::string _index;
+    std::size_t _num_rows = 0U;
+
+    /**
+     * @brief The unfiltered pixels of the previous row, for the `Up` filter.
+     */
+    std::array<std::uint8_t, image_line_num_bytes> _previous{};
+
+    /**
+     * @brief The IDAT chunk being filled: length and tag, then up to `idat_capacity` bytes of
+     * the deflate stream, then room for the crc.
+     */
+    std::vector<std::uint8_t> _chunk;
+};
+#else
+class sheet_writer
+{
+public:
+    static std::unique_ptr<sheet_writer> open(int, std::string const&) { return nullptr; }
+
+    std::size_t num_rows() const { return 0U; }
+
+    bool append(output_item const&) { return false; }
+
+    bool finish() { return false; }
+};
+#endif
+
+bool sheets_available()
+{
+    return ASSET_ID_WITH_ZLIB != 0;
+}
+
+sheet_sink::sheet_sink(
+    std::filesystem::path output_dir,
+    unsigned const rows_per_sheet,
+    durability_settings const& durability
+):
+    _output_dir(std::move(output_dir)),
+    _rows_per_sheet(rows_per_sheet),
+    _sync(durability)
+{
+    _dir_fd = ::open(_output_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+sheet_sink::~sheet_sink()
+{
+    if (_dir_fd >= 0)
+    {
+        close(_dir_fd);
+    }
+}
+
+void sheet_sink::write(output_item* const items, std::size_t const num_items)
+{
+    for (auto index = std::size_t{0U}; index < num_items; ++index)
+    {
+        auto& item = items[index];
+        item.error = sheets_available() ? error_code::io_error : error_code::backend_unavailable;
+        if (_failed || !sheets_available())
+        {
+            continue;
+        }
+
+        if (!_sheet)
+        {
+            auto const stem = sheet_stem(_num_sheets);
+            _sheet = (_dir_fd >= 0) ? sheet_writer::open(_dir_fd, stem) : nullptr;
+            if (!_sheet)
+            {
+                log_message(
+                    log_level::error, "Cannot create the sheet ", (_output_dir / stem).string()
+                );
+                _failed = true;
+                continue;
+            }
+            ++_num_sheets;
+        }
+
+        // A row only counts as written once its sheet is in place.
+        auto const num_deferred = _sheet->num_rows();
+        item.deferred = _sheet->append(item);
+        if (!item.deferred)
+        {
+            _settled.push_back({num_deferred, false, error_code::io_error});
+            _sheet.reset();
+            _failed = true;
+            continue;
+        }
+
+        if ((_sheet->num_rows() == _rows_per_sheet) && !finish_sheet())
+        {
+            _failed = true;
+        }
+    }
+}
+
+void sheet_sink::take_settled(std::vector<deferred_outcome>& outcomes)
+{
+    outcomes.insert(outcomes.end(), _settled.begin(), _settled.end());
+    _settled.clear();
+}
+
+void sheet_sink::settle_all()
+{
+    if (!finish_sheet())
+    {
+        _failed = true;
+    }
+}
+
+bool sheet_sink::finish()
+{
+    settle_all();
+    return sheets_available() && !_failed && _sync.finish(_dir_fd);
+}
+
+bool sheet_sink::finish_sheet()
+{
+    if (!_sheet)
+    {
+        return true;
+    }
+
+    auto const num_rows = _sheet->num_rows();
+    auto completed = _sheet->finish();
+    _sheet.reset();
+    if (completed && _sync.per_file())
+    {
+        completed = sync_file_system(_dir_fd);
+    }
+    else if (completed && (_sync.mode() == durability_mode::batch))
+    {
+        _sync.files_written(_dir_fd, 1U);
+    }
+
+    _settled.push_back({num_rows, completed, error_code::io_error});
+    return completed;
+}
+} // namespace asset_id
@@ -0,0 +1,104 @@
+/**
+ * @file   sheet_sink.h
+ * @brief  An output sink that writes the ids as the rows of sprite sheets: 256xN pixel png
+ *         files holding up to N ids each.
+ *
+ * Sheet `k` is written to `sheet_<k>.png` in the output directory, with the ids in input order
+ * from the top row down, alongside `sheet_<k>.index` holding one `<row>\t<file stem>` line per
+ * row. Every row after the first uses the png `Up` filter and all of the rows of a sheet share
+ * a single deflate stream, so the bytes that do not change between ids compress to almost
+ * nothing. The sheets are streamed to disk as the ids arrive, so memory use does not depend on
+ * their size; the height in the header is filled in once a sheet is complete. Each sheet is
+ * written out of sight, as a `staged_file`, and only moved into place, followed by its index,
+ * once it is complete, so a reader, or a crash, never sees a partial sheet.
+ *
+ * The sheets are compressed with zlib and are only available when the tool is built with
+ * `ASSET_ID_WITH_ZLIB`. For durability each sheet counts as a single file: in `per_file` mode
+ * the file system holding the output is synced as each sheet is completed.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "output_sink.h"
+
+namespace asset_id
+{
+/**
+ * @return true   if sprite sheets can be written by this build of the tool.
+ * @return false  otherwise.
+ */
+bool sheets_available();
+
+class sheet_writer;
+
+class sheet_sink final : public output_sink
+{
+public:
+    /**
+     * @brief Create a sink that writes sheets of at most `rows_per_sheet` ids into
+     * `output_dir`; existing sheets are overwritten.
+     */
+    sheet_sink(
+        std::filesystem::path output_dir,
+        unsigned rows_per_sheet,
+        durability_settings const& durability = {}
+    );
+
+    ~sheet_sink() override;
+
+    /**
+     * @brief Append one row per item to the current sheet, starting a new sheet whenever the
+     * current one is full.
+     *
+     * Every row appended is deferred: it only counts as written once its sheet is complete and
+     * in place, and as failed, along with the rest of its sheet, otherwise.
+     */
+    void write(output_item* items, std::size_t num_items) override;
+
+    bool is_concurrent() const override { return false; }
+
+    void take_settled(std::vector<deferred_outcome>& outcomes) override;
+
+    /**
+     * @brief Complete the last sheet, settling its rows.
+     */
+    void settle_all() override;
+
+    /**
+     * @brief Complete the last sheet, then sync the output as its durability requires.
+     */
+    bool finish() override;
+
+private:
+    /**
+     * @brief Complete the current sheet, if there is one, count it towards the next sync and
+     * settle its rows.
+     */
+    bool finish_sheet();
+
+    std::filesystem::path _output_dir;
+    unsigned _rows_per_sheet;
+    sync_schedule _sync;
+
+    /**
+     * @brief The output directory, which the sheets are moved into once complete.
+     */
+    int _dir_fd = -1;
+    std::size_t _num_sheets = 0U;
+    bool _failed = false;
+
+    /**
+     * @brief The outcome of the sheets settled since the last call to `take_settled`.
+     */
+    std::vector<deferred_outcome> _settled;
+
+    /**
+     * @brief The sheet being written; null between sheets.
+     */
+    std::unique_ptr<sheet_writer> _sheet;
+};
+} // namespace asset_id
@@ -0,0 +1,214 @@
+#include "stats.h"
+#include <ostream>
+#include <string_view>
+
+namespace
+{
+struct atomic_stage_stats
+{
+    std::atomic<std::uint64_t> calls{0U};
+    std::atomic<std::uint64_t> items{0U};
+    std::atomic<std::uint64_t> total_ns{0U};
+    std::atomic<std::uint64_t> max_ns{0U};
+    std::array<std::atomic<std::uint64_t>, asset_id::num_latency_buckets> latency_buckets{};
+};
+
+// Both tables are constant initialised, so stages may be recorded during static initialisation.
+std::array<atomic_stage_stats, asset_id::num_stats_stages> stage_table{};
+std::array<std::atomic<std::uint64_t>, asset_id::num_stats_counters> counter_table{};
+
+std::size_t latency_bucket(std::uint64_t nanoseconds)
+{
+    auto bucket = std::size_t{0U};
+    while ((nanoseconds > 0U) && (bucket + 1U < asset_id::num_latency_buckets))
+    {
+        nanoseconds >>= 1U;
+        ++bucket;
+    }
+    return bucket;
+}
+
+constexpr std::uint64_t bucket_upper_bound(std::size_t const bucket)
+{
+    return std::uint64_t{1U} << bucket;
+}
+
+/**
+ * @return std::uint64_t holding the upper bound of the bucket holding the call at `fraction` of
+ *         the way through the calls, in order of latency.
+ */
+std::uint64_t percentile_ns(asset_id::stage_stats const& stage, double const fraction)
+{
+    auto const target = static_cast<std::uint64_t>(fraction * static_cast<double>(stage.calls));
+    auto seen = std::uint64_t{0U};
+    for (auto bucket = std::size_t{0U}; bucket < stage.latency_buckets.size(); ++bucket)
+    {
+        seen += stage.latency_buckets[bucket];
+        if (seen > target)
+        {
+            return bucket_upper_bound(bucket);
+        }
+    }
+    return stage.max_ns;
+}
+
+constexpr std::string_view to_string(asset_id::stats_stage const stage)
+{
+    switch (stage)
+    {
+        case asset_id::stats_stage::read:
+            return "read";
+        case asset_id::stats_stage::scan:
+            return "scan";
+        case asset_id::stats_stage::render:
+            return "render";
+        case asset_id::stats_stage::encode:
+            return "encode";
+        case asset_id::stats_stage::write:
+            return "write";
+        case asset_id::stats_stage::sync:
+            return "sync";
+        case asset_id::stats_stage::finish:
+            return "finish";
+    }
+
+    return "unknown";
+}
+} // namespace
+
+namespace asset_id
+{
+namespace detail
+{
+std::atomic<bool> stats_enabled{false};
+} // namespace detail
+
+void enable_stats(bool const enabled)
+{
+    detail::stats_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void record_stage(
+    stats_stage const stage,
+    std::uint64_t const nanoseconds,
+    std::uint64_t const items
+)
+{
+    auto& entry = stage_table[static_cast<std::size_t>(stage)];
+    entry.calls.fetch_add(1U, std::memory_order_relaxed);
+    entry.items.fetch_add(items, std::memory_order_relaxed);
+    entry.total_ns.fetch_add(nanoseconds, std::memory_order_relaxed);
+    entry.latency_buckets[latency_bucket(nanoseconds)].fetch_add(1U, std::memory_order_relaxed);
+
+    auto max_ns = entry.max_ns.load(std::memory_order_relaxed);
+    while ((nanoseconds > max_ns) &&
+           !entry.max_ns.compare_exchange_weak(max_ns, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+void add_count(stats_counter const counter, std::uint64_t const amount)
+{
+    if (!stats_enabled())
+    {
+        return;
+    }
+
+    counter_table[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+stats_snapshot snapshot_stats()
+{
+    auto snapshot = stats_snapshot{};
+    for (auto index = std::size_t{0U}; index < num_stats_stages; ++index)
+    {
+        auto const& entry = stage_table[index];
+        auto& stage = snapshot.stages[index];
+        stage.calls = entry.calls.load(std::memory_order_relaxed);
+        stage.items = entry.items.load(std::memory_order_relaxed);
+        stage.total_ns = entry.total_ns.load(std::memory_order_relaxed);
+        stage.max_ns = entry.max_ns.load(std::memory_order_relaxed);
+        for (auto bucket = std::size_t{0U}; bucket < num_latency_buckets; ++bucket)
+        {
+            stage.latency_buckets[bucket] =
+                entry.latency_buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    for (auto index = std::size_t{0U}; index < num_stats_counters; ++index)
+    {
+        snapshot.counters[index] = counter_table[index].load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+void reset_stats()
+{
+    for (auto& entry: stage_table)
+    {
+        entry.calls = 0U;
+        entry.items = 0U;
+        entry.total_ns = 0U;
+        entry.max_ns = 0U;
+        for (auto& bucket: entry.latency_buckets)
+        {
+            bucket = 0U;
+        }
+    }
+
+    for (auto& counter: counter_table)
+    {
+        counter = 0U;
+    }
+}
+
+void write_stats_json(std::ostream& output, stats_snapshot const& stats, double const wall_seconds)
+{
+    auto const counter = [&stats](stats_counter const which)
+    { return stats.counters[static_cast<std::size_t>(which)]; };
+
+    auto const ids = counter(stats_counter::ids);
+    auto const ids_per_second =
+        (wall_seconds > 0.0) ? static_cast<double>(ids) / wall_seconds : 0.0;
+
+    output << "{\n";
+    output << "  \"wall_seconds\": " << wall_seconds << ",\n";
+    output << "  \"lines\": " << counter(stats_counter::lines) << ",\n";
+    output << "  \"ids\": " << ids << ",\n";
+    output << "  \"ids_per_second\": " << ids_per_second << ",\n";
+    output << "  \"bytes_written\": " << counter(stats_counter::bytes_written) << ",\n";
+    output << "  \"syscalls\": " << counter(stats_counter::syscalls) << ",\n";
+    output << "  \"stages\": {\n";
+
+    for (auto index = std::size_t{0U}; index < num_stats_stages; ++index)
+    {
+        auto const& stage = stats.stages[index];
+        auto const mean_ns = (stage.calls > 0U) ? stage.total_ns / stage.calls : 0U;
+
+        output << "    \"" << to_string(static_cast<stats_stage>(index)) << "\": {"
+               << "\"calls\": " << stage.calls << ", \"items\": " << stage.items
+               << ", \"total_ns\": " << stage.total_ns << ", \"mean_ns\": " << mean_ns
+               << ", \"p50_ns\": " << ((stage.calls > 0U) ? percentile_ns(stage, 0.5) : 0U)
+               << ", \"p99_ns\": " << ((stage.calls > 0U) ? percentile_ns(stage, 0.99) : 0U)
+               << ", \"max_ns\": " << stage.max_ns << ", \"histogram\": [";
+
+        auto first = true;
+        for (auto bucket = std::size_t{0U}; bucket < num_latency_buckets; ++bucket)
+        {
+            if (stage.latency_buckets[bucket] == 0U)
+            {
+                continue;
+            }
+            output << (first ? "" : ", ") << "{\"lt_ns\": " << bucket_upper_bound(bucket)
+                   << ", \"count\": " << stage.latency_buckets[bucket] << "}";
+            first = false;
+        }
+
+        output << "]}" << ((index + 1U < num_stats_stages) ? ",\n" : "\n");
+    }
+
+    output << "  }\n";
+    output << "}\n";
+}
+} // namespace asset_id
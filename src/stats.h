@@ -0,0 +1,222 @@
+/**
+ * @file   stats.h
+ * @brief  Low overhead timings and counters for each stage of the pipeline, reported as JSON by
+ *         `--stats`.
+ *
+ * Every stage keeps its number of calls, total and maximum time and a histogram of call
+ * latencies in power of two buckets, all in relaxed atomics shared by every thread. Stats are
+ * off by default: a `stage_timer` or `add_count` then costs a single relaxed atomic load and
+ * never reads the clock.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace asset_id
+{
+/**
+ * @brief The stages of the pipeline that are timed.
+ */
+enum class stats_stage : std::uint8_t
+{
+    /**
+     * @brief Opening and mapping the input file.
+     */
+    read,
+
+    /**
+     * @brief Splitting the input into lines, validating the ids and skipping duplicates; timed
+     * per chunk of lines.
+     */
+    scan,
+
+    /**
+     * @brief Calculating the checksum and pixels of every id, once, into the table of rendered
+     * ids.
+     */
+    render,
+
+    /**
+     * @brief Encoding a line of pixels as a png file in memory.
+     */
+    encode,
+
+    /**
+     * @brief Writing encoded png files to their destination.
+     */
+    write,
+
+    /**
+     * @brief Flushing written files to disk with `fsync` or `syncfs`; recorded on every call,
+     * whether or not stats are enabled, for the summary of a durable run.
+     */
+    sync,
+
+    /**
+     * @brief Completing the output once every file has been written.
+     */
+    finish,
+};
+
+constexpr auto const num_stats_stages = static_cast<std::size_t>(stats_stage::finish) + 1U;
+
+/**
+ * @brief The counters kept alongside the stage timings.
+ */
+enum class stats_counter : std::uint8_t
+{
+    /**
+     * @brief Input lines read.
+     */
+    lines,
+
+    /**
+     * @brief Well formed ids handed to the output.
+     */
+    ids,
+
+    /**
+     * @brief Bytes written to output files or archives.
+     */
+    bytes_written,
+
+    /**
+     * @brief System calls made to write the output.
+     */
+    syscalls,
+};
+
+constexpr auto const num_stats_counters = static_cast<std::size_t>(stats_counter::syscalls) + 1U;
+
+/**
+ * @brief The number of latency buckets; bucket `i` counts calls that took less than `2^i`
+ * nanoseconds (and at least `2^(i-1)`), and the last bucket also counts anything slower.
+ */
+constexpr auto const num_latency_buckets = std::size_t{40U};
+
+namespace detail
+{
+extern std::atomic<bool> stats_enabled;
+} // namespace detail
+
+/**
+ * @brief Turn the timing of stages and the counters on or off.
+ */
+void enable_stats(bool enabled);
+
+/**
+ * @return true   if stages are being timed and counted.
+ * @return false  otherwise.
+ */
+inline bool stats_enabled()
+{
+    return detail::stats_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Record one call of a stage that took `nanoseconds` and processed `items` items, whether
+ * or not stats are enabled; normally called through `stage_timer`.
+ */
+void record_stage(stats_stage stage, std::uint64_t nanoseconds, std::uint64_t items = 1U);
+
+/**
+ * @brief Add `amount` to a counter when stats are enabled.
+ */
+void add_count(stats_counter counter, std::uint64_t amount);
+
+/**
+ * @brief Times a stage from construction to destruction when stats are enabled, and does
+ * nothing otherwise.
+ */
+class stage_timer
+{
+public:
+    explicit stage_timer(stats_stage const stage, std::uint64_t const items = 1U):
+        _stage(stage),
+        _items(items),
+        _enabled(stats_enabled())
+    {
+        if (_enabled)
+        {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    stage_timer(stage_timer const&) = delete;
+    stage_timer& operator=(stage_timer const&) = delete;
+
+    ~stage_timer()
+    {
+        if (_enabled)
+        {
+            auto const elapsed = std::chrono::steady_clock::now() - _start;
+            record_stage(
+                _stage,
+                static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+                ),
+                _items
+            );
+        }
+    }
+
+    /**
+     * @brief Change the number of items attributed to the call, once it is known.
+     */
+    void set_items(std::uint64_t const items) { _items = items; }
+
+private:
+    stats_stage _stage;
+    std::uint64_t _items;
+    bool _enabled;
+    std::chrono::steady_clock::time_point _start{};
+};
+
+/**
+ * @brief A copy of the timings of one stage.
+ */
+struct stage_stats
+{
+    std::uint64_t calls = 0U;
+    std::uint64_t items = 0U;
+    std::uint64_t total_ns = 0U;
+    std::uint64_t max_ns = 0U;
+    std::array<std::uint64_t, num_latency_buckets> latency_buckets{};
+};
+
+/**
+ * @brief A copy of every stage timing and counter, taken by `snapshot_stats`.
+ */
+struct stats_snapshot
+{
+    std::array<stage_stats, num_stats_stages> stages{};
+    std::array<std::uint64_t, num_stats_counters> counters{};
+};
+
+/**
+ * @return stats_snapshot holding the current value of every timing and counter.
+ */
+stats_snapshot snapshot_stats();
+
+/**
+ * @brief Set every timing and counter back to zero.
+ */
+void reset_stats();
+
+/**
+ * @brief Write a snapshot as a JSON document.
+ *
+ * Each stage reports its calls, items, total, mean and maximum time, and p50/p99 latencies
+ * taken from the upper bounds of the histogram buckets, along with the non-empty buckets.
+ *
+ * @param output        the stream to write to.
+ * @param stats         the timings and counters to write.
+ * @param wall_seconds  the elapsed time of the whole run, used for the rate of ids per second.
+ */
+void write_stats_json(std::ostream& output, stats_snapshot const& stats, double wall_seconds);
+} // namespace asset_id
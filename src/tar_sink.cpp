@@ -0,0 +1,252 @@
+#include "tar_sink.h"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "atomic_write.h"
+#include "logger.h"
+#include "png_encoder.h"
+#include "stats.h"
+
+namespace
+{
+constexpr auto const block_size = std::size_t{512U};
+
+/**
+ * @brief Offsets and sizes of the ustar header fields used by this sink.
+ */
+constexpr auto const name_offset = std::size_t{0U};
+constexpr auto const name_size = std::size_t{100U};
+constexpr auto const checksum_offset = std::size_t{148U};
+constexpr auto const checksum_size = std::size_t{8U};
+
+using tar_header_t = std::array<char, block_size>;
+
+/**
+ * @brief Every entry holds one png file, so each occupies a header block followed by the file
+ * padded to a whole block.
+ */
+constexpr auto const entry_data_blocks =
+    (asset_id::encoded_png_num_bytes + block_size - 1U) / block_size;
+constexpr auto const entry_size = block_size * (1U + entry_data_blocks);
+
+constexpr void
+put_field(tar_header_t& header, std::size_t const offset, char const* value, std::size_t length)
+{
+    for (auto index = std::size_t{0U}; index < length; ++index)
+    {
+        header[offset + index] = value[index];
+    }
+}
+
+/**
+ * @brief Write `value` as a zero padded octal number of `width` digits.
+ */
+constexpr void put_octal(
+    tar_header_t& header,
+    std::size_t const offset,
+    std::size_t const width,
+    std::size_t value
+)
+{
+    for (auto index = width; index > 0U; --index)
+    {
+        header[offset + index - 1U] = static_cast<char>('0' + (value & 7U));
+        value >>= 3U;
+    }
+}
+
+/**
+ * @brief Build the header shared by every entry: everything but the name and checksum.
+ */
+constexpr tar_header_t make_header_template()
+{
+    tar_header_t header{};
+
+    put_octal(header, 100U, 7U, 0644U);                          // mode
+    put_octal(header, 108U, 7U, 0U);                             // uid
+    put_octal(header, 116U, 7U, 0U);                             // gid
+    put_octal(header, 124U, 11U, asset_id::encoded_png_num_bytes); // size
+    put_octal(header, 136U, 11U, 0U);                            // mtime: fixed for reproducibility
+    header[156U] = '0';                                          // typeflag: regular file
+    put_field(header, 257U, "ustar", 6U);                        // magic, including its NUL
+    put_field(header, 263U, "00", 2U);                           // version
+
+    return header;
+}
+
+constexpr auto const header_template = make_header_template();
+
+/**
+ * @brief Append an entry to `buffer`, which must already have room for `entry_size` bytes at
+ * `offset`.
+ *
+ * @return true   if the entry was added.
+ * @return false  if the file name does not fit in the header.
+ */
+bool append_entry(
+    std::vector<char>& buffer,
+    std::size_t const offset,
+    asset_id::output_item const& item
+)
+{
+    constexpr auto const extension = std::string_view{".png"};
+    if (item.file_stem.size() + extension.size() >= name_size)
+    {
+        return false;
+    }
+
+    auto header = header_template;
+    put_field(header, name_offset, item.file_stem.data(), item.file_stem.size());
+    put_field(
+        header, name_offset + item.file_stem.size(), extension.data(), extension.size()
+    );
+
+    // The checksum is calculated with its own field filled with spaces.
+    auto checksum = std::size_t{0U};
+    for (auto index = std::size_t{0U}; index < header.size(); ++index)
+    {
+        auto const is_checksum_field =
+            (index >= checksum_offset) && (index < checksum_offset + checksum_size);
+        checksum += is_checksum_field ? ' ' : static_cast<unsigned char>(header[index]);
+    }
+    put_octal(header, checksum_offset, 6U, checksum);
+    header[checksum_offset + 6U] = '\0';
+    header[checksum_offset + 7U] = ' ';
+
+    auto const encoded = asset_id::builtin_encoding(item);
+
+    auto* const entry = buffer.data() + offset;
+    std::memcpy(entry, header.data(), header.size());
+    std::memcpy(entry + block_size, encoded.data(), encoded.size());
+    std::memset(entry + block_size + encoded.size(), 0, entry_size - block_size - encoded.size());
+
+    return true;
+}
+} // namespace
+
+namespace asset_id
+{
+std::unique_ptr<tar_sink>
+tar_sink::open(std::filesystem::path const& path, durability_settings const& durability)
+{
+    if (path == "-")
+    {
+        return std::unique_ptr<tar_sink>{new tar_sink{STDOUT_FILENO, false, {}}};
+    }
+
+    auto const fd =
+        ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, new_file_mode);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    return std::unique_ptr<tar_sink>{new tar_sink{fd, true, durability}};
+}
+
+tar_sink::~tar_sink()
+{
+    if (_owns_fd)
+    {
+        close(_fd);
+    }
+}
+
+void tar_sink::write(output_item* const items, std::size_t const num_items)
+{
+    _buffer.resize(num_items * entry_size);
+
+    auto size = std::size_t{0U};
+    for (auto index = std::size_t{0U}; index < num_items; ++index)
+    {
+        auto& item = items[index];
+
+        item.written = append_entry(_buffer, size, item);
+        if (!item.written)
+        {
+            item.error = error_code::name_too_long;
+            continue;
+        }
+
+        size += entry_size;
+    }
+    _buffer.resize(size);
+
+    if (!flush() || !sync_entries(size / entry_size))
+    {
+        for (auto index = std::size_t{0U}; index < num_items; ++index)
+        {
+            items[index].written = false;
+            items[index].error = error_code::io_error;
+        }
+    }
+}
+
+bool tar_sink::finish()
+{
+    // The end of an archive is marked by two zero filled blocks.
+    _buffer.assign(2U * block_size, '\0');
+    if (!flush())
+    {
+        return false;
+    }
+
+    // The file system is synced as well, so the archive's own directory entry is durable.
+    return (!_sync.per_file() || sync_file(_fd)) && _sync.finish(_fd) && !_failed;
+}
+
+bool tar_sink::sync_entries(std::size_t const num_entries)
+{
+    if (!_sync.per_file())
+    {
+        _sync.files_written(_fd, num_entries);
+        return true;
+    }
+
+    if ((num_entries > 0U) && !sync_file(_fd))
+    {
+        _failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool tar_sink::flush()
+{
+    if (_failed)
+    {
+        return false;
+    }
+
+    auto const timer = stage_timer{stats_stage::write};
+
+    auto const* data = _buffer.data();
+    auto remaining = _buffer.size();
+    while (remaining > 0U)
+    {
+        auto const written = ::write(_fd, data, remaining);
+        add_count(stats_counter::syscalls, 1U);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            log_message(log_level::error, "Failed to write to the archive: ", std::strerror(errno));
+            _failed = true;
+            return false;
+        }
+
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+        add_count(stats_counter::bytes_written, static_cast<std::uint64_t>(written));
+    }
+
+    return true;
+}
+} // namespace asset_id
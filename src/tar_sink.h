@@ -0,0 +1,81 @@
+/**
+ * @file   tar_sink.h
+ * @brief  An output sink that streams every png file into a single tar archive.
+ *
+ * The archive is written in the POSIX ustar format. Every header field that could vary between
+ * runs (modification time, owner, permissions) is fixed and the entries appear in input order,
+ * so the same input always produces a byte-for-byte identical archive.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "output_sink.h"
+
+namespace asset_id
+{
+class tar_sink final : public output_sink
+{
+public:
+    /**
+     * @brief Create a sink that writes an archive to `path`, or to standard output if `path` is
+     * `-`; an existing file is truncated.
+     *
+     * With `durability_mode::per_file` the archive is synced after every call to `write`;
+     * with `batch`, the file system holding it is synced every `sync_interval` entries. Either
+     * way it is synced again once complete. Standard output cannot be made durable.
+     *
+     * @return std::unique_ptr<tar_sink> holding the sink; null if `path` cannot be opened.
+     */
+    static std::unique_ptr<tar_sink>
+    open(std::filesystem::path const& path, durability_settings const& durability = {});
+
+    ~tar_sink() override;
+
+    /**
+     * @brief Append one entry, named `<file_stem>.png`, per item; the entries of each call are
+     * gathered into a single buffer and written with as few system calls as possible.
+     */
+    void write(output_item* items, std::size_t num_items) override;
+
+    bool is_concurrent() const override { return false; }
+
+    bool wants_encoded() const override { return true; }
+
+    /**
+     * @brief Write the end-of-archive marker, then sync the archive as its durability requires.
+     */
+    bool finish() override;
+
+private:
+    tar_sink(int fd, bool owns_fd, durability_settings const& durability):
+        _fd(fd),
+        _owns_fd(owns_fd),
+        _sync(durability)
+    {
+    }
+
+    /**
+     * @brief Sync the archive after `num_entries` more entries have been written to it.
+     */
+    bool sync_entries(std::size_t num_entries);
+
+    /**
+     * @brief Write the whole of `_buffer` to the archive.
+     */
+    bool flush();
+
+    int _fd;
+    bool _owns_fd;
+    bool _failed = false;
+    sync_schedule _sync;
+
+    /**
+     * @brief Reused between calls to `write` so that steady state archiving does not allocate.
+     */
+    std::vector<char> _buffer;
+};
+} // namespace asset_id
@@ -0,0 +1,509 @@
+#include "uring_sink.h"
+
+#ifndef ASSET_ID_WITH_IO_URING
+#define ASSET_ID_WITH_IO_URING 0
+#endif
+
+#if ASSET_ID_WITH_IO_URING
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <liburing.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "atomic_write.h"
+#include "durability.h"
+#include "logger.h"
+#include "png_encoder.h"
+#include "stats.h"
+
+namespace
+{
+/**
+ * @brief Identifies a completion: the index of the item in the current window and the
+ * operation that completed.
+ */
+enum class uring_op : std::uint64_t
+{
+    open = 0U,
+    write = 1U,
+    close = 2U,
+    fsync = 3U,
+    rename = 4U,
+};
+
+constexpr auto const op_bits = 3U;
+
+/**
+ * @brief The number of times a file is submitted before an interrupted chain counts as failed.
+ */
+constexpr auto const max_attempts = 8U;
+
+/**
+ * @return true if an operation that failed with `result` may succeed when submitted again. The
+ * kernel cancels a chain with `-ECANCELED` when a signal interrupts the creation of the worker
+ * thread that would run it, and every later operation of a broken chain is cancelled the same
+ * way.
+ */
+constexpr bool is_transient(int const result)
+{
+    return (result == -ECANCELED) || (result == -EINTR) || (result == -EAGAIN);
+}
+
+constexpr std::uint64_t make_user_data(std::size_t const slot, uring_op const op)
+{
+    return (static_cast<std::uint64_t>(slot) << op_bits) | static_cast<std::uint64_t>(op);
+}
+
+class uring_sink final : public asset_id::output_sink
+{
+public:
+    uring_sink(
+        int dir_fd,
+        unsigned queue_depth,
+        bool incremental,
+        asset_id::durability_settings const& durability
+    ):
+        _dir_fd(dir_fd),
+        _incremental(incremental),
+        _sync(durability),
+        _names(queue_depth),
+        _temp_names(queue_depth),
+        _buffers(queue_depth),
+        _opened(queue_depth),
+        _bytes_written(queue_depth),
+        _synced(queue_depth),
+        _renamed(queue_depth),
+        _retryable(queue_depth),
+        _attempts(queue_depth)
+    {
+        _pending.reserve(queue_depth);
+    }
+
+    ~uring_sink() override
+    {
+        if (_initialised)
+        {
+            io_uring_queue_exit(&_ring);
+        }
+        close(_dir_fd);
+    }
+
+    /**
+     * @brief Create the ring and its fixed file table.
+     *
+     * @return true   if the ring is ready for use.
+     * @return false  if the kernel does not support the operations used by this sink.
+     */
+    bool initialise();
+
+    void write(asset_id::output_item* items, std::size_t num_items) override;
+
+    bool is_concurrent() const override { return false; }
+
+    bool wants_encoded() const override { return true; }
+
+    bool finish() override { return !_broken && _sync.finish(_dir_fd); }
+
+private:
+    /**
+     * @brief Write every item in `_pending`, which holds at most one item per slot. The items
+     * whose chain was only interrupted are left in `_pending`, to be submitted again.
+     */
+    void write_window();
+
+    bool is_unchanged(asset_id::output_item const& item);
+
+    /**
+     * @brief Submit every queued operation.
+     *
+     * @return true   if the kernel accepted all `num_ops` of them.
+     * @return false  if it failed, or accepted only some of them.
+     */
+    bool submit(std::size_t num_ops);
+
+    /**
+     * @brief Wait for `count` completions, recording the outcome of each against its slot.
+     *
+     * @return true   if all of them completed.
+     * @return false  if waiting failed; the outcome of the window is then unknown.
+     */
+    bool reap(std::size_t count);
+
+    /**
+     * @brief Give up on the ring after it failed mid-window: fail every file of the window, tear
+     * the ring down, which cancels whatever is still in flight and closes its files, and remove
+     * the temporary files. Every later file fails as well.
+     */
+    void abandon_window(int error);
+
+    int _dir_fd;
+    bool _incremental;
+    asset_id::sync_schedule _sync;
+    io_uring _ring{};
+    bool _initialised = false;
+    bool _broken = false;
+
+    std::vector<asset_id::output_item*> _pending;
+    std::string _check_name;
+
+    // One entry per slot of the window; the storage must outlive each submission.
+    std::vector<std::string> _names;
+    std::vector<std::string> _temp_names;
+    std::vector<asset_id::encoded_png_t> _buffers;
+    std::vector<char> _opened;
+    std::vector<int> _bytes_written;
+    std::vector<char> _synced;
+    std::vector<char> _renamed;
+    std::vector<char> _retryable;
+    std::vector<unsigned> _attempts;
+};
+
+bool uring_sink::initialise()
+{
+    auto const queue_depth = static_cast<unsigned>(_names.size());
+
+    // Every file in a window needs an open, a write and a rename, and an fsync when each file
+    // must be durable, submitted together. Every kernel that accepts a sparse file table also
+    // supports the rename.
+    auto const ops_per_item = _sync.per_file() ? 4U : 3U;
+    if (io_uring_queue_init(ops_per_item * queue_depth, &_ring, 0U) != 0)
+    {
+        return false;
+    }
+    _initialised = true;
+
+    return io_uring_register_files_sparse(&_ring, queue_depth) == 0;
+}
+
+void uring_sink::write(asset_id::output_item* const items, std::size_t const num_items)
+{
+    auto const window = _names.size();
+    auto start = std::size_t{0U};
+    while (start < num_items)
+    {
+        // Only the files that need writing are gathered into the window.
+        auto count = std::size_t{0U};
+        for (; (start + count < num_items) && (_pending.size() < window); ++count)
+        {
+            auto& item = items[start + count];
+            if (_broken)
+            {
+                item.written = false;
+                item.error = asset_id::error_code::io_error;
+                continue;
+            }
+            if (_incremental && is_unchanged(item))
+            {
+                item.written = true;
+                item.unchanged = true;
+                continue;
+            }
+            _attempts[_pending.size()] = 0U;
+            _pending.push_back(&item);
+        }
+
+        write_window();
+        start += count;
+    }
+
+    while (!_pending.empty())
+    {
+        write_window();
+    }
+}
+
+bool uring_sink::is_unchanged(asset_id::output_item const& item)
+{
+    _check_name.assign(item.file_stem);
+    _check_name += ".png";
+
+    return asset_id::file_matches(_dir_fd, _check_name.c_str(), asset_id::builtin_encoding(item));
+}
+
+void uring_sink::write_window()
+{
+    auto const num_items = _pending.size();
+    if (num_items == 0U)
+    {
+        return;
+    }
+
+    // Each file is opened under a hidden temporary name straight into a slot of the ring's fixed
+    // file table and the write is linked to the open, so the pair costs no file descriptor and
+    // no extra system call; the kernel rejects `O_CLOEXEC` for such a file, which never enters
+    // the descriptor table anyway. When every file must be durable, an fsync is linked to the
+    // write in the same way. Last in the chain, a rename moves the complete file into place, so
+    // a reader never sees a partly written file and a failed write leaves the old one untouched.
+    auto const per_file = _sync.per_file();
+    auto const ops_per_item = per_file ? 4U : 3U;
+    for (auto slot = std::size_t{0U}; slot < num_items; ++slot)
+    {
+        auto& name = _names[slot];
+        name.assign(_pending[slot]->file_stem);
+        name += ".png";
+        _temp_names[slot] = asset_id::staging_name(name.c_str());
+
+        _buffers[slot] = asset_id::builtin_encoding(*_pending[slot]);
+        _opened[slot] = 0;
+        _bytes_written[slot] = -1;
+        _synced[slot] = per_file ? 0 : 1;
+        _renamed[slot] = 0;
+        _retryable[slot] = 1;
+
+        auto* const open_sqe = io_uring_get_sqe(&_ring);
+        io_uring_prep_openat_direct(
+            open_sqe,
+            _dir_fd,
+            _temp_names[slot].c_str(),
+            O_WRONLY | O_CREAT | O_EXCL,
+            asset_id::new_file_mode,
+            static_cast<unsigned>(slot)
+        );
+        io_uring_sqe_set_flags(open_sqe, IOSQE_IO_LINK);
+        io_uring_sqe_set_data64(open_sqe, make_user_data(slot, uring_op::open));
+
+        auto* const write_sqe = io_uring_get_sqe(&_ring);
+        io_uring_prep_write(
+            write_sqe,
+            static_cast<int>(slot),
+            _buffers[slot].data(),
+            static_cast<unsigned>(_buffers[slot].size()),
+            0U
+        );
+        io_uring_sqe_set_flags(write_sqe, IOSQE_FIXED_FILE | IOSQE_IO_LINK);
+        io_uring_sqe_set_data64(write_sqe, make_user_data(slot, uring_op::write));
+
+        if (per_file)
+        {
+            auto* const fsync_sqe = io_uring_get_sqe(&_ring);
+            io_uring_prep_fsync(fsync_sqe, static_cast<int>(slot), 0U);
+            io_uring_sqe_set_flags(fsync_sqe, IOSQE_FIXED_FILE | IOSQE_IO_LINK);
+            io_uring_sqe_set_data64(fsync_sqe, make_user_data(slot, uring_op::fsync));
+        }
+
+        // A failed or short write breaks the chain, which cancels the rename.
+        auto* const rename_sqe = io_uring_get_sqe(&_ring);
+        io_uring_prep_renameat(
+            rename_sqe, _dir_fd, _temp_names[slot].c_str(), _dir_fd, name.c_str(), 0U
+        );
+        io_uring_sqe_set_data64(rename_sqe, make_user_data(slot, uring_op::rename));
+    }
+
+    auto const timer = asset_id::stage_timer{asset_id::stats_stage::write, num_items};
+
+    if (!submit(ops_per_item * num_items) || !reap(ops_per_item * num_items))
+    {
+        abandon_window(errno);
+        return;
+    }
+
+    // A close is only queued for the slots that were actually opened; it is not linked to the
+    // write so that a failed write cannot leave its slot occupied. Renaming an open file is
+    // fine, so the closes need not come before the renames.
+    auto num_closes = std::size_t{0U};
+    for (auto slot = std::size_t{0U}; slot < num_items; ++slot)
+    {
+        if (!_opened[slot])
+        {
+            continue;
+        }
+
+        auto* const close_sqe = io_uring_get_sqe(&_ring);
+        io_uring_prep_close_direct(close_sqe, static_cast<unsigned>(slot));
+        io_uring_sqe_set_data64(close_sqe, make_user_data(slot, uring_op::close));
+        ++num_closes;
+    }
+
+    if ((num_closes > 0U) && (!submit(num_closes) || !reap(num_closes)))
+    {
+        abandon_window(errno);
+        return;
+    }
+    asset_id::add_count(asset_id::stats_counter::syscalls, 2U);
+
+    // The new directory entries are only durable once the directory itself has been synced.
+    auto const directory_synced = !per_file || asset_id::sync_file(_dir_fd);
+
+    auto num_written = std::size_t{0U};
+    auto num_retried = std::size_t{0U};
+    for (auto slot = std::size_t{0U}; slot < num_items; ++slot)
+    {
+        if (_opened[slot] && !_renamed[slot])
+        {
+            unlinkat(_dir_fd, _temp_names[slot].c_str(), 0);
+            asset_id::add_count(asset_id::stats_counter::syscalls, 1U);
+        }
+
+        if (_bytes_written[slot] > 0)
+        {
+            asset_id::add_count(
+                asset_id::stats_counter::bytes_written,
+                static_cast<std::uint64_t>(_bytes_written[slot])
+            );
+        }
+
+        if (!_renamed[slot] && _retryable[slot] && (_attempts[slot] + 1U < max_attempts))
+        {
+            _attempts[num_retried] = _attempts[slot] + 1U;
+            _pending[num_retried++] = _pending[slot];
+            continue;
+        }
+
+        _pending[slot]->written = _opened[slot] &&
+                                  (_bytes_written[slot] ==
+                                   static_cast<int>(_buffers[slot].size())) &&
+                                  _synced[slot] && _renamed[slot] && directory_synced;
+        _pending[slot]->error = asset_id::error_code::io_error;
+        num_written += _pending[slot]->written ? 1U : 0U;
+    }
+
+    _sync.files_written(_dir_fd, num_written);
+    _pending.resize(num_retried);
+}
+
+bool uring_sink::submit(std::size_t const num_ops)
+{
+    // Whatever the kernel did not accept stays queued and goes with the next call.
+    auto num_submitted = std::size_t{0U};
+    while (num_submitted < num_ops)
+    {
+        auto const result = io_uring_submit(&_ring);
+        if (result == -EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            errno = (result < 0) ? -result : EIO;
+            return false;
+        }
+        num_submitted += static_cast<std::size_t>(result);
+    }
+
+    return true;
+}
+
+bool uring_sink::reap(std::size_t count)
+{
+    while (count > 0U)
+    {
+        io_uring_cqe* cqe = nullptr;
+        auto const result = io_uring_wait_cqe(&_ring, &cqe);
+        if (result == -EINTR)
+        {
+            continue;
+        }
+        if (result != 0)
+        {
+            errno = -result;
+            return false;
+        }
+
+        auto const user_data = io_uring_cqe_get_data64(cqe);
+        auto const slot = static_cast<std::size_t>(user_data >> op_bits);
+        auto const op_result = cqe->res;
+        io_uring_cqe_seen(&_ring, cqe);
+        --count;
+
+        if ((op_result < 0) && !is_transient(op_result))
+        {
+            _retryable[slot] = 0;
+        }
+
+        switch (static_cast<uring_op>(user_data & ((1U << op_bits) - 1U)))
+        {
+            case uring_op::open:
+                _opened[slot] = (op_result >= 0) ? 1 : 0;
+                break;
+            case uring_op::write:
+                _bytes_written[slot] = op_result;
+                if ((op_result >= 0) && (op_result != static_cast<int>(_buffers[slot].size())))
+                {
+                    // A short write is not retried either.
+                    _retryable[slot] = 0;
+                }
+                break;
+            case uring_op::close:
+                if (op_result < 0)
+                {
+                    // The data may not have reached the file.
+                    _bytes_written[slot] = op_result;
+                }
+                break;
+            case uring_op::fsync:
+                _synced[slot] = (op_result == 0) ? 1 : 0;
+                break;
+            case uring_op::rename:
+                _renamed[slot] = (op_result == 0) ? 1 : 0;
+                break;
+        }
+    }
+
+    return true;
+}
+
+void uring_sink::abandon_window(int const error)
+{
+    asset_id::log_message(
+        asset_id::log_level::error, "io_uring failed, giving up on it: ", std::strerror(error)
+    );
+
+    io_uring_queue_exit(&_ring);
+    _initialised = false;
+    _broken = true;
+
+    for (auto slot = std::size_t{0U}; slot < _pending.size(); ++slot)
+    {
+        unlinkat(_dir_fd, _temp_names[slot].c_str(), 0);
+        _pending[slot]->written = false;
+        _pending[slot]->error = asset_id::error_code::io_error;
+    }
+    asset_id::add_count(asset_id::stats_counter::syscalls, _pending.size());
+    _pending.clear();
+}
+} // namespace
+
+namespace asset_id
+{
+std::unique_ptr<output_sink> make_uring_sink(
+    std::filesystem::path const& output_dir,
+    unsigned const queue_depth,
+    bool const incremental,
+    durability_settings const& durability
+)
+{
+    if (queue_depth == 0U)
+    {
+        return nullptr;
+    }
+
+    auto const dir_fd = open(output_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0)
+    {
+        return nullptr;
+    }
+
+    auto sink = std::make_unique<uring_sink>(dir_fd, queue_depth, incremental, durability);
+    if (!sink->initialise())
+    {
+        return nullptr;
+    }
+
+    return sink;
+}
+} // namespace asset_id
+#else
+namespace asset_id
+{
+std::unique_ptr<output_sink> make_uring_sink(
+    std::filesystem::path const&, unsigned, bool, durability_settings const&
+)
+{
+    return nullptr;
+}
+} // namespace asset_id
+#endif
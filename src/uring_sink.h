@@ -0,0 +1,47 @@
+/**
+ * @file   uring_sink.h
+ * @brief  A Linux output sink that writes png files through batched io_uring submissions.
+ *
+ * Each png file is encoded into memory and written under a hidden temporary name with an
+ * `openat`, `write`, `renameat` chain of io_uring operations, so that it replaces any existing
+ * file at once, as `write_file_atomically` does; a whole queue's worth of files is submitted
+ * with a single system call. This backend is only built when liburing is found
+ * (`ASSET_ID_WITH_IO_URING`).
+ */
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "output_sink.h"
+
+namespace asset_id
+{
+/**
+ * @brief The default number of files in flight at once in an io_uring sink.
+ */
+constexpr auto const default_queue_depth = 64U;
+
+/**
+ * @brief Attempt to create an output sink that writes png files into `output_dir` through
+ * io_uring.
+ *
+ * @param output_dir   the directory that will hold the png files.
+ * @param queue_depth  the maximum number of files written by a single submission.
+ * @param incremental  whether existing files that already hold the expected bytes are left
+ *                     untouched.
+ * @param durability   when the files are synced to disk; in `per_file` mode an fsync is linked
+ *                     to the write of every file and the directory is synced after each
+ *                     submission.
+ *
+ * @return std::unique_ptr<output_sink> holding the sink; null if io_uring is not available,
+ *         either because this build of the tool lacks liburing or the kernel refuses to
+ *         create a ring; the caller should then fall back to a `directory_sink`.
+ */
+std::unique_ptr<output_sink> make_uring_sink(
+    std::filesystem::path const& output_dir,
+    unsigned queue_depth,
+    bool incremental,
+    durability_settings const& durability = {}
+);
+} // namespace asset_id
@@ -0,0 +1,291 @@
+#include "verify.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "id_table.h"
+#include "png_decoder.h"
+#include "png_encoder.h"
+
+namespace
+{
+/**
+ * @brief The number of files whose outcomes are gathered before they are recorded in name order.
+ */
+constexpr auto const chunk_num_files = std::size_t{4096U};
+
+/**
+ * @brief The largest file read; a valid file is far smaller, so anything bigger is corrupt.
+ */
+constexpr auto const max_file_bytes = std::size_t{64U * 1024U};
+
+/**
+ * @brief The inverse of `pixels_per_digit`: the value of the digit drawn by each byte.
+ */
+constexpr std::array<std::uint8_t, 256U> make_digit_per_pixels()
+{
+    std::array<std::uint8_t, 256U> table{};
+    // Every other byte maps to a value that is not a digit.
+    for (auto& entry: table)
+    {
+        entry = 0xFFU;
+    }
+    for (auto value = 0U; value < asset_id::pixels_per_digit.size(); ++value)
+    {
+        table[asset_id::pixels_per_digit[value]] = static_cast<std::uint8_t>(value);
+    }
+    return table;
+}
+
+constexpr auto const digit_per_pixels = make_digit_per_pixels();
+
+/**
+ * @brief Read back the checked id drawn in an image line.
+ *
+ * @return result<checked_asset_id_t> holding the digits drawn; `error_code::unknown_segment` if
+ *         a digit is not drawn where one is expected, or anything is drawn elsewhere.
+ */
+asset_id::result<asset_id::checked_asset_id_t> read_checked_id(asset_id::image_line_t const& pixels)
+{
+    auto checked_id = asset_id::checked_asset_id_t{};
+    for (auto index = std::size_t{0U}; index < pixels.size(); ++index)
+    {
+        auto const position = index - asset_id::image_line_start_byte;
+        if ((index < asset_id::image_line_start_byte) || (position >= checked_id.size()))
+        {
+            if (pixels[index] != 0U)
+            {
+                return asset_id::error_code::unknown_segment;
+            }
+            continue;
+        }
+
+        auto const drawn = asset_id::digit::from_int(digit_per_pixels[pixels[index]]);
+        if (!drawn)
+        {
+            return asset_id::error_code::unknown_segment;
+        }
+        checked_id[position] = *drawn;
+    }
+    return checked_id;
+}
+
+/**
+ * @brief Read and verify a single file of the directory `dir_fd`, using `buffer` for its bytes.
+ */
+asset_id::result<void>
+verify_file(int const dir_fd, std::string const& name, std::vector<std::uint8_t>& buffer)
+{
+    auto const fd = openat(dir_fd, name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return asset_id::error_code::io_error;
+    }
+
+    // One byte more than the largest file accepted is read, so an oversized file is detected.
+    auto size = std::size_t{0U};
+    while (size < buffer.size())
+    {
+        auto const count = read(fd, buffer.data() + size, buffer.size() - size);
+        if ((count < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if (count < 0)
+        {
+            close(fd);
+            return asset_id::error_code::io_error;
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        size += static_cast<std::size_t>(count);
+    }
+    close(fd);
+
+    if (size > max_file_bytes)
+    {
+        return asset_id::error_code::corrupt_png;
+    }
+
+    auto const stem = std::string_view{name}.substr(0U, name.size() - 4U);
+    return asset_id::verify_png(stem, buffer.data(), size);
+}
+
+/**
+ * @brief List the directory `dir_fd` through a duplicate of the descriptor, setting `listed`
+ * once every entry has been read.
+ *
+ * @return std::vector<std::string> holding the names of the `.png` files, sorted.
+ */
+std::vector<std::string> list_png_files(int const dir_fd, bool& listed)
+{
+    std::vector<std::string> names{};
+    listed = false;
+
+    auto const stream_fd = fcntl(dir_fd, F_DUPFD_CLOEXEC, 0);
+    auto* const dir = (stream_fd < 0) ? nullptr : fdopendir(stream_fd);
+    if (!dir)
+    {
+        if (stream_fd >= 0)
+        {
+            close(stream_fd);
+        }
+        return names;
+    }
+
+    errno = 0;
+    while (auto const* const entry = readdir(dir))
+    {
+        auto const name = std::string_view{entry->d_name};
+        auto const is_png = (name.size() > 4U) && (name.substr(name.size() - 4U) == ".png");
+        if (is_png && (entry->d_type != DT_DIR))
+        {
+            names.emplace_back(name);
+        }
+    }
+    listed = (errno == 0);
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+} // namespace
+
+namespace asset_id
+{
+result<void>
+verify_png(std::string_view const file_stem, std::uint8_t const* const data, std::size_t const size)
+{
+    auto const asset_id = create_asset_id(file_stem);
+    if (!asset_id)
+    {
+        return asset_id.error();
+    }
+
+    // The files written by the builtin encoder only need comparing.
+    auto const& rendered = lookup_rendered_id(*asset_id);
+    if (size == encoded_png_num_bytes)
+    {
+        auto const expected = encode_png(rendered.pixels);
+        if (std::memcmp(data, expected.data(), expected.size()) == 0)
+        {
+            return {};
+        }
+    }
+
+    auto const pixels = decode_png(data, size);
+    if (!pixels)
+    {
+        return pixels.error();
+    }
+
+    auto const drawn = read_checked_id(*pixels);
+    if (!drawn)
+    {
+        return drawn.error();
+    }
+
+    auto drawn_id = asset_id_t{};
+    std::copy(drawn->begin() + checksum_length, drawn->end(), drawn_id.begin());
+
+    auto const checksum = calculate_checksum<default_geometry>(drawn_id);
+    if (!std::equal(checksum.begin(), checksum.end(), drawn->begin()))
+    {
+        return error_code::checksum_mismatch;
+    }
+
+    if (drawn_id != *asset_id)
+    {
+        return error_code::id_mismatch;
+    }
+
+    return {};
+}
+
+result<verify_summary> verify_directory(
+    std::filesystem::path const& dir, options const& settings, std::ostream* const failure_stream
+)
+{
+    auto const dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0)
+    {
+        return error_code::io_error;
+    }
+
+    auto listed = false;
+    auto const names = list_png_files(dir_fd, listed);
+    if (!listed)
+    {
+        close(dir_fd);
+        return error_code::io_error;
+    }
+
+    auto summary = verify_summary{};
+    summary.num_files = names.size();
+
+    std::vector<result<void>> outcomes(std::min(chunk_num_files, names.size()));
+    for (auto chunk_begin = std::size_t{0U}; chunk_begin < names.size();
+         chunk_begin += chunk_num_files)
+    {
+        auto const num_files = std::min(chunk_num_files, names.size() - chunk_begin);
+
+        // The files are claimed one at a time, so one slow read does not hold up the others.
+        auto next_file = std::atomic<std::size_t>{0U};
+        auto const worker = [&]()
+        {
+            std::vector<std::uint8_t> buffer(max_file_bytes + 1U);
+            for (auto index = next_file++; index < num_files; index = next_file++)
+            {
+                outcomes[index] = verify_file(dir_fd, names[chunk_begin + index], buffer);
+            }
+        };
+
+        auto const num_threads = std::min<std::size_t>(settings.jobs, num_files);
+        std::vector<std::thread> threads{};
+        for (auto thread_index = std::size_t{1U}; thread_index < num_threads; ++thread_index)
+        {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto& thread: threads)
+        {
+            thread.join();
+        }
+
+        for (auto index = std::size_t{0U}; index < num_files; ++index)
+        {
+            if (outcomes[index])
+            {
+                continue;
+            }
+
+            auto const& name = names[chunk_begin + index];
+            auto const error = outcomes[index].error();
+            ++summary.num_failures;
+            ++summary.failures_by_error[static_cast<std::size_t>(error)];
+            if (failure_stream)
+            {
+                *failure_stream << name << '\t' << to_string(error) << '\n';
+            }
+            if (summary.failures.size() < settings.failure_samples)
+            {
+                summary.failures.push_back({name, error});
+            }
+        }
+    }
+
+    close(dir_fd);
+    return summary;
+}
+} // namespace asset_id
@@ -0,0 +1,110 @@
+/**
+ * @file   verify.h
+ * @brief  Audits directories of png files written by the tool, decoding each file back to the id
+ *         it shows.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "options.h"
+#include "result.h"
+
+namespace asset_id
+{
+/**
+ * @brief Check that `data` holds the png file of the id named by `file_stem`.
+ *
+ * A file holding exactly the bytes written by `encode_png` passes straight away. Any other file
+ * is decoded with `decode_png`, the digits are read back from the segments of the image line,
+ * and the checksum is recalculated from the id digits.
+ *
+ * @param file_stem  the name of the file without its `.png` extension.
+ * @param data       the bytes of the file.
+ * @param size       the number of bytes in `data`.
+ *
+ * @return result<void> holding no error if the file shows the id it is named after, with the
+ *         right checksum; otherwise the error of `create_asset_id` if `file_stem` is not an id,
+ *         the error of `decode_png`, `error_code::unknown_segment` if the image does not show a
+ *         checked id, `error_code::checksum_mismatch` if the checksum shown is wrong, or
+ *         `error_code::id_mismatch` if the image shows a different id.
+ */
+result<void> verify_png(std::string_view file_stem, std::uint8_t const* data, std::size_t size);
+
+/**
+ * @brief The `verify_failure` type records a png file that failed verification.
+ */
+struct verify_failure
+{
+    /**
+     * @brief The name of the file within the verified directory.
+     */
+    std::string file_name;
+
+    /**
+     * @brief Why the file failed.
+     */
+    error_code error = error_code::corrupt_png;
+
+    bool operator==(verify_failure const& other) const
+    {
+        return (file_name == other.file_name) && (error == other.error);
+    }
+};
+
+/**
+ * @brief The `verify_summary` type holds the outcome of a call to `verify_directory`.
+ */
+struct verify_summary
+{
+    /**
+     * @brief The number of png files checked.
+     */
+    std::size_t num_files = 0U;
+
+    /**
+     * @brief The first `options::failure_samples` files that failed, in name order; the
+     * remainder are only counted.
+     */
+    std::vector<verify_failure> failures;
+
+    /**
+     * @brief The number of files that failed.
+     */
+    std::size_t num_failures = 0U;
+
+    /**
+     * @brief The number of failed files for each error code, indexed by the value of the error
+     * code.
+     */
+    std::array<std::size_t, num_error_codes> failures_by_error{};
+};
+
+/**
+ * @brief Verify every file named `*.png` in `dir` with `verify_png`.
+ *
+ * The files are checked in name order, a chunk at a time, and the files of each chunk are shared
+ * out between `settings.jobs` worker threads. Every failure is written to `failure_stream`, when
+ * given, as a `<file name>\t<reason>` line once its chunk has been checked.
+ *
+ * @param dir             the directory to verify; its subdirectories are not visited.
+ * @param settings        the number of jobs and of failures kept; the remaining options are
+ *                        ignored.
+ * @param failure_stream  when not null, receives every failure as it is found.
+ *
+ * @return result<verify_summary> holding the number of files checked and the failures;
+ *         `error_code::io_error` if `dir` cannot be read.
+ */
+result<verify_summary> verify_directory(
+    std::filesystem::path const& dir,
+    options const& settings,
+    std::ostream* failure_stream = nullptr
+);
+} // namespace asset_id
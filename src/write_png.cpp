@@ -1,55 +1,103 @@
 #include "write_png.h"
 #include <cstddef>
-#include <cstdio>
-#include <iostream>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifndef ASSET_ID_WITH_LIBPNG
+#define ASSET_ID_WITH_LIBPNG 0
+#endif
+
+#if ASSET_ID_WITH_LIBPNG
 #include <png.h>
+#endif
 
+#include "atomic_write.h"
 #include "image_line.h"
+#include "stats.h"
 
 namespace
 {
-} // namespace
-
-namespace asset_id
-{
-bool write_as_png(checked_asset_id_t const& asset_id, std::filesystem::path const& destination)
+/**
+ * @brief Close a directory opened by `write_as_png` on every return path.
+ */
+class directory_fd
 {
-    if (destination.extension() != ".png")
+public:
+    explicit directory_fd(int const fd):
+        _fd(fd)
     {
-        std::cout << "Output must be a png file: " << destination.string() << "\n";
-        return false;
     }
 
-    auto const image_line_start_byte = 1U;
+    directory_fd(directory_fd const&) = delete;
+    directory_fd& operator=(directory_fd const&) = delete;
 
-    auto pixels = create_image_line(asset_id, image_line_start_byte);
-    if (!pixels)
+    ~directory_fd()
     {
-        std::cout << "Failed to create pixel row, skipping id.\n";
-        return false;
+        if (_fd >= 0)
+        {
+            close(_fd);
+        }
     }
 
-    bool result = false;
-    FILE* outfile = nullptr;
+    int get() const { return _fd; }
+
+private:
+    int _fd;
+};
+
+bool has_png_extension(std::string_view const name)
+{
+    constexpr auto const extension = std::string_view{".png"};
+    return (name.size() > extension.size()) &&
+           (name.substr(name.size() - extension.size()) == extension);
+}
+
+asset_id::result<void>
+write_builtin(
+    asset_id::image_line_t const& pixels,
+    int const dir_fd,
+    char const* const name,
+    bool const durable
+)
+{
+    auto const encoded = [&pixels]()
+    {
+        auto const timer = asset_id::stage_timer{asset_id::stats_stage::encode};
+        return asset_id::encode_png(pixels);
+    }();
+
+    auto const timer = asset_id::stage_timer{asset_id::stats_stage::write};
+    return asset_id::write_file_atomically(dir_fd, name, encoded.data(), encoded.size(), durable);
+}
+
+#if ASSET_ID_WITH_LIBPNG
+void append_to_buffer(png_struct* const write_struct, png_byte* const data, png_size_t const size)
+{
+    auto& buffer = *static_cast<std::vector<std::uint8_t>*>(png_get_io_ptr(write_struct));
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+void flush_buffer(png_struct*) {}
+
+/**
+ * @brief Encode a png file into memory through libpng.
+ */
+asset_id::result<std::vector<std::uint8_t>> encode_libpng(asset_id::image_line_t pixels)
+{
+    auto const timer = asset_id::stage_timer{asset_id::stats_stage::encode};
+    auto result = asset_id::result<std::vector<std::uint8_t>>{asset_id::error_code::encode_failed};
+    std::vector<std::uint8_t> encoded{};
     png_struct* write_struct = nullptr;
     png_info* info_struct = nullptr;
 
     do
     {
-        outfile = fopen(destination.c_str(), "wb");
-        if (!outfile)
-        {
-            std::cout << "Failed to access output file '" << destination.c_str()
-                      << "', skipping id.\n";
-            result = false;
-            break;
-        }
-
         write_struct = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
         if (!write_struct)
         {
-            std::cout << "Failed to create png write structure, skipping id.\n";
-            result = false;
             break;
         }
 
@@ -58,19 +106,17 @@ bool write_as_png(checked_asset_id_t const& asset_id, std::filesystem::path cons
         info_struct = png_create_info_struct(write_struct);
         if (!info_struct)
         {
-            std::cout << "Failed to create png info structure, skipping id.\n";
-            result = false;
             break;
         }
 
         auto const colour_bit_depth = 1;
         auto const image_line_height_pixels = 1;
 
-        png_init_io(write_struct, outfile);
+        png_set_write_fn(write_struct, &encoded, append_to_buffer, flush_buffer);
         png_set_IHDR(
             write_struct,
             info_struct,
-            image_line_width_pixels,
+            asset_id::image_line_width_pixels,
             image_line_height_pixels,
             colour_bit_depth,
             PNG_COLOR_TYPE_GRAY,
@@ -81,22 +127,139 @@ bool write_as_png(checked_asset_id_t const& asset_id, std::filesystem::path cons
 
         png_write_info(write_struct, info_struct);
 
-        auto* buf = pixels->data();
+        auto* buf = pixels.data();
         png_write_image(write_struct, &buf);
         png_write_end(write_struct, info_struct);
 
+        result = encoded;
     } while (false);
 
     png_destroy_info_struct(write_struct, &info_struct);
     png_destroy_write_struct(&write_struct, nullptr);
 
-    auto const closeRC = fclose(outfile);
-    if (closeRC != 0)
+    return result;
+}
+
+asset_id::result<void>
+write_libpng(
+    asset_id::image_line_t const& pixels,
+    int const dir_fd,
+    char const* const name,
+    bool const durable
+)
+{
+    // The file is encoded into memory first, so that it can be written in a single step.
+    auto const encoded = encode_libpng(pixels);
+    if (!encoded)
+    {
+        return encoded.error();
+    }
+
+    auto const timer = asset_id::stage_timer{asset_id::stats_stage::write};
+    return asset_id::write_file_atomically(
+        dir_fd, name, encoded->data(), encoded->size(), durable
+    );
+}
+#endif
+} // namespace
+
+namespace asset_id
+{
+bool is_available(png_backend const backend)
+{
+    switch (backend)
+    {
+        case png_backend::builtin:
+            return true;
+        case png_backend::libpng:
+            return ASSET_ID_WITH_LIBPNG != 0;
+    }
+
+    return false;
+}
+
+result<encoded_png_t> encode_as_png(checked_asset_id_t const& asset_id)
+{
+    auto const pixels = create_image_line(asset_id, image_line_start_byte);
+    if (!pixels)
+    {
+        return pixels.error();
+    }
+
+    auto const timer = stage_timer{stats_stage::encode};
+    return encode_png(*pixels);
+}
+
+result<void> write_as_png(
+    checked_asset_id_t const& asset_id,
+    std::filesystem::path const& destination,
+    png_backend const backend
+)
+{
+    auto const pixels = create_image_line(asset_id, image_line_start_byte);
+    if (!pixels)
+    {
+        return pixels.error();
+    }
+
+    return write_as_png(*pixels, destination, backend);
+}
+
+result<void> write_as_png(
+    image_line_t const& pixels,
+    std::filesystem::path const& destination,
+    png_backend const backend
+)
+{
+    if (destination.extension() != ".png")
+    {
+        return error_code::bad_destination;
+    }
+
+    if (!is_available(backend))
+    {
+        return error_code::backend_unavailable;
+    }
+
+    auto const parent = destination.parent_path();
+    auto const dir = directory_fd{
+        open(parent.empty() ? "." : parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+    };
+    add_count(stats_counter::syscalls, 1U);
+    if (dir.get() < 0)
+    {
+        return error_code::io_error;
+    }
+
+    return write_as_png(pixels, dir.get(), destination.filename().c_str(), backend);
+}
+
+result<void> write_as_png(
+    image_line_t const& pixels,
+    int const dir_fd,
+    char const* const name,
+    png_backend const backend,
+    bool const durable
+)
+{
+    if (!has_png_extension(name))
+    {
+        return error_code::bad_destination;
+    }
+
+    if (!is_available(backend))
+    {
+        return error_code::backend_unavailable;
+    }
+
+#if ASSET_ID_WITH_LIBPNG
+    if (backend == png_backend::libpng)
     {
-        std::cout << "Failed to close file " << destination.filename() << "; ignoring.\n";
+        return write_libpng(pixels, dir_fd, name, durable);
     }
+#endif
 
-    return true;
+    return write_builtin(pixels, dir_fd, name, durable);
 }
 
-} // namespace asset_id
\ No newline at end of file
+} // namespace asset_id
@@ -4,22 +4,106 @@
 #include <string_view>
 
 #include "asset_id.h"
+#include "image_line.h"
+#include "png_encoder.h"
+#include "result.h"
 
 namespace asset_id
 {
+/**
+ * @brief The `png_backend` type selects how png files are encoded.
+ *
+ * `builtin` uses the dedicated encoder in `png_encoder.h`; `libpng` builds each file through
+ * libpng and is only available when the tool is built with `ASSET_ID_WITH_LIBPNG`.
+ */
+enum class png_backend
+{
+    builtin,
+    libpng,
+};
+
+/**
+ * @return true   if png files can be written with `backend` in this build of the tool.
+ * @return false  otherwise.
+ */
+bool is_available(png_backend backend);
+
+/**
+ * @brief Render a checksum and asset id and encode the result as a complete png file held
+ * in memory.
+ *
+ * @param asset_id  the checksum and asset id to render.
+ *
+ * @return result<encoded_png_t> containing the png file if the id could be rendered;
+ *         the error of `create_image_line` otherwise.
+ */
+result<encoded_png_t> encode_as_png(checked_asset_id_t const& asset_id);
+
 /**
 * @brief 
 * 
 * @param asset_id     the checksum and asset id to render into a png file. 
 * @param destination  the path of the file to create.
+* @param backend      the encoder used to create the png file.
 *
 * NOTE: if `destination` is not accessible by the caller of this function then the 
 * behaviour is undefined.
 *
-* @return true   if an instance of `image_line_t` representing `asset_id` could be 
-*                created and saved as a png file.
-* @return false  otherwise; this includes `destination` not having the extension `png`.
+* @return result<void> holding no error if an instance of `image_line_t` representing
+*         `asset_id` could be created and saved as a png file; otherwise the error of
+*         `create_image_line` or of the overload below.
 */
-bool write_as_png(checked_asset_id_t const& asset_id, std::filesystem::path const& destination);
+result<void> write_as_png(
+    checked_asset_id_t const& asset_id,
+    std::filesystem::path const& destination,
+    png_backend backend = png_backend::builtin
+);
+
+/**
+ * @brief Save an already rendered line of pixels as a png file.
+ *
+ * The parent directory of `destination` is opened and the file is written with the overload
+ * below, so an existing file is replaced atomically.
+ *
+ * @param pixels       the pixels to save, for example from `lookup_rendered_id`.
+ * @param destination  the path of the file to create.
+ * @param backend      the encoder used to create the png file.
+ *
+ * @return result<void> holding no error if the png file was written; otherwise
+ *         `error_code::bad_destination` if `destination` does not have the extension `png`,
+ *         `error_code::backend_unavailable` if `backend` is not available,
+ *         `error_code::encode_failed` if libpng fails and `error_code::io_error` if the file
+ *         cannot be written.
+ */
+result<void> write_as_png(
+    image_line_t const& pixels,
+    std::filesystem::path const& destination,
+    png_backend backend = png_backend::builtin
+);
+
+/**
+ * @brief Save an already rendered line of pixels as the png file `name` in an open directory.
+ *
+ * The file is encoded in memory and written with `write_file_atomically`, so readers never see
+ * a partial file, and only `name` is resolved, relative to `dir_fd`.
+ *
+ * @param pixels   the pixels to save, for example from `lookup_rendered_id`.
+ * @param dir_fd   the directory to write into, opened with `O_DIRECTORY`.
+ * @param name     the name of the file within the directory.
+ * @param backend  the encoder used to create the png file.
+ * @param durable  when set, the file and its directory entry are synced to disk before this
+ *                 returns.
+ *
+ * @return result<void> holding no error if the png file was written; otherwise the errors of
+ *         the overload above, with `error_code::bad_destination` if `name` does not end in
+ *         `.png`.
+ */
+result<void> write_as_png(
+    image_line_t const& pixels,
+    int dir_fd,
+    char const* name,
+    png_backend backend = png_backend::builtin,
+    bool durable = false
+);
 
-} // namespace asset_id
\ No newline at end of file
+} // namespace asset_id
@@ -4,7 +4,6 @@
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
-#include <optional>
 #include <sstream>
 
 #include "asset_id.h"
@@ -18,12 +17,12 @@ using namespace asset_id;
  * 
  * @param value the integer value to create the `asset_id_t` from.
 
- * @return std::optional<asset_id_t> containing the `asset_id_t` if the construction 
- *         was possible; empty optional otherwise.
+ * @return result<asset_id_t> containing the `asset_id_t` if the construction 
+ *         was possible; `error_code::bad_length` otherwise.
  */
-std::optional<asset_id_t> create_asset_id(unsigned const value)
+result<asset_id_t> create_asset_id(unsigned const value)
 {
-    if (value >= 10000) { return std::nullopt; }
+    if (value >= 10000) { return error_code::bad_length; }
 
     std::stringstream iss;
     iss << std::setw(4) << std::setfill('0') << value;
@@ -104,6 +103,25 @@ TEST_CASE("create_asset_id fails for digits of length != 4")
     REQUIRE(!create_asset_id("123456"));
 }
 
+TEST_CASE("create_asset_id reports why an id was rejected")
+{
+    REQUIRE(create_asset_id("123").error() == error_code::bad_length);
+    REQUIRE(create_asset_id("12345").error() == error_code::bad_length);
+    REQUIRE(create_asset_id("12a4").error() == error_code::bad_digit);
+    REQUIRE(create_asset_id(" 123").error() == error_code::bad_digit);
+}
+
+TEST_CASE("A checksum that does not fit in its digits is an overflow")
+{
+    auto const asset_id = create_asset_id("9999");
+    REQUIRE(asset_id);
+
+    // 9999 % 200 is 199, which needs three base 10 digits.
+    auto const checksum = calculate_checksum(*asset_id, 10U, 200U);
+    REQUIRE(!checksum);
+    REQUIRE(checksum.error() == error_code::checksum_overflow);
+}
+
 TEST_CASE("create_asset_id doesn't skip whitespace")
 {
     REQUIRE(!create_asset_id(" 1234"));
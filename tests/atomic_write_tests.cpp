@@ -0,0 +1,166 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atomic_write.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that creates an empty directory and holds it open for the duration of a
+ * test.
+ */
+class test_dir
+{
+public:
+    explicit test_dir(std::string const& name): path(make_temp_dir("atomic_write_" + name))
+    {
+        fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+
+    test_dir(test_dir const&) = delete;
+    test_dir& operator=(test_dir const&) = delete;
+
+    ~test_dir()
+    {
+        close(fd);
+        std::filesystem::remove_all(path);
+    }
+
+    /**
+     * @return std::size_t holding the number of entries in the directory, including any
+     *         temporary files left behind.
+     */
+    std::size_t num_entries() const
+    {
+        auto const entries = std::filesystem::directory_iterator(path);
+        return static_cast<std::size_t>(std::distance(begin(entries), end(entries)));
+    }
+
+    std::filesystem::path path;
+    int fd = -1;
+};
+
+result<void> write_text(int const dir_fd, char const* const name, std::string const& text)
+{
+    return write_file_atomically(
+        dir_fd, name, reinterpret_cast<std::uint8_t const*>(text.data()), text.size()
+    );
+}
+} // namespace
+
+TEST_CASE("write_file_atomically creates a new file and replaces an existing one")
+{
+    auto const dir = test_dir{"replace"};
+    REQUIRE(dir.fd >= 0);
+
+    REQUIRE(write_text(dir.fd, "a.png", "first version"));
+    REQUIRE(read_file(dir.path / "a.png") == "first version");
+
+    // A reader that opened the old file keeps seeing all of it after the replacement.
+    auto reader = std::ifstream(dir.path / "a.png", std::ios::binary);
+    REQUIRE(write_text(dir.fd, "a.png", "second"));
+    REQUIRE(read_file(dir.path / "a.png") == "second");
+    REQUIRE(
+        std::string(std::istreambuf_iterator<char>(reader), std::istreambuf_iterator<char>()) ==
+        "first version"
+    );
+
+    REQUIRE(dir.num_entries() == 1U);
+}
+
+TEST_CASE("write_file_atomically leaves one complete file when writers race on its name")
+{
+    auto const dir = test_dir{"race"};
+    REQUIRE(dir.fd >= 0);
+
+    auto const num_threads = 8U;
+    auto const num_writes = 50U;
+    auto failures = std::atomic<unsigned>{0U};
+    std::vector<std::thread> threads{};
+    for (auto thread_index = 0U; thread_index < num_threads; ++thread_index)
+    {
+        threads.emplace_back(
+            [&dir, &failures, thread_index]()
+            {
+                auto const text = std::string(1000U + thread_index, char('a' + thread_index));
+                for (auto write = 0U; write < num_writes; ++write)
+                {
+                    failures += write_text(dir.fd, "shared.png", text) ? 0U : 1U;
+                }
+            }
+        );
+    }
+
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+    REQUIRE(failures == 0U);
+
+    auto const contents = read_file(dir.path / "shared.png");
+    REQUIRE(contents.size() >= 1000U);
+    auto const thread_index = contents.size() - 1000U;
+    REQUIRE(contents == std::string(contents.size(), char('a' + thread_index)));
+    REQUIRE(dir.num_entries() == 1U);
+}
+
+TEST_CASE("write_file_atomically creates files with the permissions left by the umask")
+{
+    auto const dir = test_dir{"umask"};
+    REQUIRE(dir.fd >= 0);
+
+    auto const previous = umask(002);
+    auto const created = write_text(dir.fd, "a.png", "text");
+    umask(previous);
+    REQUIRE(created);
+
+    auto const permissions = std::filesystem::status(dir.path / "a.png").permissions();
+    REQUIRE(permissions == static_cast<std::filesystem::perms>(0664));
+}
+
+TEST_CASE("staged_file only appears under its name once committed")
+{
+    auto const dir = test_dir{"staged"};
+    REQUIRE(dir.fd >= 0);
+    REQUIRE(write_text(dir.fd, "sheet.png", "previous"));
+
+    {
+        auto const abandoned = staged_file::create(dir.fd, "sheet.png");
+        REQUIRE(abandoned);
+        REQUIRE(write(abandoned->fd(), "partial", 7) == 7);
+    }
+    REQUIRE(read_file(dir.path / "sheet.png") == "previous");
+    REQUIRE(dir.num_entries() == 1U);
+
+    auto const file = staged_file::create(dir.fd, "sheet.png");
+    REQUIRE(file);
+    REQUIRE(write(file->fd(), "complete", 8) == 8);
+    REQUIRE(read_file(dir.path / "sheet.png") == "previous");
+
+    REQUIRE(file->commit());
+    REQUIRE(file->fd() < 0);
+    REQUIRE(read_file(dir.path / "sheet.png") == "complete");
+    REQUIRE(dir.num_entries() == 1U);
+}
+
+TEST_CASE("write_file_atomically reports a directory it cannot write to")
+{
+    REQUIRE(write_text(-1, "a.png", "text").error() == error_code::io_error);
+
+    auto const dir = test_dir{"missing"};
+    REQUIRE(write_text(dir.fd, "missing/a.png", "text").error() == error_code::io_error);
+    REQUIRE(dir.num_entries() == 0U);
+}
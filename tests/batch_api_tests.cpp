@@ -0,0 +1,131 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string_view>
+
+#include "batch_api.h"
+#include "id_table.h"
+
+using namespace asset_id;
+
+namespace
+{
+/**
+ * @brief Counts every heap allocation made by the test program, so that a test can check that
+ * a call made none.
+ */
+std::atomic<std::size_t> num_allocations{0U};
+
+/**
+ * @brief A test helper that runs `call` with standard output captured, checking that it neither
+ * allocates nor writes any output.
+ */
+template<typename Call>
+void require_silent_and_allocation_free(Call const& call)
+{
+    auto captured = std::ostringstream{};
+    auto* const previous = std::cout.rdbuf(captured.rdbuf());
+
+    auto const allocations_before = num_allocations.load();
+    call();
+    auto const allocations_after = num_allocations.load();
+
+    std::cout.rdbuf(previous);
+    REQUIRE(allocations_after == allocations_before);
+    REQUIRE(captured.str().empty());
+}
+} // namespace
+
+void* operator new(std::size_t const size)
+{
+    ++num_allocations;
+    if (auto* const memory = std::malloc(size == 0U ? 1U : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* const memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* const memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+TEST_CASE("make_checked_ids reports a status for every id string")
+{
+    std::string_view const ids[] = {"1337", "0000", "133", "13a7", "13370", "9999"};
+    constexpr auto const num_ids = sizeof(ids) / sizeof(ids[0]);
+
+    checked_asset_id_t checked[num_ids]{};
+    item_status statuses[num_ids]{};
+
+    auto num_ok = std::size_t{0U};
+    require_silent_and_allocation_free(
+        [&]() { num_ok = make_checked_ids(ids, num_ids, checked, statuses); });
+
+    REQUIRE(num_ok == 3U);
+    REQUIRE(statuses[0] == item_status::ok);
+    REQUIRE(statuses[1] == item_status::ok);
+    REQUIRE(statuses[2] == item_status::bad_length);
+    REQUIRE(statuses[3] == item_status::bad_digit);
+    REQUIRE(statuses[4] == item_status::bad_length);
+    REQUIRE(statuses[5] == item_status::ok);
+
+    REQUIRE(checked[0] == lookup_rendered_id(1337U).checked_id);
+    REQUIRE(checked[1] == lookup_rendered_id(0U).checked_id);
+    REQUIRE(checked[5] == lookup_rendered_id(9999U).checked_id);
+
+    // The entries of failed ids are left untouched.
+    REQUIRE(checked[2] == checked_asset_id_t{});
+}
+
+TEST_CASE("render_lines and encode_pngs agree with the id table for numeric ids")
+{
+    std::uint32_t const ids[] = {1337U, 10000U, 42U};
+    constexpr auto const num_ids = sizeof(ids) / sizeof(ids[0]);
+
+    image_line_t lines[num_ids]{};
+    encoded_png_t pngs[num_ids]{};
+    item_status line_statuses[num_ids]{};
+    item_status png_statuses[num_ids]{};
+
+    require_silent_and_allocation_free([&]() {
+        REQUIRE(render_lines(ids, num_ids, lines, line_statuses) == 2U);
+        REQUIRE(encode_pngs(ids, num_ids, pngs, png_statuses) == 2U);
+    });
+
+    for (auto const* const statuses: {line_statuses, png_statuses})
+    {
+        REQUIRE(statuses[0] == item_status::ok);
+        REQUIRE(statuses[1] == item_status::out_of_range);
+        REQUIRE(statuses[2] == item_status::ok);
+    }
+
+    REQUIRE(lines[0] == lookup_rendered_id(1337U).pixels);
+    REQUIRE(lines[2] == lookup_rendered_id(42U).pixels);
+    REQUIRE(pngs[0] == encode_png(lookup_rendered_id(1337U).pixels));
+    REQUIRE(pngs[2] == encode_png(lookup_rendered_id(42U).pixels));
+}
+
+TEST_CASE("the string and numeric forms of the batch functions agree")
+{
+    std::string_view const strings[] = {"0001", "4321"};
+    std::uint32_t const numbers[] = {1U, 4321U};
+
+    encoded_png_t from_strings[2]{};
+    encoded_png_t from_numbers[2]{};
+    item_status statuses[2]{};
+
+    REQUIRE(encode_pngs(strings, 2U, from_strings, statuses) == 2U);
+    REQUIRE(encode_pngs(numbers, 2U, from_numbers, statuses) == 2U);
+    REQUIRE(from_strings[0] == from_numbers[0]);
+    REQUIRE(from_strings[1] == from_numbers[1]);
+}
@@ -0,0 +1,603 @@
+#include <algorithm>
+#include <array>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "png_encoder.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that builds an input holding a mix of valid and invalid ids, long
+ * enough to span several chunks.
+ */
+std::string make_input(std::vector<batch_failure>& expected_failures)
+{
+    std::ostringstream input;
+    auto line_number = std::size_t{0U};
+    for (auto value = 0U; value < 10000U; value += 7U)
+    {
+        input << std::setw(4) << std::setfill('0') << value << "\n";
+        ++line_number;
+        if (value % 91U == 0U)
+        {
+            auto const bad = "x" + std::to_string(value);
+            auto const error = (bad.size() == 4U) ? error_code::bad_digit : error_code::bad_length;
+            expected_failures.push_back({++line_number, bad, error});
+            input << bad << "\n";
+        }
+    }
+    return input.str();
+}
+
+/**
+ * @brief A test sink that is not concurrent; it records the order in which it receives files
+ * and fails every file whose stem is in `rejected`.
+ */
+class recording_sink final : public output_sink
+{
+public:
+    void write(output_item* items, std::size_t num_items) override
+    {
+        for (auto index = std::size_t{0U}; index < num_items; ++index)
+        {
+            received.emplace_back(items[index].file_stem);
+            items[index].written = (rejected.count(received.back()) == 0U);
+            items[index].error = error_code::io_error;
+        }
+    }
+
+    bool is_concurrent() const override { return false; }
+
+    std::set<std::string> rejected;
+    std::vector<std::string> received;
+};
+
+/**
+ * @brief A test sink that is not concurrent and wants the builtin encoding; it counts the files
+ * received in input order whose encoding was filled in correctly by the batch.
+ */
+class encoded_sink final : public output_sink
+{
+public:
+    void write(output_item* items, std::size_t num_items) override
+    {
+        for (auto index = std::size_t{0U}; index < num_items; ++index)
+        {
+            auto const& item = items[index];
+            auto const expected_stem = std::to_string(10000U + num_received % 10000U).substr(1U);
+            auto const matches = item.encoded && (item.file_stem == expected_stem) &&
+                                 (*item.encoded == encode_png(item.rendered->pixels));
+            num_correct += matches ? 1U : 0U;
+            ++num_received;
+            items[index].written = true;
+        }
+    }
+
+    bool is_concurrent() const override { return false; }
+
+    bool wants_encoded() const override { return true; }
+
+    std::size_t num_received = 0U;
+    std::size_t num_correct = 0U;
+};
+
+/**
+ * @brief A test sink that is not concurrent and defers every file; it settles them in groups
+ * of `group_size`, as a sheet sink does, failing the group numbered `failed_group`.
+ */
+class deferring_sink final : public output_sink
+{
+public:
+    void write(output_item* items, std::size_t num_items) override
+    {
+        for (auto index = std::size_t{0U}; index < num_items; ++index)
+        {
+            items[index].deferred = true;
+            if (++_num_deferred == group_size)
+            {
+                settle_all();
+            }
+        }
+    }
+
+    bool is_concurrent() const override { return false; }
+
+    void take_settled(std::vector<deferred_outcome>& outcomes) override
+    {
+        outcomes.insert(outcomes.end(), _settled.begin(), _settled.end());
+        _settled.clear();
+    }
+
+    void settle_all() override
+    {
+        if (_num_deferred > 0U)
+        {
+            auto const written = (_settled_groups++ != failed_group);
+            _settled.push_back({_num_deferred, written, error_code::io_error});
+            _num_deferred = 0U;
+        }
+    }
+
+    static constexpr auto const group_size = std::size_t{3U};
+    std::size_t failed_group = 1U;
+
+private:
+    std::size_t _num_deferred = 0U;
+    std::size_t _settled_groups = 0U;
+    std::vector<deferred_outcome> _settled;
+};
+} // namespace
+
+TEST_CASE("process_batch reports failures in input order")
+{
+    auto const dir = make_temp_dir("batch_order");
+
+    auto const input = std::string_view{"1234\n12a4\n59)\n7890\n\n-6\n"};
+    auto settings = options{};
+    settings.output_dir = dir;
+    settings.jobs = 4U;
+
+    auto sink = directory_sink{dir, png_backend::builtin};
+    auto const summary = process_batch(input, settings, sink);
+
+    REQUIRE(
+        summary.failures == std::vector<batch_failure>{
+                                {2, "12a4", error_code::bad_digit},
+                                {3, "59)", error_code::bad_length},
+                                {5, "", error_code::bad_length},
+                                {6, "-6", error_code::bad_length},
+                            }
+    );
+    REQUIRE(std::filesystem::exists(dir / "1234.png"));
+    REQUIRE(std::filesystem::exists(dir / "7890.png"));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("process_batch produces the same files and failures for any number of jobs")
+{
+    auto expected_failures = std::vector<batch_failure>{};
+    auto const text = make_input(expected_failures);
+
+    auto const serial_dir = make_temp_dir("batch_serial");
+    auto const parallel_dir = make_temp_dir("batch_parallel");
+
+    auto serial_settings = options{};
+    serial_settings.output_dir = serial_dir;
+    serial_settings.jobs = 1U;
+
+    auto parallel_settings = options{};
+    parallel_settings.output_dir = parallel_dir;
+    parallel_settings.jobs = 8U;
+
+    auto serial_sink = directory_sink{serial_dir, png_backend::builtin};
+    auto parallel_sink = directory_sink{parallel_dir, png_backend::builtin};
+
+    REQUIRE(process_batch(text, serial_settings, serial_sink).failures == expected_failures);
+    REQUIRE(process_batch(text, parallel_settings, parallel_sink).failures == expected_failures);
+
+    auto num_files = 0U;
+    for (auto const& entry: std::filesystem::directory_iterator(serial_dir))
+    {
+        auto const parallel_file = parallel_dir / entry.path().filename();
+        REQUIRE(std::filesystem::exists(parallel_file));
+        REQUIRE(read_file(entry.path()) == read_file(parallel_file));
+        ++num_files;
+    }
+    REQUIRE(num_files == 1429U);
+
+    std::filesystem::remove_all(serial_dir);
+    std::filesystem::remove_all(parallel_dir);
+}
+
+TEST_CASE("process_batch hands a sink that is not concurrent every file in input order")
+{
+    auto expected_failures = std::vector<batch_failure>{};
+    auto const text = make_input(expected_failures);
+
+    auto settings = options{};
+    settings.jobs = 8U;
+
+    auto sink = recording_sink{};
+    sink.rejected = {"0007", "9996"};
+
+    auto const failures = process_batch(text, settings, sink).failures;
+
+    REQUIRE(sink.received.size() == 1429U);
+    for (auto index = std::size_t{0U}; index < sink.received.size(); ++index)
+    {
+        REQUIRE(sink.received[index] == std::to_string(10000U + 7U * index).substr(1U));
+    }
+
+    // The rejected files are reported in input order alongside the malformed lines.
+    REQUIRE(failures.size() == expected_failures.size() + 2U);
+    REQUIRE(failures[1] == batch_failure{3, "0007", error_code::io_error});
+    REQUIRE(failures.back() == batch_failure{1539, "9996", error_code::io_error});
+}
+
+TEST_CASE("process_batch encodes files for the sink and keeps their order past its queues")
+{
+    // Far more ids than the pipeline holds at once, so the reader waits on the writer many
+    // times over.
+    std::string text{};
+    for (auto pass = 0U; pass < 5U; ++pass)
+    {
+        for (auto number = 0U; number < num_asset_ids(); ++number)
+        {
+            text += std::to_string(10000U + number).substr(1U) + "\n";
+        }
+    }
+
+    auto settings = options{};
+    settings.jobs = 4U;
+    settings.dedup = false;
+
+    auto sink = encoded_sink{};
+    auto const summary = process_batch(text, settings, sink);
+
+    REQUIRE(summary.written == 5U * num_asset_ids());
+    REQUIRE(sink.num_received == 5U * num_asset_ids());
+    REQUIRE(sink.num_correct == sink.num_received);
+}
+
+TEST_CASE("process_batch skips repeated ids unless deduplication is disabled")
+{
+    auto const input = std::string_view{"1337\n0042\n1337\nabcd\n0042\nabcd\n1337\n7\n"};
+
+    auto settings = options{};
+    settings.jobs = 2U;
+
+    auto dedup_sink = recording_sink{};
+    auto const dedup = process_batch(input, settings, dedup_sink);
+
+    REQUIRE(dedup.duplicates == 3U);
+    REQUIRE(dedup_sink.received == std::vector<std::string>{"1337", "0042"});
+
+    // Malformed lines are never treated as duplicates.
+    REQUIRE(
+        dedup.failures == std::vector<batch_failure>{
+                              {4, "abcd", error_code::bad_digit},
+                              {6, "abcd", error_code::bad_digit},
+                              {8, "7", error_code::bad_length},
+                          }
+    );
+
+    settings.dedup = false;
+
+    auto all_sink = recording_sink{};
+    auto const all = process_batch(input, settings, all_sink);
+
+    REQUIRE(all.duplicates == 0U);
+    REQUIRE(all_sink.received.size() == 5U);
+    REQUIRE(all.failures == dedup.failures);
+}
+
+TEST_CASE("process_batch reports the repeats of an id that could not be written")
+{
+    auto const input = std::string_view{"0001\n0002\n0001\n0003\n0002\n0001\n"};
+
+    auto settings = options{};
+    settings.jobs = 2U;
+
+    // The output directory lies below a regular file, so no file can be written to it.
+    auto const blocker = unique_temp_path("batch_unwritable");
+    {
+        auto file = std::ofstream{blocker};
+    }
+    auto directory = directory_sink{blocker / "out", png_backend::builtin};
+    auto stream = std::ostringstream{};
+    auto const unwritable = process_batch(input, settings, directory, &stream);
+    std::filesystem::remove(blocker);
+
+    REQUIRE(unwritable.num_failures == 6U);
+    REQUIRE(unwritable.duplicates == 0U);
+    REQUIRE(
+        stream.str() == "1\tio_error\t0001\n2\tio_error\t0002\n3\tio_error\t0001\n"
+                        "4\tio_error\t0003\n5\tio_error\t0002\n6\tio_error\t0001\n"
+    );
+
+    // Only the repeats of a rejected id fail.
+    auto recording = recording_sink{};
+    recording.rejected = {"0002"};
+    auto const rejected = process_batch(input, settings, recording);
+    REQUIRE(recording.received == std::vector<std::string>{"0001", "0002", "0003"});
+    REQUIRE(rejected.written == 2U);
+    REQUIRE(rejected.duplicates == 2U);
+    REQUIRE(
+        rejected.failures == std::vector<batch_failure>{
+                                 {2, "0002", error_code::io_error},
+                                 {5, "0002", error_code::io_error},
+                             }
+    );
+
+    // A repeat of a deferred id waits until the id is settled; the first group fails here.
+    auto deferring = deferring_sink{};
+    deferring.failed_group = 0U;
+    auto const deferred = process_batch(input, settings, deferring);
+    REQUIRE(deferred.written == 0U);
+    REQUIRE(deferred.duplicates == 0U);
+    REQUIRE(deferred.num_failures == 6U);
+    REQUIRE(deferred.failures.size() == 6U);
+    REQUIRE(deferred.failures[2] == batch_failure{3, "0001", error_code::io_error});
+}
+
+TEST_CASE("process_batch counts the failures of each error code")
+{
+    auto expected_failures = std::vector<batch_failure>{};
+    auto const text = make_input(expected_failures);
+
+    auto settings = options{};
+    settings.jobs = 4U;
+
+    auto sink = recording_sink{};
+    sink.rejected = {"0007", "0014", "9996"};
+
+    auto const summary = process_batch(text, settings, sink);
+
+    auto expected_counts = std::array<std::size_t, num_error_codes>{};
+    for (auto const& failure: expected_failures)
+    {
+        ++expected_counts[static_cast<std::size_t>(failure.error)];
+    }
+    expected_counts[static_cast<std::size_t>(error_code::io_error)] += sink.rejected.size();
+
+    REQUIRE(summary.failures_by_error == expected_counts);
+    REQUIRE(expected_counts[static_cast<std::size_t>(error_code::bad_digit)] > 0U);
+    REQUIRE(expected_counts[static_cast<std::size_t>(error_code::bad_length)] > 0U);
+}
+
+TEST_CASE("process_range hands a sink that is not concurrent every id in the range in order")
+{
+    auto settings = options{};
+    settings.jobs = 8U;
+
+    auto sink = recording_sink{};
+    sink.rejected = {"0995", "9999"};
+
+    auto const summary = process_range(id_range{995U, 9999U}, settings, sink);
+
+    REQUIRE(sink.received.size() == 9005U);
+    for (auto index = std::size_t{0U}; index < sink.received.size(); ++index)
+    {
+        REQUIRE(sink.received[index] == std::to_string(10995U + index).substr(1U));
+    }
+
+    REQUIRE(
+        summary.failures == std::vector<batch_failure>{
+                                {1, "0995", error_code::io_error},
+                                {9005, "9999", error_code::io_error},
+                            }
+    );
+    REQUIRE(summary.failures_by_error[static_cast<std::size_t>(error_code::io_error)] == 2U);
+    REQUIRE(summary.written == 9003U);
+    REQUIRE(summary.duplicates == 0U);
+}
+
+TEST_CASE("process_range writes the same files as process_batch for any number of jobs")
+{
+    auto const batch_dir = make_temp_dir("batch_range_batch");
+    auto settings = options{};
+    settings.jobs = 1U;
+
+    std::ostringstream input;
+    for (auto value = 37U; value <= 5000U; ++value)
+    {
+        input << std::setw(4) << std::setfill('0') << value << "\n";
+    }
+    auto batch_sink = directory_sink{batch_dir, png_backend::builtin};
+    REQUIRE(process_batch(input.str(), settings, batch_sink).written == 4964U);
+
+    for (auto const jobs: {1U, 3U, 8U})
+    {
+        auto const range_dir = make_temp_dir("batch_range_" + std::to_string(jobs));
+        settings.jobs = jobs;
+
+        auto range_sink = directory_sink{range_dir, png_backend::builtin};
+        auto const summary = process_range(id_range{37U, 5000U}, settings, range_sink);
+        REQUIRE(summary.failures.empty());
+        REQUIRE(summary.written == 4964U);
+
+        auto num_files = 0U;
+        for (auto const& entry: std::filesystem::directory_iterator(range_dir))
+        {
+            auto const batch_file = batch_dir / entry.path().filename();
+            INFO("jobs " << jobs << ", file " << entry.path().filename());
+            REQUIRE(read_file(entry.path()) == read_file(batch_file));
+            ++num_files;
+        }
+        REQUIRE(num_files == 4964U);
+
+        std::filesystem::remove_all(range_dir);
+    }
+
+    std::filesystem::remove_all(batch_dir);
+}
+
+TEST_CASE("process_range generates a range holding a single id")
+{
+    auto settings = options{};
+    settings.jobs = 4U;
+
+    auto sink = recording_sink{};
+    auto const summary = process_range(id_range{42U, 42U}, settings, sink);
+
+    REQUIRE(sink.received == std::vector<std::string>{"0042"});
+    REQUIRE(summary.written == 1U);
+}
+
+TEST_CASE("process_batch keeps a sample of the failures and streams every one of them")
+{
+    auto expected_failures = std::vector<batch_failure>{};
+    auto const text = make_input(expected_failures);
+    REQUIRE(expected_failures.size() > 5U);
+
+    auto settings = options{};
+    settings.jobs = 4U;
+    settings.failure_samples = 5U;
+
+    auto sink = recording_sink{};
+    auto stream = std::ostringstream{};
+    auto const summary = process_batch(text, settings, sink, &stream);
+
+    REQUIRE(summary.num_failures == expected_failures.size());
+    REQUIRE(
+        summary.failures ==
+        std::vector<batch_failure>(expected_failures.begin(), expected_failures.begin() + 5)
+    );
+
+    auto expected_stream = std::ostringstream{};
+    for (auto const& failure: expected_failures)
+    {
+        expected_stream << failure.line_number << '\t' << to_string(failure.error) << '\t'
+                        << failure.text << '\n';
+    }
+    REQUIRE(stream.str() == expected_stream.str());
+}
+
+TEST_CASE("process_range samples and streams its failures in range order")
+{
+    auto settings = options{};
+    settings.jobs = 1U;
+    settings.failure_samples = 1U;
+
+    auto sink = recording_sink{};
+    sink.rejected = {"0011", "0013"};
+
+    auto stream = std::ostringstream{};
+    auto const summary = process_range(id_range{10U, 20U}, settings, sink, &stream);
+
+    REQUIRE(summary.num_failures == 2U);
+    REQUIRE(summary.failures == std::vector<batch_failure>{{2, "0011", error_code::io_error}});
+    REQUIRE(stream.str() == "2\tio_error\t0011\n4\tio_error\t0013\n");
+    REQUIRE(summary.written == 9U);
+}
+
+TEST_CASE("process_batch shares out a job between shards that add up to a single run")
+{
+    auto expected_failures = std::vector<batch_failure>{};
+    auto text = make_input(expected_failures);
+    auto const num_lines = static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+    text += "0007\n0014\nabcd\n0007\n";
+    expected_failures.push_back({num_lines + 3U, "abcd", error_code::bad_digit});
+
+    auto settings = options{};
+    settings.jobs = 2U;
+    settings.failure_samples = 0U;
+
+    auto whole_sink = recording_sink{};
+    auto const whole = process_batch(text, settings, whole_sink);
+
+    auto merged = batch_summary{};
+    auto received = std::vector<std::string>{};
+    auto streamed = std::vector<std::string>{};
+    settings.shard.count = 3U;
+    for (auto index = 0U; index < settings.shard.count; ++index)
+    {
+        settings.shard.index = index;
+        auto sink = recording_sink{};
+        auto stream = std::ostringstream{};
+        auto const part = process_batch(text, settings, sink, &stream);
+
+        merged.num_failures += part.num_failures;
+        merged.duplicates += part.duplicates;
+        merged.written += part.written;
+        received.insert(received.end(), sink.received.begin(), sink.received.end());
+
+        auto line = std::string{};
+        auto lines = std::istringstream{stream.str()};
+        while (std::getline(lines, line))
+        {
+            streamed.push_back(line);
+        }
+    }
+
+    REQUIRE(merged.num_failures == expected_failures.size());
+    REQUIRE(merged.num_failures == whole.num_failures);
+    REQUIRE(merged.duplicates == whole.duplicates);
+    REQUIRE(merged.written == whole.written);
+
+    std::sort(received.begin(), received.end());
+    std::sort(whole_sink.received.begin(), whole_sink.received.end());
+    REQUIRE(received == whole_sink.received);
+
+    // Sorting the merged failures by line number, like `sort -n`, restores the input order.
+    std::sort(
+        streamed.begin(),
+        streamed.end(),
+        [](std::string const& left, std::string const& right)
+        { return std::stoul(left) < std::stoul(right); }
+    );
+    auto expected_stream = std::vector<std::string>{};
+    for (auto const& failure: expected_failures)
+    {
+        expected_stream.push_back(
+            std::to_string(failure.line_number) + '\t' + std::string{to_string(failure.error)} +
+            '\t' + failure.text
+        );
+    }
+    REQUIRE(streamed == expected_stream);
+}
+
+TEST_CASE("process_range shares out its ids between shards")
+{
+    auto settings = options{};
+    settings.jobs = 1U;
+    settings.shard = shard_spec{1U, 4U};
+
+    auto sink = recording_sink{};
+    sink.rejected = {"0013"};
+
+    auto stream = std::ostringstream{};
+    auto const summary = process_range(id_range{10U, 20U}, settings, sink, &stream);
+
+    REQUIRE(sink.received == std::vector<std::string>{"0013", "0017"});
+    REQUIRE(stream.str() == "4\tio_error\t0013\n");
+    REQUIRE(summary.written == 1U);
+}
+
+TEST_CASE("process_batch records deferred files once settled, keeping failures in input order")
+{
+    auto const input = std::string_view{"0001\n0002\nabcd\n0003\n0004\n0005\n7\n0006\n0007\n"};
+
+    auto settings = options{};
+    settings.jobs = 2U;
+
+    auto sink = deferring_sink{};
+    auto stream = std::ostringstream{};
+    auto const summary = process_batch(input, settings, sink, &stream);
+
+    // The second group, ids 4 to 6, fails once settled; id 7 is settled by the final flush.
+    REQUIRE(summary.written == 4U);
+    REQUIRE(
+        summary.failures == std::vector<batch_failure>{
+                                {3, "abcd", error_code::bad_digit},
+                                {5, "0004", error_code::io_error},
+                                {6, "0005", error_code::io_error},
+                                {7, "7", error_code::bad_length},
+                                {8, "0006", error_code::io_error},
+                            }
+    );
+    REQUIRE(
+        stream.str() ==
+        "3\tbad_digit\tabcd\n5\tio_error\t0004\n6\tio_error\t0005\n7\tbad_length\t7\n"
+        "8\tio_error\t0006\n"
+    );
+
+    auto range_sink = deferring_sink{};
+    range_sink.failed_group = 2U;
+    auto const range = process_range(id_range{10U, 16U}, settings, range_sink);
+    REQUIRE(range.written == 6U);
+    REQUIRE(range.failures == std::vector<batch_failure>{{7, "0016", error_code::io_error}});
+}
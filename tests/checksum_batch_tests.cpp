@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "checksum_batch.h"
+#include "id_table.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper holding every id, or a run of them, in structure-of-arrays layout.
+ */
+struct soa_block
+{
+    explicit soa_block(std::uint32_t const first, std::size_t const count)
+    {
+        for (auto position = std::size_t{0U}; position < asset_id_length; ++position)
+        {
+            digits[position].resize(count);
+        }
+        hi.resize(count);
+        lo.resize(count);
+
+        for (auto index = std::size_t{0U}; index < count; ++index)
+        {
+            auto remainder = static_cast<std::uint32_t>(first + index);
+            for (auto position = asset_id_length; position > 0U; --position)
+            {
+                digits[position - 1U][index] = static_cast<std::uint8_t>(remainder % 10U);
+                remainder /= 10U;
+            }
+        }
+    }
+
+    soa_ids ids() const
+    {
+        auto result = soa_ids{{}, hi.size()};
+        for (auto position = std::size_t{0U}; position < asset_id_length; ++position)
+        {
+            result.digits[position] = digits[position].data();
+        }
+        return result;
+    }
+
+    std::array<std::vector<std::uint8_t>, asset_id_length> digits;
+    std::vector<std::uint8_t> hi;
+    std::vector<std::uint8_t> lo;
+};
+
+/**
+ * @brief A test helper that checks the output of a kernel for the ids `first` onwards against
+ * `calculate_checksum`.
+ */
+void require_matches_calculate_checksum(soa_block const& block, std::uint32_t const first)
+{
+    for (auto index = std::size_t{0U}; index < block.hi.size(); ++index)
+    {
+        auto asset_id = asset_id_t{};
+        for (auto position = std::size_t{0U}; position < asset_id_length; ++position)
+        {
+            asset_id[position] = *digit::from_int(block.digits[position][index]);
+        }
+
+        auto const expected = calculate_checksum(asset_id, digit::base(), 97U);
+        REQUIRE(expected);
+        INFO("id " << first + index);
+        REQUIRE(block.hi[index] == (*expected)[0].value());
+        REQUIRE(block.lo[index] == (*expected)[1].value());
+    }
+}
+} // namespace
+
+TEST_CASE("Every supported checksum kernel matches calculate_checksum for all ids")
+{
+    REQUIRE(is_supported(simd_level::scalar));
+    REQUIRE(is_supported(best_simd_level()));
+
+    for (auto const level: supported_levels())
+    {
+        auto block = soa_block{0U, num_asset_ids()};
+        calculate_checksums(block.ids(), {block.hi.data(), block.lo.data()}, level);
+        require_matches_calculate_checksum(block, 0U);
+    }
+}
+
+TEST_CASE("Checksum kernels handle blocks that are not a multiple of the register width")
+{
+    for (auto const level: supported_levels())
+    {
+        for (auto const count: {0U, 1U, 15U, 17U, 31U, 33U, 63U})
+        {
+            auto block = soa_block{9900U, count};
+            calculate_checksums(block.ids(), {block.hi.data(), block.lo.data()}, level);
+            require_matches_calculate_checksum(block, 9900U);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "durability.h"
+#include "output_sink.h"
+#include "stats.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that opens a directory for as long as it exists.
+ */
+struct open_directory
+{
+    explicit open_directory(std::filesystem::path const& path):
+        fd(open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+    {
+    }
+
+    ~open_directory() { close(fd); }
+
+    int fd;
+};
+
+/**
+ * @brief A test helper that clears the stats when a test starts and ends, so that the syncs of
+ * each test can be counted.
+ */
+struct scoped_sync_count
+{
+    scoped_sync_count() { reset_stats(); }
+    ~scoped_sync_count() { reset_stats(); }
+
+    std::uint64_t syncs() const
+    {
+        return snapshot_stats().stages[static_cast<std::size_t>(stats_stage::sync)].calls;
+    }
+};
+} // namespace
+
+TEST_CASE("sync_schedule syncs once per interval in batch mode, and at the end")
+{
+    auto const counter = scoped_sync_count{};
+    auto const dir = open_directory{std::filesystem::temp_directory_path()};
+
+    auto schedule = sync_schedule{{durability_mode::batch, 3U}};
+    schedule.files_written(dir.fd, 2U);
+    REQUIRE(counter.syncs() == 0U);
+
+    schedule.files_written(dir.fd, 2U);
+    REQUIRE(counter.syncs() == 1U);
+
+    // Passing several multiples of the interval at once still takes a single sync.
+    schedule.files_written(dir.fd, 7U);
+    REQUIRE(counter.syncs() == 2U);
+
+    REQUIRE(schedule.finish(dir.fd));
+    REQUIRE(counter.syncs() == 3U);
+}
+
+TEST_CASE("sync_schedule leaves per-file syncs to the writer and never syncs without durability")
+{
+    auto const counter = scoped_sync_count{};
+    auto const dir = open_directory{std::filesystem::temp_directory_path()};
+
+    auto none = sync_schedule{{durability_mode::none, 1U}};
+    REQUIRE(!none.per_file());
+    none.files_written(dir.fd, 10U);
+    REQUIRE(none.finish(dir.fd));
+    REQUIRE(counter.syncs() == 0U);
+
+    auto per_file = sync_schedule{{durability_mode::per_file, 1U}};
+    REQUIRE(per_file.per_file());
+    per_file.files_written(dir.fd, 10U);
+    REQUIRE(counter.syncs() == 0U);
+    REQUIRE(per_file.finish(dir.fd));
+    REQUIRE(counter.syncs() == 1U);
+}
+
+TEST_CASE("sync_schedule reports a failed sync when the output is finished")
+{
+    auto const counter = scoped_sync_count{};
+
+    auto schedule = sync_schedule{{durability_mode::batch, 1U}};
+    schedule.files_written(-1, 1U);
+    REQUIRE(counter.syncs() == 1U);
+
+    auto const dir = open_directory{std::filesystem::temp_directory_path()};
+    REQUIRE(!schedule.finish(dir.fd));
+}
+
+TEST_CASE("directory_sink syncs every file and its directory entry in per-file mode")
+{
+    auto const counter = scoped_sync_count{};
+    auto const dir = make_temp_dir("durability");
+
+    auto const stems = std::vector<std::string>{"1337", "0042", "0001"};
+    std::vector<output_item> items{};
+    for (auto const& stem: stems)
+    {
+        items.push_back({stem, &lookup_rendered_id(*create_asset_id(stem)), false, false});
+    }
+
+    auto sink = directory_sink{dir, png_backend::builtin, false, {durability_mode::per_file, 1U}};
+    sink.write(items.data(), items.size());
+    for (auto const& item: items)
+    {
+        REQUIRE(item.written);
+    }
+    REQUIRE(counter.syncs() == 2U * stems.size());
+
+    REQUIRE(sink.finish());
+    REQUIRE(counter.syncs() == 2U * stems.size() + 1U);
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,274 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <filesystem>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "http_server.h"
+#include "id_table.h"
+#include "png_encoder.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+std::string png_body(std::string_view const id)
+{
+    auto const asset_id = create_asset_id(id);
+    REQUIRE(asset_id);
+    auto const encoded = encode_png(lookup_rendered_id(*asset_id).pixels);
+    return std::string(encoded.begin(), encoded.end());
+}
+
+/**
+ * @brief A test helper that sends `request` over `fd` and reads until the server closes the
+ * connection.
+ */
+std::string exchange(int const fd, std::string const& request)
+{
+    REQUIRE(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()));
+
+    std::string response{};
+    char buffer[4096];
+    auto num_read = ssize_t{0};
+    while ((num_read = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    {
+        response.append(buffer, static_cast<std::size_t>(num_read));
+    }
+
+    close(fd);
+    return response;
+}
+} // namespace
+
+TEST_CASE("parse_listen_address accepts tcp addresses and unix socket paths")
+{
+    auto const any = parse_listen_address(":8080");
+    REQUIRE(any);
+    REQUIRE(any->host.empty());
+    REQUIRE(any->port == 8080U);
+    REQUIRE(any->unix_path.empty());
+
+    auto const loopback = parse_listen_address("127.0.0.1:0");
+    REQUIRE(loopback);
+    REQUIRE(loopback->host == "127.0.0.1");
+    REQUIRE(loopback->port == 0U);
+
+    auto const unix_socket = parse_listen_address("./asset_id.sock");
+    REQUIRE(unix_socket);
+    REQUIRE(unix_socket->unix_path == "./asset_id.sock");
+
+    REQUIRE(!parse_listen_address("localhost"));
+    REQUIRE(!parse_listen_address("localhost:"));
+    REQUIRE(!parse_listen_address("localhost:http"));
+    REQUIRE(!parse_listen_address("localhost:65536"));
+}
+
+TEST_CASE("http_response_cache answers png targets and rejects anything else")
+{
+    auto cache = http_response_cache{};
+
+    auto output = std::string{};
+    REQUIRE(cache.respond("/1337.png", true, output));
+    REQUIRE(output ==
+            "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 101\r\n\r\n" +
+                png_body("1337"));
+
+    // A second request is served from the cache; closing adds the header before the body.
+    output.clear();
+    REQUIRE(cache.respond("/1337.png?size=1", false, output));
+    REQUIRE(output == "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 101\r\n"
+                      "Connection: close\r\n\r\n" +
+                          png_body("1337"));
+
+    for (auto const* const target:
+         {"/", "/12.png", "/12345.png", "/abcd.png", "/1337.gif", "1337.png"})
+    {
+        output.clear();
+        REQUIRE(!cache.respond(target, true, output));
+        REQUIRE(output == "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+}
+
+TEST_CASE("http_server answers pipelined requests over tcp until asked to close")
+{
+    auto const server = http_server::open({"127.0.0.1", 0U, ""});
+    REQUIRE(server);
+    REQUIRE(server->port() != 0U);
+
+    // Catch2 assertions are not thread safe, so the outcome of `run` is checked after joining.
+    auto stopped = false;
+    auto runner = std::thread{[&server, &stopped]() { stopped = server->run(); }};
+
+    auto const fd = socket(AF_INET, SOCK_STREAM, 0);
+    auto address = sockaddr_in{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server->port());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == 0);
+
+    auto const response = exchange(
+        fd,
+        "GET /1337.png HTTP/1.1\r\nHost: test\r\n\r\n"
+        "POST /1337.png HTTP/1.1\r\nHost: test\r\n\r\n"
+        "GET /0000.png HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n"
+        "GET /9999.png HTTP/1.1\r\nHost: test\r\n\r\n"
+    );
+
+    // The request after `Connection: close` is never answered.
+    REQUIRE(response ==
+            "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 101\r\n\r\n" +
+                png_body("1337") +
+                "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\n\r\n"
+                "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 101\r\n"
+                "Connection: close\r\n\r\n" +
+                png_body("0000"));
+
+    server->stop();
+    runner.join();
+    REQUIRE(stopped);
+}
+
+TEST_CASE("http_server closes a connection after a request with a body")
+{
+    auto const server = http_server::open({"127.0.0.1", 0U, ""});
+    REQUIRE(server);
+
+    // Catch2 assertions are not thread safe, so the outcome of `run` is checked after joining.
+    auto stopped = false;
+    auto runner = std::thread{[&server, &stopped]() { stopped = server->run(); }};
+
+    auto const connect_client = [&server]()
+    {
+        auto const fd = socket(AF_INET, SOCK_STREAM, 0);
+        auto address = sockaddr_in{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(server->port());
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == 0);
+        return fd;
+    };
+
+    // The bodies look like requests of their own and must not be answered as such.
+    auto const smuggled = std::string{"GET /0000.png HTTP/1.1\r\nHost: test\r\n\r\n"};
+    auto const sized = exchange(
+        connect_client(),
+        "POST /1337.png HTTP/1.1\r\nHost: test\r\nContent-Length: " +
+            std::to_string(smuggled.size()) + "\r\n\r\n" + smuggled +
+            "GET /9999.png HTTP/1.1\r\nHost: test\r\n\r\n"
+    );
+    REQUIRE(sized == "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\n"
+                     "Connection: close\r\n\r\n");
+
+    auto const chunked = exchange(
+        connect_client(),
+        "GET /1337.png HTTP/1.1\r\nHost: test\r\nTransfer-Encoding: chunked\r\n\r\n" +
+            smuggled + "GET /9999.png HTTP/1.1\r\nHost: test\r\n\r\n"
+    );
+    REQUIRE(chunked == "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 101\r\n"
+                       "Connection: close\r\n\r\n" +
+                           png_body("1337"));
+
+    server->stop();
+    runner.join();
+    REQUIRE(stopped);
+}
+
+TEST_CASE("http_server serves HTTP/1.0 requests over a unix socket")
+{
+    auto const path = unique_temp_path("http_tests.sock").string();
+    auto server = http_server::open({"", 0U, path});
+    REQUIRE(server);
+
+    // Catch2 assertions are not thread safe, so the outcome of `run` is checked after joining.
+    auto stopped = false;
+    auto runner = std::thread{[&server, &stopped]() { stopped = server->run(); }};
+
+    auto const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == 0);
+
+    auto const response = exchange(fd, "GET /0042.png HTTP/1.0\r\n\r\n");
+    REQUIRE(response == "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 101\r\n"
+                        "Connection: close\r\n\r\n" +
+                            png_body("0042"));
+
+    server->stop();
+    runner.join();
+    REQUIRE(stopped);
+
+    server.reset();
+    REQUIRE(!std::filesystem::exists(path));
+}
+
+TEST_CASE("http_server stops reading from a client that does not read its answers")
+{
+    auto const path = unique_temp_path("http_backlog.sock").string();
+    auto server = http_server::open({"", 0U, path});
+    REQUIRE(server);
+
+    auto stopped = false;
+    auto runner = std::thread{[&server, &stopped]() { stopped = server->run(); }};
+
+    auto const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == 0);
+
+    // Far more requests than fit in the socket buffers once the server stops taking them, and
+    // answers worth several times its cap of pending output.
+    constexpr auto const num_requests = 30000U;
+    auto requests = std::string{};
+    for (auto index = 0U; index < num_requests; ++index)
+    {
+        auto const last = (index + 1U == num_requests);
+        requests += "GET /" + std::to_string(1000U + index % 9000U) + ".png HTTP/1.1\r\n";
+        requests += last ? "Connection: close\r\n\r\n" : "Host: test\r\n\r\n";
+    }
+
+    std::atomic<bool> sent{false};
+    auto sent_all = false;
+    auto sender = std::thread{[fd, &requests, &sent, &sent_all]() {
+        sent_all = send(fd, requests.data(), requests.size(), 0) ==
+                   static_cast<ssize_t>(requests.size());
+        sent.store(true);
+    }};
+
+    // The server must stop reading once the answers pile up, so the sender stays blocked until
+    // the client starts reading.
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+    CHECK(!sent.load());
+
+    auto num_responses = 0U;
+    auto response = std::string{};
+    char buffer[65536];
+    auto num_read = ssize_t{0};
+    while ((num_read = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    {
+        response.append(buffer, static_cast<std::size_t>(num_read));
+    }
+    for (auto position = response.find("HTTP/1.1 200 OK"); position != std::string::npos;
+         position = response.find("HTTP/1.1 200 OK", position + 1U))
+    {
+        ++num_responses;
+    }
+    sender.join();
+    close(fd);
+
+    REQUIRE(sent_all);
+    REQUIRE(num_responses == num_requests);
+
+    server->stop();
+    runner.join();
+    REQUIRE(stopped);
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <string>
+
+#include "id_table.h"
+#include "image_line.h"
+
+using namespace asset_id;
+
+namespace
+{
+/**
+ * @brief An 8 digit id family, drawn on the same 256 pixel line as the default geometry.
+ */
+using eight_digit_geometry = id_geometry<8U, 2U, 97U, 32U, 1U>;
+
+/**
+ * @brief A 6 digit id family with a 3 digit checksum, drawn on a 512 pixel line.
+ */
+using wide_geometry = id_geometry<6U, 3U, 997U, 64U, 4U>;
+
+/**
+ * @brief A test helper that calculates a checksum the long way, one digit at a time.
+ */
+template<typename Geometry>
+std::uint64_t expected_checksum(std::string const& text)
+{
+    auto sum = std::uint64_t{0U};
+    auto weight = std::uint64_t{1U};
+    for (auto const character: text)
+    {
+        sum += weight * static_cast<std::uint64_t>(character - '0');
+        weight *= 10U;
+    }
+    return sum % Geometry::checksum_base;
+}
+
+template<typename Geometry>
+std::uint64_t checksum_value(typename Geometry::checked_id_t const& checked_id)
+{
+    auto value = std::uint64_t{0U};
+    for (auto index = 0U; index < Geometry::checksum_length; ++index)
+    {
+        value = value * 10U + checked_id[index].value();
+    }
+    return value;
+}
+
+// The generic functions can be evaluated entirely at compile time.
+constexpr auto const compile_time_line = create_line<eight_digit_geometry>(
+    create_checked_id<eight_digit_geometry>(*create_id<eight_digit_geometry>("00000001"))
+);
+static_assert(compile_time_line[0] == 0U);
+static_assert(compile_time_line[1 + 2 + 7] == pixels_per_digit[1]);
+} // namespace
+
+TEST_CASE("The default geometry matches the functions used by the tool for every id")
+{
+    for (auto number = 0U; number < num_asset_ids(); ++number)
+    {
+        auto const& rendered = lookup_rendered_id(number);
+        auto asset_id = asset_id_t{};
+        for (auto index = 0U; index < asset_id_length; ++index)
+        {
+            asset_id[index] = rendered.checked_id[checksum_length + index];
+        }
+
+        INFO("id " << number);
+        REQUIRE(to_number<default_geometry>(asset_id) == number);
+        REQUIRE(create_checked_id<default_geometry>(asset_id) == rendered.checked_id);
+        REQUIRE(create_line<default_geometry>(rendered.checked_id) == rendered.pixels);
+    }
+}
+
+TEST_CASE("An 8 digit geometry parses, checks and renders its ids")
+{
+    REQUIRE(create_id<eight_digit_geometry>("1234").error() == error_code::bad_length);
+    REQUIRE(create_id<eight_digit_geometry>("1234567a").error() == error_code::bad_digit);
+
+    for (auto const text: {"00000000", "12345678", "99999999", "31415926"})
+    {
+        auto const id = create_id<eight_digit_geometry>(text);
+        REQUIRE(id);
+        REQUIRE(to_number<eight_digit_geometry>(*id) == std::stoull(text));
+
+        auto const checked_id = create_checked_id<eight_digit_geometry>(*id);
+        INFO("id " << text);
+        REQUIRE(checksum_value<eight_digit_geometry>(checked_id) ==
+                expected_checksum<eight_digit_geometry>(text));
+
+        auto const line = create_line<eight_digit_geometry>(checked_id);
+        REQUIRE(line[0] == 0U);
+        for (auto index = 0U; index < eight_digit_geometry::checked_id_length; ++index)
+        {
+            REQUIRE(line[1U + index] == pixels_per_digit[checked_id[index].value()]);
+        }
+        REQUIRE(line[1U + eight_digit_geometry::checked_id_length] == 0U);
+    }
+}
+
+TEST_CASE("A wide geometry renders its digits from its own start byte")
+{
+    static_assert(wide_geometry::line_width_pixels == 512U);
+
+    auto const id = create_id<wide_geometry>("987654");
+    REQUIRE(id);
+
+    auto const checked_id = create_checked_id<wide_geometry>(*id);
+    REQUIRE(checksum_value<wide_geometry>(checked_id) ==
+            expected_checksum<wide_geometry>("987654"));
+
+    auto const line = create_line<wide_geometry>(checked_id);
+    REQUIRE(line.size() == 64U);
+    for (auto index = 0U; index < line.size(); ++index)
+    {
+        auto const in_digits = (index >= 4U) && (index < 4U + wide_geometry::checked_id_length);
+        auto const expected = in_digits ? pixels_per_digit[checked_id[index - 4U].value()] : 0U;
+        INFO("byte " << index);
+        REQUIRE(line[index] == expected);
+    }
+}
@@ -0,0 +1,57 @@
+#include <catch2/catch.hpp>
+
+#include "id_table.h"
+#include "write_png.h"
+
+using namespace asset_id;
+
+// These are evaluated by the compiler; a failure here stops the tests building.
+static_assert(digit::from_char('7')->value() == 7U);
+static_assert(
+    to_number(asset_id_t{
+        *digit::from_int(1), *digit::from_int(3), *digit::from_int(3), *digit::from_int(7)
+    }) == 1337U
+);
+static_assert(num_asset_ids() == 10000U);
+
+TEST_CASE("Checksum is usable in constant expressions")
+{
+    constexpr auto asset_id = asset_id_t{
+        *digit::from_int(1), *digit::from_int(3), *digit::from_int(3), *digit::from_int(7)
+    };
+    constexpr auto checksum = calculate_checksum(asset_id, 10U, 97U);
+    static_assert(checksum);
+    static_assert((*checksum)[0].value() == 5U && (*checksum)[1].value() == 6U);
+
+    constexpr auto checked = create_checked_asset_id(asset_id);
+    static_assert(checked);
+
+    constexpr auto line = create_image_line(*checked, image_line_start_byte);
+    static_assert(line);
+    static_assert((*line)[image_line_start_byte] == pixels_per_digit[5]);
+
+    REQUIRE(checked);
+}
+
+TEST_CASE("Table lookup matches the runtime calculation for every id")
+{
+    for (auto number = 0U; number < num_asset_ids(); ++number)
+    {
+        auto id_string = std::to_string(number);
+        id_string.insert(0U, asset_id_length - id_string.size(), '0');
+
+        auto const asset_id = create_asset_id(id_string);
+        REQUIRE(asset_id);
+        REQUIRE(to_number(*asset_id) == number);
+
+        auto const checked = create_checked_asset_id(*asset_id);
+        REQUIRE(checked);
+
+        auto const line = create_image_line(*checked, image_line_start_byte);
+        REQUIRE(line);
+
+        auto const& rendered = lookup_rendered_id(*asset_id);
+        REQUIRE(rendered.checked_id == *checked);
+        REQUIRE(rendered.pixels == *line);
+    }
+}
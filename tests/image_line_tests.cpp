@@ -131,7 +131,7 @@ TEST_CASE("create_image_line injects the exptected bytes")
         REQUIRE(expected);
 
         auto const actual = (*line)[index + start_byte];
-        REQUIRE(actual == expected);
+        REQUIRE(actual == *expected);
     }
 }
 
@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "input_reader.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that scans a whole buffer, returning every record.
+ */
+std::vector<input_record>
+scan(std::string_view const buffer, simd_level const level = best_simd_level())
+{
+    std::vector<input_record> records{};
+    auto scanner = id_scanner{buffer, level};
+    auto record = input_record{};
+    while (scanner.next(record))
+    {
+        records.push_back(record);
+    }
+    return records;
+}
+
+/**
+ * @brief A test helper that splits a buffer with `std::getline`, the reference behaviour.
+ */
+std::vector<std::string> getline_split(std::string const& buffer)
+{
+    std::vector<std::string> lines{};
+    std::istringstream stream(buffer);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+} // namespace
+
+TEST_CASE("id_scanner splits lines exactly as std::getline does")
+{
+    auto const buffers = std::vector<std::string>{
+        "",
+        "\n",
+        "1337",
+        "1337\n",
+        "1337\n\n",
+        "\n\n1234\n",
+        "0000\n1111\n2222\n3333\n4444\n5555\n6666\n7777\n8888\n9999",
+        "12a4\n59)\n12\n-6566778\n1234\n7654\n7788\ner56\n",
+        "1234\r\n5678\r\n",
+    };
+
+    for (auto const level: supported_levels())
+    {
+        for (auto const& buffer: buffers)
+        {
+            auto const records = scan(buffer, level);
+            auto const lines = getline_split(buffer);
+            REQUIRE(records.size() == lines.size());
+
+            for (auto index = std::size_t{0U}; index < records.size(); ++index)
+            {
+                REQUIRE(records[index].line_number == index + 1U);
+                REQUIRE(records[index].text == lines[index]);
+                auto const expected = create_asset_id(lines[index]);
+                REQUIRE(records[index].id.has_value() == expected.has_value());
+                if (!expected)
+                {
+                    REQUIRE(records[index].id.error() == expected.error());
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("id_scanner decodes every well formed id with every supported SIMD kernel")
+{
+    std::ostringstream buffer;
+    for (auto value = 0U; value < 10000U; ++value)
+    {
+        buffer << std::setw(4) << std::setfill('0') << value << "\n";
+        if (value % 13U == 0U)
+        {
+            buffer << "bad" << value << "\n";
+        }
+    }
+
+    auto const text = buffer.str();
+    for (auto const level: supported_levels())
+    {
+        auto expected = 0U;
+        for (auto const& record: scan(text, level))
+        {
+            if (!record.id)
+            {
+                REQUIRE(record.text.substr(0U, 3U) == "bad");
+                continue;
+            }
+
+            REQUIRE(to_number(*record.id) == expected);
+            ++expected;
+        }
+        REQUIRE(expected == 10000U);
+    }
+}
+
+TEST_CASE("mapped_file maps the whole of a file, including an empty one")
+{
+    auto const path = unique_temp_path("input_reader_tests.txt");
+
+    {
+        auto stream = std::ofstream(path, std::ios::binary);
+        stream << "1337\n12a4";
+    }
+    auto const mapped = mapped_file::open(path);
+    REQUIRE(mapped);
+    REQUIRE(mapped->contents() == "1337\n12a4");
+
+    {
+        auto stream = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    }
+    auto const empty = mapped_file::open(path);
+    REQUIRE(empty);
+    REQUIRE(empty->contents().empty());
+
+    std::filesystem::remove(path);
+    REQUIRE(!mapped_file::open(path));
+}
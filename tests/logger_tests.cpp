@@ -0,0 +1,183 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+
+using namespace asset_id;
+
+namespace
+{
+/**
+ * @brief A test helper that restores the default log level when a test ends.
+ */
+struct scoped_log_level
+{
+    explicit scoped_log_level(log_level const level) { set_log_level(level); }
+    ~scoped_log_level() { set_log_level(default_log_level); }
+};
+
+/**
+ * @brief A test helper that captures everything written to `std::cout` while it exists.
+ */
+struct captured_cout
+{
+    captured_cout():
+        previous(std::cout.rdbuf(text.rdbuf()))
+    {
+    }
+
+    ~captured_cout() { std::cout.rdbuf(previous); }
+
+    std::ostringstream text;
+    std::streambuf* previous;
+};
+} // namespace
+
+TEST_CASE("parse_log_level accepts every level by name")
+{
+    REQUIRE(parse_log_level("debug") == log_level::debug);
+    REQUIRE(parse_log_level("info") == log_level::info);
+    REQUIRE(parse_log_level("warning") == log_level::warning);
+    REQUIRE(parse_log_level("error") == log_level::error);
+    REQUIRE(parse_log_level("off") == log_level::off);
+    REQUIRE(!parse_log_level("verbose"));
+    REQUIRE(!parse_log_level(""));
+}
+
+TEST_CASE("log_record formats text, characters and integers and truncates long messages")
+{
+    auto record = log_record{log_level::warning};
+    record.append("digit '");
+    record.append('7');
+    record.append("' value ");
+    record.append(std::uint8_t{7U});
+    record.append(' ');
+    record.append(-42);
+    REQUIRE(record.text() == "digit '7' value 7 -42");
+    REQUIRE(record.level() == log_level::warning);
+
+    auto long_record = log_record{log_level::error};
+    long_record.append(std::string(2U * log_record::capacity, 'x'));
+    REQUIRE(long_record.text() == std::string(log_record::capacity, 'x'));
+}
+
+TEST_CASE("log_message only writes messages at or above the current level")
+{
+    auto const level = scoped_log_level{log_level::warning};
+    auto const output = captured_cout{};
+
+    REQUIRE(!log_enabled(log_level::info));
+    REQUIRE(log_enabled(log_level::error));
+
+    log_message(log_level::info, "hidden");
+    log_message(log_level::warning, "shown ", 1);
+    log_message(log_level::error, "also shown");
+
+    set_log_level(log_level::off);
+    log_message(log_level::error, "hidden");
+
+    REQUIRE(output.text.str() == "shown 1\nalso shown\n");
+}
+
+TEST_CASE("log_drain writes every message from every thread, in order per thread")
+{
+    auto const level = scoped_log_level{log_level::debug};
+
+    // Several times the capacity of the ring, so that producers have to wait for the drain.
+    constexpr auto const num_threads = 4U;
+    constexpr auto const num_messages = 10000U;
+
+    auto output = std::ostringstream{};
+    {
+        auto const drain = log_drain{output};
+
+        std::vector<std::thread> producers{};
+        for (auto thread = 0U; thread < num_threads; ++thread)
+        {
+            producers.emplace_back([thread]() {
+                for (auto message = 0U; message < num_messages; ++message)
+                {
+                    log_message(log_level::debug, thread, " ", message);
+                }
+            });
+        }
+        for (auto& producer: producers)
+        {
+            producer.join();
+        }
+    }
+
+    std::vector<unsigned> next_message(num_threads, 0U);
+    auto lines = std::istringstream{output.str()};
+    auto thread = 0U;
+    auto message = 0U;
+    auto num_lines = 0U;
+    while (lines >> thread >> message)
+    {
+        REQUIRE(thread < num_threads);
+        REQUIRE(message == next_message[thread]);
+        ++next_message[thread];
+        ++num_lines;
+    }
+
+    REQUIRE(num_lines == num_threads * num_messages);
+}
+
+TEST_CASE("log_drain loses no message logged while it is being destroyed")
+{
+    auto const level = scoped_log_level{log_level::debug};
+    auto const cout = captured_cout{};
+
+    constexpr auto const num_threads = 4U;
+    constexpr auto const num_messages = 20000U;
+
+    // The producers keep logging while the drain stops; whatever it does not write goes
+    // straight to standard output afterwards.
+    auto output = std::ostringstream{};
+    auto drain = std::make_unique<log_drain>(output);
+    std::atomic<unsigned> num_started{0U};
+    std::vector<std::thread> producers{};
+    for (auto thread = 0U; thread < num_threads; ++thread)
+    {
+        producers.emplace_back([thread, &num_started]() {
+            for (auto message = 0U; message < num_messages; ++message)
+            {
+                log_message(log_level::debug, thread, " ", message);
+                if (message == 0U)
+                {
+                    num_started.fetch_add(1U);
+                }
+            }
+        });
+    }
+    while (num_started.load() < num_threads)
+    {
+        std::this_thread::yield();
+    }
+    drain.reset();
+    for (auto& producer: producers)
+    {
+        producer.join();
+    }
+
+    std::vector<unsigned> next_message(num_threads, 0U);
+    auto lines = std::istringstream{output.str() + cout.text.str()};
+    auto thread = 0U;
+    auto message = 0U;
+    auto num_lines = 0U;
+    while (lines >> thread >> message)
+    {
+        REQUIRE(thread < num_threads);
+        REQUIRE(message == next_message[thread]);
+        ++next_message[thread];
+        ++num_lines;
+    }
+
+    REQUIRE(num_lines == num_threads * num_messages);
+}
@@ -0,0 +1,308 @@
+#include <catch2/catch.hpp>
+
+#include "options.h"
+#include "sheet_sink.h"
+
+using namespace asset_id;
+
+TEST_CASE("parse_options accepts an input file and output directory")
+{
+    char const* const argv[] = {"asset_id", "data.txt", "out"};
+
+    auto const parsed = parse_options(3, argv);
+    REQUIRE(parsed);
+
+    REQUIRE(parsed->input_file == "data.txt");
+    REQUIRE(parsed->output_dir == "out");
+    REQUIRE(parsed->jobs == default_jobs());
+}
+
+TEST_CASE("parse_options accepts --jobs anywhere on the command line")
+{
+    char const* const before[] = {"asset_id", "--jobs", "3", "data.txt", "out"};
+    char const* const after[] = {"asset_id", "data.txt", "out", "--jobs", "5"};
+
+    auto const parsed_before = parse_options(5, before);
+    REQUIRE(parsed_before);
+    REQUIRE(parsed_before->jobs == 3U);
+    REQUIRE(parsed_before->input_file == "data.txt");
+
+    auto const parsed_after = parse_options(5, after);
+    REQUIRE(parsed_after);
+    REQUIRE(parsed_after->jobs == 5U);
+    REQUIRE(parsed_after->output_dir == "out");
+}
+
+TEST_CASE("parse_options rejects malformed job counts")
+{
+    char const* const zero[] = {"asset_id", "--jobs", "0", "data.txt", "out"};
+    char const* const text[] = {"asset_id", "--jobs", "two", "data.txt", "out"};
+    char const* const missing[] = {"asset_id", "data.txt", "out", "--jobs"};
+
+    REQUIRE(!parse_options(5, zero));
+    REQUIRE(!parse_options(5, text));
+    REQUIRE(!parse_options(4, missing));
+}
+
+TEST_CASE("parse_options rejects unknown options and wrong argument counts")
+{
+    char const* const unknown[] = {"asset_id", "--fast", "data.txt", "out"};
+    char const* const too_few[] = {"asset_id", "data.txt"};
+    char const* const too_many[] = {"asset_id", "data.txt", "out", "extra"};
+
+    REQUIRE(!parse_options(4, unknown));
+    REQUIRE(!parse_options(2, too_few));
+    REQUIRE(!parse_options(4, too_many));
+}
+
+TEST_CASE("parse_options enables deduplication unless --no-dedup is given")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const no_dedup[] = {"asset_id", "--no-dedup", "data.txt", "out"};
+
+    auto const parsed_plain = parse_options(3, plain);
+    REQUIRE(parsed_plain);
+    REQUIRE(parsed_plain->dedup);
+
+    auto const parsed_no_dedup = parse_options(4, no_dedup);
+    REQUIRE(parsed_no_dedup);
+    REQUIRE(!parsed_no_dedup->dedup);
+}
+
+TEST_CASE("parse_options accepts --incremental only when writing a directory of builtin pngs")
+{
+    char const* const incremental[] = {"asset_id", "--incremental", "data.txt", "out"};
+    char const* const archive[] = {"asset_id", "--incremental", "--archive", "a.tar", "data.txt"};
+
+    auto const parsed = parse_options(4, incremental);
+    REQUIRE(parsed);
+    REQUIRE(parsed->incremental);
+
+    REQUIRE(!parse_options(5, archive));
+}
+
+TEST_CASE("parse_options takes no positional arguments with --serve")
+{
+    char const* const serve[] = {"asset_id", "--serve", "127.0.0.1:8080"};
+    char const* const extra[] = {"asset_id", "--serve", "127.0.0.1:8080", "data.txt"};
+    char const* const bad_address[] = {"asset_id", "--serve", "8080"};
+
+    auto const parsed = parse_options(3, serve);
+    REQUIRE(parsed);
+    REQUIRE(parsed->serve);
+    REQUIRE(parsed->serve->port == 8080U);
+
+    REQUIRE(!parse_options(4, extra));
+    REQUIRE(!parse_options(3, bad_address));
+}
+
+TEST_CASE("parse_options rejects --serve with options that only apply to written files")
+{
+    char const* const direct[] = {"asset_id", "--serve", ":0", "--output-backend", "direct"};
+    char const* const uring[] = {"asset_id", "--serve", ":0", "--output-backend", "io_uring"};
+    char const* const durable[] = {"asset_id", "--serve", ":0", "--durability", "per-file"};
+    char const* const sharded[] = {"asset_id", "--serve", ":0", "--shard", "0/2"};
+
+    REQUIRE(parse_options(5, direct));
+    REQUIRE(!parse_options(5, uring));
+    REQUIRE(!parse_options(5, durable));
+    REQUIRE(!parse_options(5, sharded));
+}
+
+TEST_CASE("parse_options sets the log level from --quiet and --log-level")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const quiet[] = {"asset_id", "--quiet", "data.txt", "out"};
+    char const* const debug[] = {"asset_id", "--log-level", "debug", "data.txt", "out"};
+    char const* const unknown[] = {"asset_id", "--log-level", "loud", "data.txt", "out"};
+
+    REQUIRE(parse_options(3, plain)->log_threshold == default_log_level);
+    REQUIRE(parse_options(4, quiet)->log_threshold == log_level::error);
+    REQUIRE(parse_options(5, debug)->log_threshold == log_level::debug);
+    REQUIRE(!parse_options(5, unknown));
+}
+
+TEST_CASE("parse_options enables stats with --stats or --stats-file")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const stats[] = {"asset_id", "--stats", "data.txt", "out"};
+    char const* const file[] = {"asset_id", "data.txt", "out", "--stats-file", "stats.json"};
+    char const* const missing[] = {"asset_id", "data.txt", "out", "--stats-file"};
+
+    REQUIRE(!parse_options(3, plain)->stats);
+
+    auto const to_stdout = parse_options(4, stats);
+    REQUIRE(to_stdout);
+    REQUIRE(to_stdout->stats);
+    REQUIRE(to_stdout->stats_file.empty());
+
+    auto const to_file = parse_options(5, file);
+    REQUIRE(to_file);
+    REQUIRE(to_file->stats);
+    REQUIRE(to_file->stats_file == "stats.json");
+
+    REQUIRE(!parse_options(4, missing));
+}
+
+TEST_CASE("parse_options accepts --sheet only when writing a directory of builtin pngs")
+{
+    char const* const sheet[] = {"asset_id", "--sheet", "1000", "data.txt", "out"};
+    char const* const zero[] = {"asset_id", "--sheet", "0", "data.txt", "out"};
+    char const* const archive[] = {"asset_id", "--sheet", "10", "--archive", "a.tar", "data.txt"};
+    char const* const incremental[] = {"asset_id", "--sheet", "10", "--incremental", "d", "o"};
+
+    REQUIRE(!parse_options(5, zero));
+    REQUIRE(!parse_options(6, archive));
+    REQUIRE(!parse_options(6, incremental));
+
+    auto const parsed = parse_options(5, sheet);
+    REQUIRE(static_cast<bool>(parsed) == sheets_available());
+    if (parsed)
+    {
+        REQUIRE(parsed->sheet_rows == 1000U);
+    }
+}
+
+TEST_CASE("parse_options takes no input file with --range or --all")
+{
+    char const* const range[] = {"asset_id", "--range", "0100-0199", "out"};
+    char const* const all[] = {"asset_id", "--all", "--archive", "a.tar"};
+    char const* const reversed[] = {"asset_id", "--range", "200-100", "out"};
+    char const* const too_large[] = {"asset_id", "--range", "0-10000", "out"};
+    char const* const malformed[] = {"asset_id", "--range", "100", "out"};
+    char const* const with_input[] = {"asset_id", "--range", "1-2", "data.txt", "out"};
+    char const* const serve[] = {"asset_id", "--all", "--serve", "127.0.0.1:0"};
+
+    auto const parsed_range = parse_options(4, range);
+    REQUIRE(parsed_range);
+    REQUIRE(parsed_range->range);
+    REQUIRE(parsed_range->range->first == 100U);
+    REQUIRE(parsed_range->range->last == 199U);
+    REQUIRE(parsed_range->input_file.empty());
+    REQUIRE(parsed_range->output_dir == "out");
+
+    auto const parsed_all = parse_options(4, all);
+    REQUIRE(parsed_all);
+    REQUIRE(parsed_all->range->first == 0U);
+    REQUIRE(parsed_all->range->last == 9999U);
+    REQUIRE(parsed_all->output_dir.empty());
+
+    REQUIRE(!parse_options(4, reversed));
+    REQUIRE(!parse_options(4, too_large));
+    REQUIRE(!parse_options(4, malformed));
+    REQUIRE(!parse_options(5, with_input));
+    REQUIRE(!parse_options(4, serve));
+}
+
+TEST_CASE("parse_options reads where failures are streamed and how many are kept")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const failures[] = {
+        "asset_id", "--failures-file", "-", "--failure-samples", "3", "data.txt", "out"
+    };
+    char const* const zero[] = {"asset_id", "--failure-samples", "0", "data.txt", "out"};
+    char const* const missing[] = {"asset_id", "data.txt", "out", "--failures-file"};
+
+    auto const parsed_plain = parse_options(3, plain);
+    REQUIRE(parsed_plain->failures_file.empty());
+    REQUIRE(parsed_plain->failure_samples == default_failure_samples);
+
+    auto const parsed = parse_options(7, failures);
+    REQUIRE(parsed);
+    REQUIRE(parsed->failures_file == "-");
+    REQUIRE(parsed->failure_samples == 3U);
+
+    REQUIRE(!parse_options(5, zero));
+    REQUIRE(!parse_options(4, missing));
+}
+
+TEST_CASE("parse_options takes no positional arguments with --verify")
+{
+    char const* const verify[] = {"asset_id", "--verify", "out", "--jobs", "2"};
+    char const* const extra[] = {"asset_id", "--verify", "out", "data.txt"};
+    char const* const archive[] = {"asset_id", "--verify", "out", "--archive", "a.tar"};
+
+    auto const parsed = parse_options(5, verify);
+    REQUIRE(parsed);
+    REQUIRE(parsed->verify == std::filesystem::path{"out"});
+    REQUIRE(parsed->jobs == 2U);
+    REQUIRE(parsed->output_dir.empty());
+
+    REQUIRE(!parse_options(4, extra));
+    REQUIRE(!parse_options(5, archive));
+}
+
+TEST_CASE("parse_options reads the durability mode and sync interval")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const batch[] = {
+        "asset_id", "--durability", "batch", "--sync-interval", "100", "data.txt", "out"
+    };
+    char const* const per_file[] = {"asset_id", "--durability", "per-file", "data.txt", "out"};
+    char const* const unknown[] = {"asset_id", "--durability", "always", "data.txt", "out"};
+    char const* const zero[] = {"asset_id", "--sync-interval", "0", "data.txt", "out"};
+    char const* const to_stdout[] = {
+        "asset_id", "--durability", "batch", "--archive", "-", "data.txt"
+    };
+    char const* const verify[] = {"asset_id", "--durability", "batch", "--verify", "out"};
+
+    auto const parsed_plain = parse_options(3, plain);
+    REQUIRE(parsed_plain->durability.mode == durability_mode::none);
+    REQUIRE(parsed_plain->durability.sync_interval == default_sync_interval);
+
+    auto const parsed_batch = parse_options(7, batch);
+    REQUIRE(parsed_batch);
+    REQUIRE(parsed_batch->durability.mode == durability_mode::batch);
+    REQUIRE(parsed_batch->durability.sync_interval == 100U);
+
+    auto const parsed_per_file = parse_options(5, per_file);
+    REQUIRE(parsed_per_file);
+    REQUIRE(parsed_per_file->durability.mode == durability_mode::per_file);
+
+    REQUIRE(!parse_options(5, unknown));
+    REQUIRE(!parse_options(5, zero));
+    REQUIRE(!parse_options(6, to_stdout));
+    REQUIRE(!parse_options(5, verify));
+}
+
+TEST_CASE("parse_options reads the shard of the job handled by the process")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const sharded[] = {"asset_id", "--shard", "2/3", "data.txt", "out"};
+    char const* const too_large[] = {"asset_id", "--shard", "3/3", "data.txt", "out"};
+    char const* const no_count[] = {"asset_id", "--shard", "1", "data.txt", "out"};
+    char const* const zero[] = {"asset_id", "--shard", "0/0", "data.txt", "out"};
+    char const* const sheet[] = {"asset_id", "--shard", "0/2", "--sheet", "4", "data.txt", "out"};
+    char const* const verify[] = {"asset_id", "--shard", "0/2", "--verify", "out"};
+
+    auto const parsed_plain = parse_options(3, plain);
+    REQUIRE(parsed_plain->shard.index == 0U);
+    REQUIRE(parsed_plain->shard.count == 1U);
+
+    auto const parsed = parse_options(5, sharded);
+    REQUIRE(parsed);
+    REQUIRE(parsed->shard.index == 2U);
+    REQUIRE(parsed->shard.count == 3U);
+    REQUIRE(parsed->shard.owns_id(1337U));
+    REQUIRE(!parsed->shard.owns_id(1336U));
+    REQUIRE(parsed->shard.owns_line(3U));
+
+    REQUIRE(!parse_options(5, too_large));
+    REQUIRE(!parse_options(5, no_count));
+    REQUIRE(!parse_options(5, zero));
+    REQUIRE(!parse_options(7, sheet));
+    REQUIRE(!parse_options(5, verify));
+}
+
+TEST_CASE("parse_options reads the output backend")
+{
+    char const* const plain[] = {"asset_id", "data.txt", "out"};
+    char const* const direct[] = {"asset_id", "--output-backend", "direct", "data.txt", "out"};
+    char const* const uring[] = {"asset_id", "--output-backend", "io_uring", "data.txt", "out"};
+    char const* const unknown[] = {"asset_id", "--output-backend", "stdio", "data.txt", "out"};
+
+    REQUIRE(parse_options(3, plain)->output == output_backend::direct);
+    REQUIRE(parse_options(5, direct)->output == output_backend::direct);
+    REQUIRE(parse_options(5, uring)->output == output_backend::io_uring);
+    REQUIRE(!parse_options(5, unknown));
+}
@@ -0,0 +1,223 @@
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+#include "output_sink.h"
+#include "test_helpers.h"
+#include "uring_sink.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that builds one output item per id in `stems`; the items refer to the
+ * strings in `stems`, which must outlive them.
+ */
+std::vector<output_item> make_items(std::vector<std::string> const& stems)
+{
+    std::vector<output_item> items{};
+    for (auto const& stem: stems)
+    {
+        auto const asset_id = create_asset_id(stem);
+        REQUIRE(asset_id);
+        items.push_back({stem, &lookup_rendered_id(*asset_id), false, false});
+    }
+    return items;
+}
+} // namespace
+
+TEST_CASE("directory_sink writes the builtin encoding of each item")
+{
+    auto const dir = make_temp_dir("sink_directory");
+    auto const stems = std::vector<std::string>{"1337", "0000", "9999"};
+    auto items = make_items(stems);
+
+    auto sink = directory_sink{dir, png_backend::builtin};
+    REQUIRE(sink.is_concurrent());
+    sink.write(items.data(), items.size());
+
+    for (auto const& item: items)
+    {
+        REQUIRE(item.written);
+
+        auto const encoded = encode_png(item.rendered->pixels);
+        auto const expected = std::string(encoded.begin(), encoded.end());
+        REQUIRE(read_file(dir / (std::string{item.file_stem} + ".png")) == expected);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("incremental directory_sink only rewrites files that differ")
+{
+    auto const dir = make_temp_dir("sink_incremental");
+    auto const stems = std::vector<std::string>{"1337", "0042"};
+    auto items = make_items(stems);
+
+    auto sink = directory_sink{dir, png_backend::builtin};
+    sink.write(items.data(), items.size());
+
+    // Corrupt one of the files; the other one must be left untouched.
+    auto const corrupted = dir / "0042.png";
+    std::ofstream(corrupted, std::ios::binary) << "not a png";
+    auto const untouched_time = std::filesystem::last_write_time(dir / "1337.png") -
+                                std::chrono::hours{1};
+    std::filesystem::last_write_time(dir / "1337.png", untouched_time);
+
+    auto incremental_items = make_items(stems);
+    auto incremental_sink = directory_sink{dir, png_backend::builtin, true};
+    incremental_sink.write(incremental_items.data(), incremental_items.size());
+
+    REQUIRE(incremental_items[0].written);
+    REQUIRE(incremental_items[0].unchanged);
+    REQUIRE(std::filesystem::last_write_time(dir / "1337.png") == untouched_time);
+
+    REQUIRE(incremental_items[1].written);
+    REQUIRE(!incremental_items[1].unchanged);
+    auto const encoded = encode_png(incremental_items[1].rendered->pixels);
+    REQUIRE(read_file(corrupted) == std::string(encoded.begin(), encoded.end()));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("directory_sink reports items it cannot write")
+{
+    auto const stems = std::vector<std::string>{"1337"};
+    auto items = make_items(stems);
+
+    auto sink = directory_sink{"/unknown_dir", png_backend::builtin};
+    sink.write(items.data(), items.size());
+
+    REQUIRE(!items[0].written);
+}
+
+TEST_CASE("io_uring sink, when available, writes the same files as directory_sink")
+{
+    auto const uring_dir = make_temp_dir("sink_uring");
+    auto const direct_dir = make_temp_dir("sink_direct");
+
+    // More files than the queue depth, so several windows are submitted.
+    auto stems = std::vector<std::string>{};
+    for (auto value = 1000U; value < 1100U; ++value)
+    {
+        stems.push_back(std::to_string(value));
+    }
+
+    auto const sink = make_uring_sink(uring_dir, 16U, false);
+#if !ASSET_ID_WITH_IO_URING
+    REQUIRE(!sink);
+#endif
+
+    if (sink)
+    {
+        REQUIRE(!sink->is_concurrent());
+
+        auto uring_items = make_items(stems);
+        sink->write(uring_items.data(), uring_items.size());
+
+        auto direct_items = make_items(stems);
+        auto direct_sink = directory_sink{direct_dir, png_backend::builtin};
+        direct_sink.write(direct_items.data(), direct_items.size());
+
+        for (auto const& stem: stems)
+        {
+            auto const name = stem + ".png";
+            REQUIRE(read_file(uring_dir / name) == read_file(direct_dir / name));
+        }
+
+        for (auto const& item: uring_items)
+        {
+            REQUIRE(item.written);
+        }
+    }
+
+    std::filesystem::remove_all(uring_dir);
+    std::filesystem::remove_all(direct_dir);
+}
+
+TEST_CASE("io_uring sink, when available, replaces files at once and leaves no temporary file")
+{
+    auto const dir = make_temp_dir("sink_uring_replace");
+    std::ofstream(dir / "1000.png", std::ios::binary) << "old";
+    std::filesystem::create_directory(dir / "1001.png");
+
+    auto const stems = std::vector<std::string>{"1000", "1001", "1002"};
+    auto items = make_items(stems);
+    auto const sink = make_uring_sink(dir, 2U, false);
+    if (!sink)
+    {
+        WARN("io_uring is not available; skipped");
+        std::filesystem::remove_all(dir);
+        return;
+    }
+    sink->write(items.data(), items.size());
+
+    // A file is renamed over the old one, and a file that cannot be renamed into place is
+    // reported without disturbing the others.
+    auto const encoded = encode_png(items[0].rendered->pixels);
+    REQUIRE(items[0].written);
+    REQUIRE(read_file(dir / "1000.png") == std::string(encoded.begin(), encoded.end()));
+    REQUIRE(!items[1].written);
+    REQUIRE(std::filesystem::is_directory(dir / "1001.png"));
+    REQUIRE(items[2].written);
+
+    auto num_entries = 0U;
+    for (auto const& entry: std::filesystem::directory_iterator{dir})
+    {
+        REQUIRE(entry.path().filename().string().front() != '.');
+        ++num_entries;
+    }
+    REQUIRE(num_entries == 3U);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("io_uring sink, when available, keeps waiting when a signal interrupts it")
+{
+    auto const dir = make_temp_dir("sink_uring_signal");
+    auto stems = std::vector<std::string>{};
+    for (auto value = 1000U; value < 1400U; ++value)
+    {
+        stems.push_back(std::to_string(value));
+    }
+    auto items = make_items(stems);
+
+    auto const sink = make_uring_sink(dir, 8U, false, {durability_mode::per_file});
+    if (!sink)
+    {
+        WARN("io_uring is not available; skipped");
+        std::filesystem::remove_all(dir);
+        return;
+    }
+
+    // A frequent timer whose handler does not restart system calls interrupts the waits for
+    // completions, and the fsync of every file keeps them waiting long enough to be hit. The
+    // signals also make the kernel cancel chains whose worker thread they interrupt.
+    struct sigaction action{};
+    action.sa_handler = [](int) {};
+    struct sigaction previous{};
+    REQUIRE(sigaction(SIGALRM, &action, &previous) == 0);
+    auto const interval = itimerval{{0, 50}, {0, 50}};
+    REQUIRE(setitimer(ITIMER_REAL, &interval, nullptr) == 0);
+
+    sink->write(items.data(), items.size());
+
+    auto const stop = itimerval{};
+    setitimer(ITIMER_REAL, &stop, nullptr);
+    sigaction(SIGALRM, &previous, nullptr);
+
+    for (auto const& item: items)
+    {
+        REQUIRE(item.written);
+    }
+    REQUIRE(sink->finish());
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,179 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "id_table.h"
+#include "png_decoder.h"
+#include "png_encoder.h"
+#include "test_helpers.h"
+#include "write_png.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+void put_u32(std::vector<std::uint8_t>& bytes, std::uint32_t const value)
+{
+    for (auto shift = 24; shift >= 0; shift -= 8)
+    {
+        bytes.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void put_chunk(
+    std::vector<std::uint8_t>& bytes, char const (&tag)[5], std::vector<std::uint8_t> const& data
+)
+{
+    put_u32(bytes, static_cast<std::uint32_t>(data.size()));
+    auto const start = bytes.size();
+    bytes.insert(bytes.end(), tag, tag + 4);
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    put_u32(bytes, ~crc32_update(0xFFFFFFFFU, bytes.data() + start, 4U + data.size()));
+}
+
+/**
+ * @brief A test helper that builds a png file from an already filtered scanline, split into a
+ * stored deflate block per `block_size` bytes, with an ancillary chunk before the image data.
+ */
+std::vector<std::uint8_t> make_png(
+    std::vector<std::uint8_t> const& scanline,
+    std::size_t const block_size,
+    std::vector<std::uint8_t> const& ihdr = {0, 0, 1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0}
+)
+{
+    std::vector<std::uint8_t> bytes{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    put_chunk(bytes, "IHDR", ihdr);
+    put_chunk(bytes, "tEXt", {'a', 0, 'b'});
+
+    std::vector<std::uint8_t> stream{0x78, 0x01};
+    for (auto start = std::size_t{0U}; start < scanline.size(); start += block_size)
+    {
+        auto const length = std::min(block_size, scanline.size() - start);
+        stream.push_back((start + length == scanline.size()) ? 1U : 0U);
+        stream.push_back(static_cast<std::uint8_t>(length));
+        stream.push_back(static_cast<std::uint8_t>(length >> 8U));
+        stream.push_back(static_cast<std::uint8_t>(~length));
+        stream.push_back(static_cast<std::uint8_t>(~length >> 8U));
+        stream.insert(stream.end(), scanline.begin() + start, scanline.begin() + start + length);
+    }
+    put_u32(stream, adler32(scanline.data(), scanline.size()));
+
+    put_chunk(bytes, "IDAT", stream);
+    put_chunk(bytes, "IEND", {});
+    return bytes;
+}
+
+/**
+ * @brief A test helper holding the unfiltered scanline of an image line: the pixels inverted,
+ * after a `None` filter byte.
+ */
+std::vector<std::uint8_t> raw_scanline(image_line_t const& pixels)
+{
+    std::vector<std::uint8_t> scanline{0U};
+    for (auto const byte: pixels)
+    {
+        scanline.push_back(static_cast<std::uint8_t>(~byte));
+    }
+    return scanline;
+}
+} // namespace
+
+TEST_CASE("decode_png reverses encode_png for every id")
+{
+    for (auto number = 0U; number < num_asset_ids(); ++number)
+    {
+        auto const& pixels = lookup_rendered_id(number).pixels;
+        auto const encoded = encode_png(pixels);
+        auto const decoded = decode_png(encoded.data(), encoded.size());
+        INFO("id " << number);
+        REQUIRE(decoded);
+        REQUIRE(*decoded == pixels);
+    }
+}
+
+TEST_CASE("decode_png undoes every scanline filter, across several stored blocks")
+{
+    auto const& pixels = lookup_rendered_id(1337U).pixels;
+    auto const raw = raw_scanline(pixels);
+
+    auto sub = raw;
+    auto average = raw;
+    sub[0] = 1U;
+    average[0] = 3U;
+    for (auto index = std::size_t{2U}; index < raw.size(); ++index)
+    {
+        sub[index] = static_cast<std::uint8_t>(raw[index] - raw[index - 1U]);
+        average[index] = static_cast<std::uint8_t>(raw[index] - raw[index - 1U] / 2U);
+    }
+    auto paeth = sub;
+    paeth[0] = 4U;
+    auto up = raw;
+    up[0] = 2U;
+
+    for (auto const& scanline: {raw, sub, up, average, paeth})
+    {
+        auto const file = make_png(scanline, 10U);
+        auto const decoded = decode_png(file.data(), file.size());
+        INFO("filter " << int{scanline[0]});
+        REQUIRE(decoded);
+        REQUIRE(*decoded == pixels);
+    }
+}
+
+TEST_CASE("decode_png rejects malformed files")
+{
+    auto const& pixels = lookup_rendered_id(42U).pixels;
+    auto const encoded = encode_png(pixels);
+    auto const valid = std::vector<std::uint8_t>(encoded.begin(), encoded.end());
+
+    auto const corrupt = [](std::vector<std::uint8_t> const& bytes)
+    { return decode_png(bytes.data(), bytes.size()).error() == error_code::corrupt_png; };
+
+    for (auto size = std::size_t{0U}; size < valid.size(); size += 7U)
+    {
+        INFO("truncated to " << size);
+        REQUIRE(corrupt(std::vector<std::uint8_t>(valid.begin(), valid.begin() + size)));
+    }
+
+    // A flipped pixel no longer matches the chunk crc.
+    auto flipped = valid;
+    flipped[50] ^= 1U;
+    REQUIRE(corrupt(flipped));
+
+    auto trailing = valid;
+    trailing.push_back(0U);
+    REQUIRE(corrupt(trailing));
+
+    // Well formed files with the wrong geometry, filter or length of image data.
+    auto const raw = raw_scanline(pixels);
+    REQUIRE(corrupt(make_png(raw, 64U, {0, 0, 1, 0, 0, 0, 0, 2, 1, 0, 0, 0, 0})));
+    REQUIRE(corrupt(make_png(raw, 64U, {0, 0, 1, 0, 0, 0, 0, 1, 8, 0, 0, 0, 0})));
+    auto bad_filter = raw;
+    bad_filter[0] = 5U;
+    REQUIRE(corrupt(make_png(bad_filter, 64U)));
+    REQUIRE(corrupt(make_png(std::vector<std::uint8_t>(raw.begin(), raw.end() - 1), 64U)));
+}
+
+#if ASSET_ID_WITH_LIBPNG
+TEST_CASE("decode_png reads the compressed files written through libpng")
+{
+    auto const path = unique_temp_path("png_decoder_tests.png");
+    auto const& pixels = lookup_rendered_id(9876U).pixels;
+    REQUIRE(write_as_png(pixels, path, png_backend::libpng));
+
+    auto const bytes = read_file(path);
+    auto const decoded =
+        decode_png(reinterpret_cast<std::uint8_t const*>(bytes.data()), bytes.size());
+
+#if ASSET_ID_WITH_ZLIB
+    REQUIRE(decoded);
+    REQUIRE(*decoded == pixels);
+#else
+    REQUIRE(decoded.error() == error_code::backend_unavailable);
+#endif
+
+    std::filesystem::remove(path);
+}
+#endif
@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "png_encoder.h"
+#include "test_helpers.h"
+#include "write_png.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+TEST_CASE("CRC-32 and Adler-32 match their published check values")
+{
+    std::string const check = "123456789";
+    auto const* const data = reinterpret_cast<std::uint8_t const*>(check.data());
+
+    REQUIRE(~crc32_update(0xFFFFFFFFU, data, check.size()) == 0xCBF43926U);
+    REQUIRE(adler32(data, check.size()) == 0x091E01DEU);
+}
+
+TEST_CASE("Builtin encoder renders set bits as black pixels")
+{
+    auto line = image_line_t{};
+    line[0] = 0b10000001;
+
+    auto const encoded = encode_png(line);
+    auto const pixels = decode(encoded.data(), encoded.size());
+    REQUIRE(pixels.size() == image_line_width_pixels);
+
+    REQUIRE(pixels[0] == 0U);
+    REQUIRE(pixels[1] == 255U);
+    REQUIRE(pixels[7] == 0U);
+    REQUIRE(pixels[8] == 255U);
+}
+
+#if ASSET_ID_WITH_LIBPNG
+TEST_CASE("Builtin encoder decodes to the same pixels as the libpng backend")
+{
+    auto const path = unique_temp_path("png_encoder_tests.png");
+
+    for (auto value = 0U; value < 10000U; value += 37U)
+    {
+        auto id_string = std::to_string(value);
+        id_string.insert(0U, 4U - id_string.size(), '0');
+
+        auto const asset_id = create_asset_id(id_string);
+        REQUIRE(asset_id);
+
+        auto const checked = create_checked_asset_id(*asset_id);
+        REQUIRE(checked);
+
+        auto const encoded = encode_as_png(*checked);
+        REQUIRE(encoded);
+
+        REQUIRE(write_as_png(*checked, path, png_backend::libpng));
+
+        auto const builtin_pixels = decode(encoded->data(), encoded->size());
+        REQUIRE(builtin_pixels.size() == image_line_width_pixels);
+        REQUIRE(builtin_pixels == decode_file(path));
+    }
+
+    std::filesystem::remove(path);
+}
+#endif
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "id_table.h"
+#include "render_batch.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper holding the checked ids `first` onwards.
+ */
+std::vector<checked_asset_id_t> checked_ids_from(std::uint32_t const first, std::size_t const count)
+{
+    std::vector<checked_asset_id_t> checked_ids{};
+    for (auto index = std::size_t{0U}; index < count; ++index)
+    {
+        auto const number = first + static_cast<std::uint32_t>(index);
+        checked_ids.push_back(lookup_rendered_id(number).checked_id);
+    }
+    return checked_ids;
+}
+
+/**
+ * @brief A test helper that renders `checked_ids` with a kernel, `offset` bytes into an aligned
+ * buffer, and checks every line against `create_image_line`.
+ */
+void require_matches_create_image_line(
+    std::vector<checked_asset_id_t> const& checked_ids,
+    simd_level const level,
+    std::size_t const offset
+)
+{
+    struct alignas(image_line_alignment) aligned_block
+    {
+        image_line_t lines[64];
+    };
+
+    // Filled with a pattern so that lines which are not written in full are caught.
+    std::vector<aligned_block> blocks(checked_ids.size() / 64U + 2U);
+    for (auto& block: blocks)
+    {
+        for (auto& line: block.lines)
+        {
+            line.fill(0xa5U);
+        }
+    }
+
+    auto* const lines =
+        reinterpret_cast<image_line_t*>(reinterpret_cast<std::uint8_t*>(blocks.data()) + offset);
+    render_image_lines(checked_ids.data(), checked_ids.size(), lines, level);
+
+    for (auto index = std::size_t{0U}; index < checked_ids.size(); ++index)
+    {
+        auto const expected = create_image_line(checked_ids[index], image_line_start_byte);
+        REQUIRE(expected);
+        INFO("line " << index);
+        REQUIRE(lines[index] == *expected);
+    }
+}
+} // namespace
+
+TEST_CASE("Every supported render kernel matches create_image_line for all ids")
+{
+    auto const checked_ids = checked_ids_from(0U, num_asset_ids());
+    for (auto const level: supported_levels())
+    {
+        require_matches_create_image_line(checked_ids, level, 0U);
+    }
+}
+
+TEST_CASE("Render kernels handle unaligned output and short blocks")
+{
+    for (auto const level: supported_levels())
+    {
+        for (auto const count: {0U, 1U, 2U, 3U, 4U, 5U, 17U})
+        {
+            auto const checked_ids = checked_ids_from(9990U - count, count);
+            require_matches_create_image_line(checked_ids, level, 0U);
+            require_matches_create_image_line(checked_ids, level, 8U);
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "ring_queue.h"
+
+using namespace asset_id;
+
+TEST_CASE("spmc_ring hands out values in order and refuses to overfill")
+{
+    auto ring = spmc_ring<int, 4U>{};
+
+    auto value = 0;
+    REQUIRE(!ring.try_pop(value));
+
+    for (auto index = 0; index < 4; ++index)
+    {
+        REQUIRE(ring.try_push(index));
+    }
+    REQUIRE(!ring.try_push(4));
+
+    REQUIRE(ring.try_pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(ring.try_push(4));
+
+    for (auto expected = 1; expected <= 4; ++expected)
+    {
+        REQUIRE(ring.try_pop(value));
+        REQUIRE(value == expected);
+    }
+    REQUIRE(!ring.try_pop(value));
+}
+
+TEST_CASE("spmc_ring pop drains the values pushed before close, then stops")
+{
+    auto ring = spmc_ring<int, 8U>{};
+    ring.push(7);
+    ring.close();
+
+    auto value = 0;
+    REQUIRE(ring.pop(value));
+    REQUIRE(value == 7);
+    REQUIRE(!ring.pop(value));
+}
+
+TEST_CASE("spmc_ring wakes a consumer and a producer that have gone to sleep")
+{
+    auto ring = spmc_ring<int, 2U>{};
+
+    // Long enough for the waiting side to give up yielding and sleep.
+    auto const asleep = std::chrono::milliseconds{50};
+
+    auto popped = 0;
+    auto consumer = std::thread{[&ring, &popped]() { ring.pop(popped); }};
+    std::this_thread::sleep_for(asleep);
+    ring.push(1);
+    consumer.join();
+    REQUIRE(popped == 1);
+
+    ring.push(2);
+    ring.push(3);
+    auto pushed = std::atomic<bool>{false};
+    auto producer = std::thread{
+        [&ring, &pushed]()
+        {
+            ring.push(4);
+            pushed = true;
+        }
+    };
+    std::this_thread::sleep_for(asleep);
+    REQUIRE(!pushed);
+
+    auto value = 0;
+    REQUIRE(ring.pop(value));
+    producer.join();
+    REQUIRE(pushed);
+
+    ring.close();
+    for (auto expected = 3; expected <= 4; ++expected)
+    {
+        REQUIRE(ring.pop(value));
+        REQUIRE(value == expected);
+    }
+    REQUIRE(!ring.pop(value));
+}
+
+TEST_CASE("spmc_ring gives every value to exactly one of several consumers")
+{
+    constexpr auto const num_values = std::size_t{100000U};
+    constexpr auto const num_consumers = 4U;
+
+    // A small ring keeps the producer waiting on the consumers for most of the test.
+    auto ring = spmc_ring<std::size_t, 16U>{};
+    std::vector<std::atomic<unsigned>> taken(num_values);
+
+    std::vector<std::thread> consumers{};
+    for (auto consumer = 0U; consumer < num_consumers; ++consumer)
+    {
+        consumers.emplace_back(
+            [&]()
+            {
+                auto value = std::size_t{0U};
+                auto previous = std::size_t{0U};
+                auto first = true;
+                while (ring.pop(value))
+                {
+                    // Each consumer sees the values it takes in the order they were pushed.
+                    if (!first && (value <= previous))
+                    {
+                        taken[value] += num_values;
+                    }
+                    taken[value] += 1U;
+                    previous = value;
+                    first = false;
+                }
+            }
+        );
+    }
+
+    for (auto value = std::size_t{0U}; value < num_values; ++value)
+    {
+        ring.push(value);
+    }
+    ring.close();
+
+    for (auto& consumer: consumers)
+    {
+        consumer.join();
+    }
+
+    auto num_wrong = std::size_t{0U};
+    for (auto const& count: taken)
+    {
+        num_wrong += (count.load() == 1U) ? 0U : 1U;
+    }
+    REQUIRE(num_wrong == 0U);
+}
@@ -0,0 +1,173 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "png_encoder.h"
+#include "sheet_sink.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+#if ASSET_ID_WITH_ZLIB
+/**
+ * @brief A test helper holding the decoded pixels of the single png file of an id.
+ */
+std::vector<std::uint8_t> decode_id(std::uint32_t const number)
+{
+    auto const encoded = encode_png(lookup_rendered_id(number).pixels);
+    return decode(encoded.data(), encoded.size());
+}
+#endif
+
+/**
+ * @brief A test helper that writes the ids in `input` into sheets of `rows_per_sheet` rows in
+ * an empty directory.
+ */
+std::filesystem::path write_sheets(std::string_view const input, unsigned const rows_per_sheet)
+{
+    auto const dir = make_temp_dir("sheet_sink");
+
+    auto settings = options{};
+    settings.jobs = 4U;
+
+    auto sink = sheet_sink{dir, rows_per_sheet};
+    auto const summary = process_batch(input, settings, sink);
+    REQUIRE(sink.finish() == sheets_available());
+    REQUIRE(summary.written == (sheets_available() ? 3U : 0U));
+
+    return dir;
+}
+} // namespace
+
+#if ASSET_ID_WITH_ZLIB
+TEST_CASE("sheet_sink writes the ids as the rows of sheets, in input order, with an index")
+{
+    auto const dir = write_sheets("1337\n12a4\n0042\n0001\n0042\n", 2U);
+
+    REQUIRE(read_file(dir / "sheet_00000.index") == "0\t1337\n1\t0042\n");
+    REQUIRE(read_file(dir / "sheet_00001.index") == "0\t0001\n");
+    REQUIRE(!std::filesystem::exists(dir / "sheet_00002.png"));
+
+    auto height = std::uint32_t{0U};
+    auto const first = decode_file(dir / "sheet_00000.png", &height);
+    REQUIRE(height == 2U);
+    REQUIRE(first.size() == 2U * image_line_width_pixels);
+
+    auto const row_1337 = decode_id(1337U);
+    auto const row_0042 = decode_id(42U);
+    REQUIRE(std::vector<std::uint8_t>(first.begin(), first.begin() + 256) == row_1337);
+    REQUIRE(std::vector<std::uint8_t>(first.begin() + 256, first.end()) == row_0042);
+
+    auto const second = decode_file(dir / "sheet_00001.png", &height);
+    REQUIRE(height == 1U);
+    REQUIRE(second == decode_id(1U));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("sheet_sink only moves a sheet and its index into place once the sheet is complete")
+{
+    auto const dir = make_temp_dir("sheet_sink");
+
+    auto const stems = std::vector<std::string>{"1337", "0042", "0001"};
+    std::vector<output_item> items{};
+    for (auto const& stem: stems)
+    {
+        items.push_back({stem, &lookup_rendered_id(*create_asset_id(stem)), false, false});
+    }
+
+    auto sink = sheet_sink{dir, 2U};
+    sink.write(items.data(), 1U);
+    REQUIRE(std::filesystem::is_empty(dir));
+
+    sink.write(items.data() + 1U, 2U);
+    REQUIRE(std::filesystem::exists(dir / "sheet_00000.png"));
+    REQUIRE(std::filesystem::exists(dir / "sheet_00000.index"));
+    REQUIRE(!std::filesystem::exists(dir / "sheet_00001.png"));
+
+    REQUIRE(sink.finish());
+    auto const entries = std::filesystem::directory_iterator(dir);
+    REQUIRE(std::distance(begin(entries), end(entries)) == 4);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("sheet_sink reports the rows of a sheet that cannot be completed as failed")
+{
+    auto const dir = make_temp_dir("sheet_sink");
+
+    auto const stems = std::vector<std::string>{"1337", "0042", "0001"};
+    std::vector<output_item> items{};
+    for (auto const& stem: stems)
+    {
+        items.push_back({stem, &lookup_rendered_id(*create_asset_id(stem)), false, false});
+    }
+
+    auto sink = sheet_sink{dir, 2U};
+    sink.write(items.data(), items.size());
+    for (auto const& item: items)
+    {
+        REQUIRE(item.deferred);
+        REQUIRE(!item.written);
+    }
+
+    // The first sheet is complete; the second can no longer be moved into place.
+    std::filesystem::remove_all(dir);
+    sink.settle_all();
+
+    auto outcomes = std::vector<deferred_outcome>{};
+    sink.take_settled(outcomes);
+    REQUIRE(outcomes.size() == 2U);
+    REQUIRE(outcomes[0].num_items == 2U);
+    REQUIRE(outcomes[0].written);
+    REQUIRE(outcomes[1].num_items == 1U);
+    REQUIRE(!outcomes[1].written);
+    REQUIRE(!sink.finish());
+}
+
+TEST_CASE("sheet_sink compresses every id into a single sheet far smaller than the pngs")
+{
+    std::string input{};
+    for (auto number = 0U; number < num_asset_ids(); ++number)
+    {
+        auto text = std::to_string(number);
+        input += std::string(4U - text.size(), '0') + text + "\n";
+    }
+
+    auto const dir = make_temp_dir("sheet_sink");
+
+    auto sink = sheet_sink{dir, num_asset_ids()};
+    auto const summary = process_batch(input, options{}, sink);
+    REQUIRE(sink.finish());
+    REQUIRE(summary.written == num_asset_ids());
+
+    auto const path = dir / "sheet_00000.png";
+    REQUIRE(std::filesystem::file_size(path) < num_asset_ids() * encoded_png_num_bytes / 10U);
+
+    auto height = std::uint32_t{0U};
+    auto const pixels = decode_file(path, &height);
+    REQUIRE(height == num_asset_ids());
+    for (auto number = 0U; number < num_asset_ids(); number += 97U)
+    {
+        auto const* const row = pixels.data() + number * image_line_width_pixels;
+        INFO("row " << number);
+        REQUIRE(std::vector<std::uint8_t>(row, row + image_line_width_pixels) == decode_id(number));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+#else
+TEST_CASE("sheet_sink reports every id as unavailable without zlib")
+{
+    auto const dir = write_sheets("1337\n0042\n0001\n", 2U);
+    REQUIRE(!std::filesystem::exists(dir / "sheet_00000.png"));
+    std::filesystem::remove_all(dir);
+}
+#endif
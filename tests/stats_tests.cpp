@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <string>
+
+#include "stats.h"
+
+using namespace asset_id;
+
+namespace
+{
+/**
+ * @brief A test helper that enables stats from a clean slate and disables them again when a
+ * test ends.
+ */
+struct scoped_stats
+{
+    explicit scoped_stats(bool const enabled)
+    {
+        reset_stats();
+        enable_stats(enabled);
+    }
+
+    ~scoped_stats()
+    {
+        enable_stats(false);
+        reset_stats();
+    }
+};
+
+stage_stats const& stage_of(stats_snapshot const& stats, stats_stage const stage)
+{
+    return stats.stages[static_cast<std::size_t>(stage)];
+}
+
+std::uint64_t counter_of(stats_snapshot const& stats, stats_counter const counter)
+{
+    return stats.counters[static_cast<std::size_t>(counter)];
+}
+} // namespace
+
+TEST_CASE("Nothing is timed or counted while stats are disabled")
+{
+    auto const scope = scoped_stats{false};
+
+    {
+        auto const timer = stage_timer{stats_stage::encode};
+    }
+    add_count(stats_counter::bytes_written, 100U);
+
+    auto const stats = snapshot_stats();
+    REQUIRE(stage_of(stats, stats_stage::encode).calls == 0U);
+    REQUIRE(counter_of(stats, stats_counter::bytes_written) == 0U);
+}
+
+TEST_CASE("stage_timer records one call with its items while stats are enabled")
+{
+    auto const scope = scoped_stats{true};
+
+    {
+        auto timer = stage_timer{stats_stage::scan};
+        timer.set_items(42U);
+    }
+    {
+        auto const timer = stage_timer{stats_stage::scan, 8U};
+    }
+    add_count(stats_counter::lines, 50U);
+
+    auto const stats = snapshot_stats();
+    auto const& scan = stage_of(stats, stats_stage::scan);
+    REQUIRE(scan.calls == 2U);
+    REQUIRE(scan.items == 50U);
+    REQUIRE(scan.max_ns <= scan.total_ns);
+    REQUIRE(counter_of(stats, stats_counter::lines) == 50U);
+}
+
+TEST_CASE("record_stage sorts latencies into power of two buckets")
+{
+    auto const scope = scoped_stats{true};
+
+    record_stage(stats_stage::write, 0U);
+    record_stage(stats_stage::write, 1U);
+    record_stage(stats_stage::write, 1000U);
+    record_stage(stats_stage::write, 1023U);
+    record_stage(stats_stage::write, 1024U);
+
+    auto const stats = snapshot_stats();
+    auto const& write = stage_of(stats, stats_stage::write);
+    REQUIRE(write.calls == 5U);
+    REQUIRE(write.total_ns == 3048U);
+    REQUIRE(write.max_ns == 1024U);
+    REQUIRE(write.latency_buckets[0] == 1U);
+    REQUIRE(write.latency_buckets[1] == 1U);
+    REQUIRE(write.latency_buckets[10] == 2U);
+    REQUIRE(write.latency_buckets[11] == 1U);
+}
+
+TEST_CASE("write_stats_json reports every stage, counter and percentile")
+{
+    auto const scope = scoped_stats{true};
+
+    for (auto call = 0U; call < 99U; ++call)
+    {
+        record_stage(stats_stage::encode, 100U);
+    }
+    record_stage(stats_stage::encode, 100000U);
+    add_count(stats_counter::ids, 10U);
+
+    auto output = std::ostringstream{};
+    write_stats_json(output, snapshot_stats(), 2.0);
+    auto const json = output.str();
+
+    REQUIRE(json.find("\"ids\": 10,") != std::string::npos);
+    REQUIRE(json.find("\"ids_per_second\": 5,") != std::string::npos);
+    for (auto const* const stage: {"read", "scan", "render", "encode", "write", "sync", "finish"})
+    {
+        REQUIRE(json.find(std::string{"\""} + stage + "\": {") != std::string::npos);
+    }
+    REQUIRE(json.find("\"p50_ns\": 128, \"p99_ns\": 131072") != std::string::npos);
+    REQUIRE(json.find("{\"lt_ns\": 128, \"count\": 99}") != std::string::npos);
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "tar_sink.h"
+#include "test_helpers.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that writes an archive of the ids in `input` with `jobs` threads.
+ */
+std::string make_archive(
+    std::string_view const input, unsigned const jobs, durability_settings const& durability = {}
+)
+{
+    auto const path = unique_temp_path("tar_sink_tests.tar");
+
+    auto settings = options{};
+    settings.jobs = jobs;
+
+    auto sink = tar_sink::open(path, durability);
+    REQUIRE(sink);
+    process_batch(input, settings, *sink);
+    REQUIRE(sink->finish());
+    sink.reset();
+
+    auto archive = read_file(path);
+    std::filesystem::remove(path);
+    return archive;
+}
+
+/**
+ * @brief A test helper that reads an octal field of a tar header.
+ */
+std::size_t read_octal(std::string const& archive, std::size_t const offset, std::size_t width)
+{
+    return std::strtoul(archive.substr(offset, width).c_str(), nullptr, 8);
+}
+} // namespace
+
+TEST_CASE("tar_sink writes one ustar entry per id, in input order")
+{
+    auto const archive = make_archive("1337\n12a4\n0042\n0001\n", 4U);
+
+    // Three entries of one header and one data block each, then the two block trailer.
+    REQUIRE(archive.size() == 8U * 512U);
+
+    auto const names = std::vector<std::string>{"1337.png", "0042.png", "0001.png"};
+    for (auto entry = std::size_t{0U}; entry < names.size(); ++entry)
+    {
+        auto const header = entry * 1024U;
+        REQUIRE(archive.substr(header, names[entry].size() + 1U) == names[entry] + '\0');
+        REQUIRE(archive.substr(header + 257U, 6U) == std::string("ustar\0", 6U));
+        REQUIRE(read_octal(archive, header + 124U, 11U) == encoded_png_num_bytes);
+        REQUIRE(read_octal(archive, header + 136U, 11U) == 0U);
+
+        auto checksum = std::size_t{0U};
+        for (auto index = std::size_t{0U}; index < 512U; ++index)
+        {
+            auto const in_field = (index >= 148U) && (index < 156U);
+            checksum += in_field ? ' ' : static_cast<unsigned char>(archive[header + index]);
+        }
+        REQUIRE(read_octal(archive, header + 148U, 6U) == checksum);
+
+        auto const asset_id = create_asset_id(names[entry].substr(0U, 4U));
+        REQUIRE(asset_id);
+        auto const encoded = encode_png(lookup_rendered_id(*asset_id).pixels);
+        REQUIRE(archive.substr(header + 512U, encoded.size()) ==
+                std::string(encoded.begin(), encoded.end()));
+    }
+
+    REQUIRE(archive.substr(3U * 1024U) == std::string(1024U, '\0'));
+}
+
+TEST_CASE("tar_sink archives are reproducible for any number of jobs")
+{
+    std::string input;
+    for (auto value = 0U; value < 10000U; value += 3U)
+    {
+        auto id = std::to_string(value);
+        input += std::string(4U - id.size(), '0') + id + "\n";
+    }
+
+    auto const serial = make_archive(input, 1U);
+    REQUIRE(serial.size() == (2U * 3334U + 2U) * 512U);
+    REQUIRE(serial == make_archive(input, 8U));
+}
+
+TEST_CASE("tar_sink archives are the same whatever their durability")
+{
+    auto const input = std::string_view{"1337\n0042\n0001\n"};
+    auto const plain = make_archive(input, 2U);
+
+    REQUIRE(make_archive(input, 2U, {durability_mode::batch, 2U}) == plain);
+    REQUIRE(make_archive(input, 2U, {durability_mode::per_file, 1U}) == plain);
+}
+
+TEST_CASE("tar_sink cannot be opened in a missing directory")
+{
+    REQUIRE(!tar_sink::open("/unknown_dir/out.tar"));
+}
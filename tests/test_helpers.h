@@ -0,0 +1,120 @@
+/**
+ * @file   test_helpers.h
+ * @brief  Helpers shared by the tests: uniquely named temporary paths, reading files back,
+ *         decoding png files with libpng and listing the SIMD kernels the host can run.
+ *
+ * ctest runs every test case in a process of its own, possibly several at once, so no two
+ * test cases may share a temporary path. Every path is therefore named after the process and a
+ * per-process counter as well as the test.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <png.h>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "checksum_batch.h"
+
+namespace asset_id::testing
+{
+/**
+ * @return std::filesystem::path holding a path in the temporary directory, named after `name`
+ *         and with its extension, that is used by no other call, nor by any other test
+ *         process. Nothing is created.
+ */
+inline std::filesystem::path unique_temp_path(std::string const& name)
+{
+    static std::atomic<unsigned> next_id{0U};
+    auto const file = std::filesystem::path{name};
+    return std::filesystem::temp_directory_path() /
+           ("asset_id_" + file.stem().string() + "_" + std::to_string(getpid()) + "_" +
+            std::to_string(next_id.fetch_add(1U)) + file.extension().string());
+}
+
+/**
+ * @return std::filesystem::path holding a new, empty and uniquely named directory; the test
+ *         removes it once done.
+ */
+inline std::filesystem::path make_temp_dir(std::string const& name)
+{
+    auto const dir = unique_temp_path(name);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+/**
+ * @return std::string holding the whole of a file as a string of bytes; empty if it cannot be
+ *         read.
+ */
+inline std::string read_file(std::filesystem::path const& path)
+{
+    auto stream = std::ifstream(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+/**
+ * @brief Decode a png file held in memory to one 8 bit grayscale value per pixel.
+ *
+ * @param height  when given, receives the height of the image.
+ *
+ * @return std::vector<std::uint8_t> holding the decoded pixels, or empty if libpng could not
+ *         decode the file (including any chunk crc or zlib checksum failure).
+ */
+inline std::vector<std::uint8_t>
+decode(std::uint8_t const* data, std::size_t const size, std::uint32_t* const height = nullptr)
+{
+    png_image image{};
+    image.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_memory(&image, data, size))
+    {
+        return {};
+    }
+
+    image.format = PNG_FORMAT_GRAY;
+    if (height != nullptr)
+    {
+        *height = image.height;
+    }
+    std::vector<std::uint8_t> pixels(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr))
+    {
+        return {};
+    }
+
+    return pixels;
+}
+
+/**
+ * @brief Decode the png file at `path`, as `decode` does for a file held in memory.
+ */
+inline std::vector<std::uint8_t>
+decode_file(std::filesystem::path const& path, std::uint32_t* const height = nullptr)
+{
+    auto const bytes = read_file(path);
+    return decode(reinterpret_cast<std::uint8_t const*>(bytes.data()), bytes.size(), height);
+}
+
+/**
+ * @return std::vector<simd_level> holding every SIMD kernel level the host can run, so that
+ *         each is tested, not only the best one.
+ */
+inline std::vector<simd_level> supported_levels()
+{
+    std::vector<simd_level> levels{};
+    for (auto const level: {simd_level::scalar, simd_level::sse2, simd_level::avx2})
+    {
+        if (is_supported(level))
+        {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+} // namespace asset_id::testing
@@ -0,0 +1,109 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "output_sink.h"
+#include "test_helpers.h"
+#include "verify.h"
+
+using namespace asset_id;
+using namespace asset_id::testing;
+
+namespace
+{
+/**
+ * @brief A test helper that checks the builtin encoding of `pixels` as the file of `stem`.
+ */
+result<void> verify_pixels(std::string_view const stem, image_line_t const& pixels)
+{
+    auto const encoded = encode_png(pixels);
+    return verify_png(stem, encoded.data(), encoded.size());
+}
+
+void write_bytes(std::filesystem::path const& path, std::string const& bytes)
+{
+    std::ofstream(path, std::ios::binary) << bytes;
+}
+} // namespace
+
+TEST_CASE("verify_png accepts the file of every id under its own name")
+{
+    for (auto number = 0U; number < num_asset_ids(); number += 13U)
+    {
+        auto const& rendered = lookup_rendered_id(number);
+        auto stem = std::to_string(number);
+        stem.insert(0U, 4U - stem.size(), '0');
+        INFO("id " << stem);
+        REQUIRE(verify_pixels(stem, rendered.pixels));
+    }
+}
+
+TEST_CASE("verify_png reports what is wrong with a file")
+{
+    auto const& pixels = lookup_rendered_id(1337U).pixels;
+
+    REQUIRE(verify_pixels("1338", pixels).error() == error_code::id_mismatch);
+    REQUIRE(verify_pixels("133", pixels).error() == error_code::bad_length);
+    REQUIRE(verify_pixels("13x7", pixels).error() == error_code::bad_digit);
+
+    // The first checksum digit is drawn as a different digit.
+    auto wrong_checksum = pixels;
+    wrong_checksum[image_line_start_byte] = (pixels[image_line_start_byte] == pixels_per_digit[0])
+                                                ? pixels_per_digit[1]
+                                                : pixels_per_digit[0];
+    REQUIRE(verify_pixels("1337", wrong_checksum).error() == error_code::checksum_mismatch);
+
+    auto smudged = pixels;
+    smudged[image_line_start_byte + 2U] ^= 0x08U;
+    REQUIRE(verify_pixels("1337", smudged).error() == error_code::unknown_segment);
+
+    auto stray = pixels;
+    stray.back() = 1U;
+    REQUIRE(verify_pixels("1337", stray).error() == error_code::unknown_segment);
+
+    auto const encoded = encode_png(pixels);
+    REQUIRE(verify_png("1337", encoded.data(), 60U).error() == error_code::corrupt_png);
+}
+
+TEST_CASE("verify_directory checks every png file in name order")
+{
+    auto const dir = make_temp_dir("verify_directory");
+
+    std::vector<std::string> const stems{"0001", "0002", "0003", "0004", "0005", "1337"};
+    auto sink = directory_sink{dir, png_backend::builtin};
+    for (auto const& stem: stems)
+    {
+        auto item = output_item{stem, &lookup_rendered_id(*create_asset_id(stem)), false, false};
+        sink.write(&item, 1U);
+        REQUIRE(item.written);
+    }
+
+    std::filesystem::copy_file(
+        dir / "0001.png", dir / "0003.png", std::filesystem::copy_options::overwrite_existing
+    );
+    write_bytes(dir / "0005.png", "not a png");
+    write_bytes(dir / "notes.txt", "not checked");
+    std::filesystem::create_directory(dir / "nested.png");
+
+    auto settings = options{};
+    settings.jobs = 3U;
+    settings.failure_samples = 1U;
+
+    auto stream = std::ostringstream{};
+    auto const summary = verify_directory(dir, settings, &stream);
+    REQUIRE(summary);
+    REQUIRE(summary->num_files == 6U);
+    REQUIRE(summary->num_failures == 2U);
+    REQUIRE(
+        summary->failures == std::vector<verify_failure>{{"0003.png", error_code::id_mismatch}}
+    );
+    REQUIRE(stream.str() == "0003.png\tid_mismatch\n0005.png\tcorrupt_png\n");
+    REQUIRE(summary->failures_by_error[static_cast<std::size_t>(error_code::corrupt_png)] == 1U);
+
+    std::filesystem::remove_all(dir);
+
+    REQUIRE(verify_directory(dir, settings).error() == error_code::io_error);
+}
@@ -1,6 +1,8 @@
 #include <catch2/catch.hpp>
+#include <fcntl.h>
 #include <png.h>
 
+#include "id_table.h"
 #include "write_png.h"
 
 using namespace asset_id;
@@ -13,7 +15,22 @@ TEST_CASE("Destination must be a png")
     auto const digits = create_checked_asset_id(*asset_id);
     REQUIRE(digits);
 
-    REQUIRE(!write_as_png(*digits, "/unkown_dir/7890.txt"));
+    auto const written = write_as_png(*digits, "/unkown_dir/7890.txt");
+    REQUIRE(!written);
+    REQUIRE(written.error() == error_code::bad_destination);
+}
+
+TEST_CASE("An unwritable destination is reported as an io error")
+{
+    auto const asset_id = create_asset_id("7890");
+    REQUIRE(asset_id);
+
+    auto const digits = create_checked_asset_id(*asset_id);
+    REQUIRE(digits);
+
+    auto const written = write_as_png(*digits, "/unkown_dir/7890.png");
+    REQUIRE(!written);
+    REQUIRE(written.error() == error_code::io_error);
 }
 
 TEST_CASE("libpng deallocators are null safe")
@@ -34,3 +51,11 @@ TEST_CASE("libpng deallocators are null safe")
 
     png_destroy_write_struct(&write_struct, nullptr);
 }
+
+TEST_CASE("A png written into an open directory must be named as a png")
+{
+    auto const& pixels = lookup_rendered_id(7890U).pixels;
+    auto const written = write_as_png(pixels, AT_FDCWD, "7890.txt");
+    REQUIRE(!written);
+    REQUIRE(written.error() == error_code::bad_destination);
+}